@@ -159,31 +159,32 @@ inline double distance_segment_to_segment_2d(const Eigen::Ref<const Eigen::Vecto
 /**
  * @brief Helper function to calculate the smallest distance between a point and a closed polygon
  * @param point 2D point
- * @param vertices Vertices describing the closed polygon (the first vertex is not repeated at the end)
+ * @param vertices Contiguous array of vertices describing the closed polygon (the first vertex is not repeated at the end)
+ * @param no_vertices Number of vertices
  * @return smallest distance between point and polygon
 */    
-inline double distance_point_to_polygon_2d(const Eigen::Vector2d& point, const Point2dContainer& vertices)
+inline double distance_point_to_polygon_2d(const Eigen::Vector2d& point, const Eigen::Vector2d* vertices, std::size_t no_vertices)
 {
   double dist = HUGE_VAL;
     
   // the polygon is a point
-  if (vertices.size() == 1)
+  if (no_vertices == 1)
   {
-    return (point - vertices.front()).norm();
+    return (point - vertices[0]).norm();
   }
     
   // check each polygon edge
-  for (int i=0; i<(int)vertices.size()-1; ++i)
+  for (int i=0; i<(int)no_vertices-1; ++i)
   {
-      double new_dist = distance_point_to_segment_2d(point, vertices.at(i), vertices.at(i+1));
+      double new_dist = distance_point_to_segment_2d(point, vertices[i], vertices[i+1]);
 //       double new_dist = calc_distance_point_to_segment( position,  vertices.at(i), vertices.at(i+1));
       if (new_dist < dist)
         dist = new_dist;
   }
 
-  if (vertices.size()>2) // if not a line close polygon
+  if (no_vertices>2) // if not a line close polygon
   {
-    double new_dist = distance_point_to_segment_2d(point, vertices.back(), vertices.front()); // check last edge
+    double new_dist = distance_point_to_segment_2d(point, vertices[no_vertices-1], vertices[0]); // check last edge
     if (new_dist < dist)
       return new_dist;
   }
@@ -191,35 +192,47 @@ inline double distance_point_to_polygon_2d(const Eigen::Vector2d& point, const P
   return dist;
 }  
 
+/**
+ * @brief Helper function to calculate the smallest distance between a point and a closed polygon
+ * @param point 2D point
+ * @param vertices Vertices describing the closed polygon (the first vertex is not repeated at the end)
+ * @return smallest distance between point and polygon
+*/    
+inline double distance_point_to_polygon_2d(const Eigen::Vector2d& point, const Point2dContainer& vertices)
+{
+  return distance_point_to_polygon_2d(point, vertices.empty() ? NULL : &vertices.front(), vertices.size());
+}
+
 /**
  * @brief Helper function to calculate the smallest distance between a line segment and a closed polygon
  * @param line_start 2D point representing the start of the line segment
  * @param line_end 2D point representing the end of the line segment
- * @param vertices Vertices describing the closed polygon (the first vertex is not repeated at the end)
+ * @param vertices Contiguous array of vertices describing the closed polygon (the first vertex is not repeated at the end)
+ * @param no_vertices Number of vertices
  * @return smallest distance between point and polygon
 */    
-inline double distance_segment_to_polygon_2d(const Eigen::Vector2d& line_start, const Eigen::Vector2d& line_end, const Point2dContainer& vertices)
+inline double distance_segment_to_polygon_2d(const Eigen::Vector2d& line_start, const Eigen::Vector2d& line_end, const Eigen::Vector2d* vertices, std::size_t no_vertices)
 {
   double dist = HUGE_VAL;
     
   // the polygon is a point
-  if (vertices.size() == 1)
+  if (no_vertices == 1)
   {
-    return distance_point_to_segment_2d(vertices.front(), line_start, line_end);
+    return distance_point_to_segment_2d(vertices[0], line_start, line_end);
   }
     
   // check each polygon edge
-  for (int i=0; i<(int)vertices.size()-1; ++i)
+  for (int i=0; i<(int)no_vertices-1; ++i)
   {
-      double new_dist = distance_segment_to_segment_2d(line_start, line_end, vertices.at(i), vertices.at(i+1));
+      double new_dist = distance_segment_to_segment_2d(line_start, line_end, vertices[i], vertices[i+1]);
 //       double new_dist = calc_distance_point_to_segment( position,  vertices.at(i), vertices.at(i+1));
       if (new_dist < dist)
         dist = new_dist;
   }
 
-  if (vertices.size()>2) // if not a line close polygon
+  if (no_vertices>2) // if not a line close polygon
   {
-    double new_dist = distance_segment_to_segment_2d(line_start, line_end, vertices.back(), vertices.front()); // check last edge
+    double new_dist = distance_segment_to_segment_2d(line_start, line_end, vertices[no_vertices-1], vertices[0]); // check last edge
     if (new_dist < dist)
       return new_dist;
   }
@@ -227,6 +240,18 @@ inline double distance_segment_to_polygon_2d(const Eigen::Vector2d& line_start,
   return dist;
 }
 
+/**
+ * @brief Helper function to calculate the smallest distance between a line segment and a closed polygon
+ * @param line_start 2D point representing the start of the line segment
+ * @param line_end 2D point representing the end of the line segment
+ * @param vertices Vertices describing the closed polygon (the first vertex is not repeated at the end)
+ * @return smallest distance between point and polygon
+*/    
+inline double distance_segment_to_polygon_2d(const Eigen::Vector2d& line_start, const Eigen::Vector2d& line_end, const Point2dContainer& vertices)
+{
+  return distance_segment_to_polygon_2d(line_start, line_end, vertices.empty() ? NULL : &vertices.front(), vertices.size());
+}
+
 /**
  * @brief Helper function to calculate the smallest distance between two closed polygons
  * @param vertices1 Vertices describing the first closed polygon (the first vertex is not repeated at the end)
@@ -51,6 +51,7 @@
 #include <teb_local_planner/g2o_types/vertex_pose.h>
 #include <teb_local_planner/g2o_types/vertex_timediff.h>
 #include <teb_local_planner/g2o_types/penalties.h>
+#include <teb_local_planner/g2o_types/edge_kernels.h>
 #include <teb_local_planner/teb_config.h>
 
 #include "g2o/core/base_multi_edge.h"
@@ -82,7 +83,7 @@ namespace teb_local_planner {
  * @remarks Refer to EdgeAccelerationStart() and EdgeAccelerationGoal() for
  * defining boundary values!
  */
-class EdgeAcceleration : public g2o::BaseMultiEdge<2, double> {
+class EdgeAcceleration : public BaseTebMultiEdge<2, double> {
 public:
   /**
    * @brief Construct edge.
@@ -122,35 +123,21 @@ public:
         static_cast<const VertexTimeDiff *>(_vertices[4]);
 
     // VELOCITY & ACCELERATION
-    Eigen::Vector2d diff1 = pose2->position() - pose1->position();
-    Eigen::Vector2d diff2 = pose3->position() - pose2->position();
-    double vel1 = diff1.norm() / dt1->dt();
-    double vel2 = diff2.norm() / dt2->dt();
-
-    // consider directions
-    //     vel1 *= g2o::sign(diff1[0]*cos(pose1->theta()) +
-    //     diff1[1]*sin(pose1->theta()));
-    //     vel2 *= g2o::sign(diff2[0]*cos(pose2->theta()) +
-    //     diff2[1]*sin(pose2->theta()));
-    vel1 *= fast_sigmoid(100 * (diff1.x() * cos(pose1->theta()) +
-                                diff1.y() * sin(pose1->theta())));
-    vel2 *= fast_sigmoid(100 * (diff2.x() * cos(pose2->theta()) +
-                                diff2.y() * sin(pose2->theta())));
-
-    double acc_lin = (vel2 - vel1) * 2 / (dt1->dt() + dt2->dt());
-
-    _error[0] = penaltyBoundToInterval(acc_lin, cfg_->robot.acc_lim_x,
-                                       cfg_->optim.penalty_epsilon);
+    TebScalar vel1, omega1, vel2, omega2;
+    computeVelocity(pose1->pose(), pose2->pose(), dt1->dt(), vel1, omega1);
+    computeVelocity(pose2->pose(), pose3->pose(), dt2->dt(), vel2, omega2);
+
+    TebScalar acc_lin = (vel2 - vel1) * 2 / TebScalar(dt1->dt() + dt2->dt());
+
+    _error[0] = penaltyBoundToInterval(acc_lin, limits_.acc_lim_x,
+                                       limits_.penalty_epsilon);
 
     // ANGULAR ACCELERATION
-    double omega1 =
-        g2o::normalize_theta(pose2->theta() - pose1->theta()) / dt1->dt();
-    double omega2 =
-        g2o::normalize_theta(pose3->theta() - pose2->theta()) / dt2->dt();
-    double acc_rot = (omega2 - omega1) * 2 / (dt1->dt() + dt2->dt());
+    TebScalar acc_rot =
+        (omega2 - omega1) * 2 / TebScalar(dt1->dt() + dt2->dt());
 
-    _error[1] = penaltyBoundToInterval(acc_rot, cfg_->robot.acc_lim_theta,
-                                       cfg_->optim.penalty_epsilon);
+    _error[1] = penaltyBoundToInterval(acc_rot, limits_.acc_lim_theta,
+                                       limits_.penalty_epsilon);
 
     ROS_ASSERT_MSG(
         std::isfinite(_error[0]),
@@ -308,16 +295,20 @@ public:
    * @brief Assign the TebConfig class for parameters.
    * @param cfg TebConfig class
    */
-  void setTebConfig(const TebConfig &cfg) { cfg_ = &cfg; }
+  void setTebConfig(const TebConfig &cfg) {
+    cfg_ = &cfg;
+    limits_ = KinematicLimits::robot(cfg);
+  }
 
 protected:
-  const TebConfig *cfg_; //!< Store TebConfig class for parameters
+  const TebConfig *cfg_;   //!< Store TebConfig class for parameters
+  KinematicLimits limits_; //!< Limits copied from cfg_
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
-class EdgeAccelerationHuman : public g2o::BaseMultiEdge<2, double> {
+class EdgeAccelerationHuman : public BaseTebMultiEdge<2, double> {
 public:
   EdgeAccelerationHuman() {
     this->resize(5);
@@ -344,33 +335,19 @@ public:
         static_cast<const VertexTimeDiff *>(_vertices[4]);
 
     // VELOCITY & ACCELERATION
-    Eigen::Vector2d diff1 = pose2->position() - pose1->position();
-    Eigen::Vector2d diff2 = pose3->position() - pose2->position();
-    double vel1 = diff1.norm() / dt1->dt();
-    double vel2 = diff2.norm() / dt2->dt();
-
-    // consider directions
-    //     vel1 *= g2o::sign(diff1[0]*cos(pose1->theta()) +
-    //     diff1[1]*sin(pose1->theta()));
-    //     vel2 *= g2o::sign(diff2[0]*cos(pose2->theta()) +
-    //     diff2[1]*sin(pose2->theta()));
-    vel1 *= fast_sigmoid(100 * (diff1.x() * cos(pose1->theta()) +
-                                diff1.y() * sin(pose1->theta())));
-    vel2 *= fast_sigmoid(100 * (diff2.x() * cos(pose2->theta()) +
-                                diff2.y() * sin(pose2->theta())));
-
-    double acc_lin = (vel2 - vel1) * 2 / (dt1->dt() + dt2->dt());
-    _error[0] = penaltyBoundToInterval(acc_lin, cfg_->human.acc_lim_x,
-                                       cfg_->optim.penalty_epsilon);
+    TebScalar vel1, omega1, vel2, omega2;
+    computeVelocity(pose1->pose(), pose2->pose(), dt1->dt(), vel1, omega1);
+    computeVelocity(pose2->pose(), pose3->pose(), dt2->dt(), vel2, omega2);
+
+    TebScalar acc_lin = (vel2 - vel1) * 2 / TebScalar(dt1->dt() + dt2->dt());
+    _error[0] = penaltyBoundToInterval(acc_lin, limits_.acc_lim_x,
+                                       limits_.penalty_epsilon);
 
     // ANGULAR ACCELERATION
-    double omega1 =
-        g2o::normalize_theta(pose2->theta() - pose1->theta()) / dt1->dt();
-    double omega2 =
-        g2o::normalize_theta(pose3->theta() - pose2->theta()) / dt2->dt();
-    double acc_rot = (omega2 - omega1) * 2 / (dt1->dt() + dt2->dt());
-    _error[1] = penaltyBoundToInterval(acc_rot, cfg_->human.acc_lim_theta,
-                                       cfg_->optim.penalty_epsilon);
+    TebScalar acc_rot =
+        (omega2 - omega1) * 2 / TebScalar(dt1->dt() + dt2->dt());
+    _error[1] = penaltyBoundToInterval(acc_rot, limits_.acc_lim_theta,
+                                       limits_.penalty_epsilon);
 
     ROS_ASSERT_MSG(
         std::isfinite(_error[0]),
@@ -399,10 +376,14 @@ public:
     return os.good();
   }
 
-  void setTebConfig(const TebConfig &cfg) { cfg_ = &cfg; }
+  void setTebConfig(const TebConfig &cfg) {
+    cfg_ = &cfg;
+    limits_ = KinematicLimits::human(cfg);
+  }
 
 protected:
   const TebConfig *cfg_;
+  KinematicLimits limits_;
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -435,7 +416,7 @@ public:
  * end of the trajectory!
  */
 class EdgeAccelerationStart
-    : public g2o::BaseMultiEdge<2, const Eigen::Vector2d *> {
+    : public BaseTebMultiEdge<2, const Eigen::Vector2d *> {
 public:
   /**
    * @brief Construct edge.
@@ -474,29 +455,21 @@ public:
         static_cast<const VertexTimeDiff *>(_vertices[2]);
 
     // VELOCITY & ACCELERATION
-    Eigen::Vector2d diff = pose2->position() - pose1->position();
-    double vel1 = _measurement->coeffRef(0);
-    double vel2 = diff.norm() / dt->dt();
-
-    // consider directions
-    // vel2 *= g2o::sign(diff[0]*cos(pose1->theta()) +
-    // diff[1]*sin(pose1->theta()));
-    vel2 *= fast_sigmoid(100 * (diff.x() * cos(pose1->theta()) +
-                                diff.y() * sin(pose1->theta())));
+    TebScalar vel1 = TebScalar(_measurement->coeffRef(0));
+    TebScalar omega1 = TebScalar(_measurement->coeffRef(1));
+    TebScalar vel2, omega2;
+    computeVelocity(pose1->pose(), pose2->pose(), dt->dt(), vel2, omega2);
 
-    double acc_lin = (vel2 - vel1) / dt->dt();
+    TebScalar acc_lin = (vel2 - vel1) / TebScalar(dt->dt());
 
-    _error[0] = penaltyBoundToInterval(acc_lin, cfg_->robot.acc_lim_x,
-                                       cfg_->optim.penalty_epsilon);
+    _error[0] = penaltyBoundToInterval(acc_lin, limits_.acc_lim_x,
+                                       limits_.penalty_epsilon);
 
     // ANGULAR ACCELERATION
-    double omega1 = _measurement->coeffRef(1);
-    double omega2 =
-        g2o::normalize_theta(pose2->theta() - pose1->theta()) / dt->dt();
-    double acc_rot = (omega2 - omega1) / dt->dt();
+    TebScalar acc_rot = (omega2 - omega1) / TebScalar(dt->dt());
 
-    _error[1] = penaltyBoundToInterval(acc_rot, cfg_->robot.acc_lim_theta,
-                                       cfg_->optim.penalty_epsilon);
+    _error[1] = penaltyBoundToInterval(acc_rot, limits_.acc_lim_theta,
+                                       limits_.penalty_epsilon);
 
     ROS_ASSERT_MSG(
         std::isfinite(_error[0]),
@@ -551,17 +524,21 @@ public:
    * @brief Assign the TebConfig class for parameters.
    * @param cfg TebConfig class
    */
-  void setTebConfig(const TebConfig &cfg) { cfg_ = &cfg; }
+  void setTebConfig(const TebConfig &cfg) {
+    cfg_ = &cfg;
+    limits_ = KinematicLimits::robot(cfg);
+  }
 
 protected:
-  const TebConfig *cfg_; //!< Store TebConfig class for parameters
+  const TebConfig *cfg_;   //!< Store TebConfig class for parameters
+  KinematicLimits limits_; //!< Limits copied from cfg_
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
 class EdgeAccelerationHumanStart
-    : public g2o::BaseMultiEdge<2, const Eigen::Vector2d *> {
+    : public BaseTebMultiEdge<2, const Eigen::Vector2d *> {
 public:
   EdgeAccelerationHumanStart() {
     this->resize(3);
@@ -586,27 +563,19 @@ public:
         static_cast<const VertexTimeDiff *>(_vertices[2]);
 
     // VELOCITY & ACCELERATION
-    Eigen::Vector2d diff = pose2->position() - pose1->position();
-    double vel1 = _measurement->coeffRef(0);
-    double vel2 = diff.norm() / dt->dt();
+    TebScalar vel1 = TebScalar(_measurement->coeffRef(0));
+    TebScalar omega1 = TebScalar(_measurement->coeffRef(1));
+    TebScalar vel2, omega2;
+    computeVelocity(pose1->pose(), pose2->pose(), dt->dt(), vel2, omega2);
 
-    // consider directions
-    // vel2 *= g2o::sign(diff[0]*cos(pose1->theta()) +
-    // diff[1]*sin(pose1->theta()));
-    vel2 *= fast_sigmoid(100 * (diff.x() * cos(pose1->theta()) +
-                                diff.y() * sin(pose1->theta())));
-
-    double acc_lin = (vel2 - vel1) / dt->dt();
-    _error[0] = penaltyBoundToInterval(acc_lin, cfg_->human.acc_lim_x,
-                                       cfg_->optim.penalty_epsilon);
+    TebScalar acc_lin = (vel2 - vel1) / TebScalar(dt->dt());
+    _error[0] = penaltyBoundToInterval(acc_lin, limits_.acc_lim_x,
+                                       limits_.penalty_epsilon);
 
     // ANGULAR ACCELERATION
-    double omega1 = _measurement->coeffRef(1);
-    double omega2 =
-        g2o::normalize_theta(pose2->theta() - pose1->theta()) / dt->dt();
-    double acc_rot = (omega2 - omega1) / dt->dt();
-    _error[1] = penaltyBoundToInterval(acc_rot, cfg_->human.acc_lim_theta,
-                                       cfg_->optim.penalty_epsilon);
+    TebScalar acc_rot = (omega2 - omega1) / TebScalar(dt->dt());
+    _error[1] = penaltyBoundToInterval(acc_rot, limits_.acc_lim_theta,
+                                       limits_.penalty_epsilon);
 
     ROS_ASSERT_MSG(
         std::isfinite(_error[0]),
@@ -638,10 +607,14 @@ public:
     _measurement = &vel_start;
   }
 
-  void setTebConfig(const TebConfig &cfg) { cfg_ = &cfg; }
+  void setTebConfig(const TebConfig &cfg) {
+    cfg_ = &cfg;
+    limits_ = KinematicLimits::human(cfg);
+  }
 
 protected:
   const TebConfig *cfg_;
+  KinematicLimits limits_;
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -674,7 +647,7 @@ public:
  * values at the end of the trajectory
  */
 class EdgeAccelerationGoal
-    : public g2o::BaseMultiEdge<2, const Eigen::Vector2d *> {
+    : public BaseTebMultiEdge<2, const Eigen::Vector2d *> {
 public:
   /**
    * @brief Construct edge.
@@ -715,30 +688,22 @@ public:
 
     // VELOCITY & ACCELERATION
 
-    Eigen::Vector2d diff = pose_goal->position() - pose_pre_goal->position();
-    double vel1 = diff.norm() / dt->dt();
-    double vel2 = _measurement->coeffRef(0);
-
-    // consider directions
-    // vel1 *= g2o::sign(diff[0]*cos(pose_pre_goal->theta()) +
-    // diff[1]*sin(pose_pre_goal->theta()));
-    vel1 *= fast_sigmoid(100 * (diff.x() * cos(pose_pre_goal->theta()) +
-                                diff.y() * sin(pose_pre_goal->theta())));
+    TebScalar vel1, omega1;
+    computeVelocity(pose_pre_goal->pose(), pose_goal->pose(), dt->dt(), vel1,
+                    omega1);
+    TebScalar vel2 = TebScalar(_measurement->coeffRef(0));
+    TebScalar omega2 = TebScalar(_measurement->coeffRef(1));
 
-    double acc_lin = (vel2 - vel1) / dt->dt();
+    TebScalar acc_lin = (vel2 - vel1) / TebScalar(dt->dt());
 
-    _error[0] = penaltyBoundToInterval(acc_lin, cfg_->robot.acc_lim_x,
-                                       cfg_->optim.penalty_epsilon);
+    _error[0] = penaltyBoundToInterval(acc_lin, limits_.acc_lim_x,
+                                       limits_.penalty_epsilon);
 
     // ANGULAR ACCELERATION
-    double omega1 =
-        g2o::normalize_theta(pose_goal->theta() - pose_pre_goal->theta()) /
-        dt->dt();
-    double omega2 = _measurement->coeffRef(1);
-    double acc_rot = (omega2 - omega1) / dt->dt();
+    TebScalar acc_rot = (omega2 - omega1) / TebScalar(dt->dt());
 
-    _error[1] = penaltyBoundToInterval(acc_rot, cfg_->robot.acc_lim_theta,
-                                       cfg_->optim.penalty_epsilon);
+    _error[1] = penaltyBoundToInterval(acc_rot, limits_.acc_lim_theta,
+                                       limits_.penalty_epsilon);
 
     ROS_ASSERT_MSG(
         std::isfinite(_error[0]),
@@ -794,17 +759,21 @@ public:
    * @brief Assign the TebConfig class for parameters.
    * @param cfg TebConfig class
    */
-  void setTebConfig(const TebConfig &cfg) { cfg_ = &cfg; }
+  void setTebConfig(const TebConfig &cfg) {
+    cfg_ = &cfg;
+    limits_ = KinematicLimits::robot(cfg);
+  }
 
 protected:
-  const TebConfig *cfg_; //!< Store TebConfig class for parameters
+  const TebConfig *cfg_;   //!< Store TebConfig class for parameters
+  KinematicLimits limits_; //!< Limits copied from cfg_
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
 class EdgeAccelerationHumanGoal
-    : public g2o::BaseMultiEdge<2, const Eigen::Vector2d *> {
+    : public BaseTebMultiEdge<2, const Eigen::Vector2d *> {
 public:
   EdgeAccelerationHumanGoal() {
     _measurement = NULL;
@@ -831,30 +800,22 @@ public:
 
     // VELOCITY & ACCELERATION
 
-    Eigen::Vector2d diff = pose_goal->position() - pose_pre_goal->position();
-    double vel1 = diff.norm() / dt->dt();
-    double vel2 = _measurement->coeffRef(0);
-
-    // consider directions
-    // vel1 *= g2o::sign(diff[0]*cos(pose_pre_goal->theta()) +
-    // diff[1]*sin(pose_pre_goal->theta()));
-    vel1 *= fast_sigmoid(100 * (diff.x() * cos(pose_pre_goal->theta()) +
-                                diff.y() * sin(pose_pre_goal->theta())));
+    TebScalar vel1, omega1;
+    computeVelocity(pose_pre_goal->pose(), pose_goal->pose(), dt->dt(), vel1,
+                    omega1);
+    TebScalar vel2 = TebScalar(_measurement->coeffRef(0));
+    TebScalar omega2 = TebScalar(_measurement->coeffRef(1));
 
-    double acc_lin = (vel2 - vel1) / dt->dt();
+    TebScalar acc_lin = (vel2 - vel1) / TebScalar(dt->dt());
 
-    _error[0] = penaltyBoundToInterval(acc_lin, cfg_->human.acc_lim_x,
-                                       cfg_->optim.penalty_epsilon);
+    _error[0] = penaltyBoundToInterval(acc_lin, limits_.acc_lim_x,
+                                       limits_.penalty_epsilon);
 
     // ANGULAR ACCELERATION
-    double omega1 =
-        g2o::normalize_theta(pose_goal->theta() - pose_pre_goal->theta()) /
-        dt->dt();
-    double omega2 = _measurement->coeffRef(1);
-    double acc_rot = (omega2 - omega1) / dt->dt();
+    TebScalar acc_rot = (omega2 - omega1) / TebScalar(dt->dt());
 
-    _error[1] = penaltyBoundToInterval(acc_rot, cfg_->human.acc_lim_theta,
-                                       cfg_->optim.penalty_epsilon);
+    _error[1] = penaltyBoundToInterval(acc_rot, limits_.acc_lim_theta,
+                                       limits_.penalty_epsilon);
 
     ROS_ASSERT_MSG(
         std::isfinite(_error[0]),
@@ -887,10 +848,14 @@ public:
     _measurement = &vel_goal;
   }
 
-  void setTebConfig(const TebConfig &cfg) { cfg_ = &cfg; }
+  void setTebConfig(const TebConfig &cfg) {
+    cfg_ = &cfg;
+    limits_ = KinematicLimits::human(cfg);
+  }
 
 protected:
   const TebConfig *cfg_;
+  KinematicLimits limits_;
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -41,6 +41,7 @@
  * Author: Christoph Rösmann
  *********************************************************************/
 
+
 #ifndef EDGE_DYNAMICOBSTACLE_H
 #define EDGE_DYNAMICOBSTACLE_H
 
@@ -49,8 +50,11 @@
 #include <teb_local_planner/g2o_types/penalties.h>
 #include <teb_local_planner/obstacles.h>
 #include <teb_local_planner/teb_config.h>
+#include <teb_local_planner/timed_elastic_band.h>
+
+#include "g2o/core/base_multi_edge.h"
 
-#include "g2o/core/base_binary_edge.h"
+#include <algorithm>
 
 namespace teb_local_planner
 {
@@ -59,34 +63,41 @@ namespace teb_local_planner
  * @class EdgeDynamicObstacle
  * @brief Edge defining the cost function for keeping a distance from dynamic (moving) obstacles.
  * 
- * The edge depends on two vertices \f$ \mathbf{s}_i, \Delta T_i \f$ and minimizes: \n
+ * The edge depends on the pose \f$ \mathbf{s}_i \f$ and on the \f$ w \f$ preceding time differences \f$ \Delta T_{i-w} ... \Delta T_{i-1} \f$ and minimizes: \n
  * \f$ \min \textrm{penaltyBelow}( dist2obstacle) \cdot weight \f$. \n
- * \e dist2obstacle denotes the minimum distance to the obstacle trajectory (spatial and temporal). \n
+ * \e dist2obstacle denotes the distance to the obstacle predicted with a constant velocity up to the absolute time \f$ t_i = \sum_{k<i} \Delta T_k \f$. \n
  * \e weight can be set using setInformation(). \n
  * \e penaltyBelow denotes the penalty function, see penaltyBoundFromBelow(). \n
+ * The absolute time is taken from the cached time prefix of the trajectory (see setTimedElasticBand() and TimedElasticBand::getTimeAtPose()),
+ * otherwise the time differences before the window are approximated by the mean of the window. \n
+ * Only the window (see TebConfig::Obstacles::dynamic_obstacle_dt_window) is linearized, hence the edges of the trajectory share
+ * only a few time differences and the Hessian stays sparse. \n
+ * Vertex 0 is the pose \f$ \mathbf{s}_i \f$, vertex \f$ k+1 \f$ is the time diff \f$ \Delta T_{i-w+k} \f$.
  * @see TebOptimalPlanner::AddEdgesDynamicObstacles
- * @remarks Do not forget to call setTebConfig(), setVertexIdx() and 
+ * @remarks Do not forget to call setTebConfig() and setObstacle()
  * @warning Experimental
  */  
-class EdgeDynamicObstacle : public g2o::BaseBinaryEdge<1, const Obstacle*, VertexPose, VertexTimeDiff>
+class EdgeDynamicObstacle : public g2o::BaseMultiEdge<1, const Obstacle*>
 {
 public:
   
   /**
    * @brief Construct edge.
    */    
-  EdgeDynamicObstacle() : vert_idx_(0)
+  EdgeDynamicObstacle() : cfg_(NULL), teb_(NULL), vert_idx_(0), dt_window_(0)
   {
-    _vertices[0] = _vertices[1] = NULL;
+    this->resize(1);
+    _vertices[0] = NULL;
   }
   
   /**
    * @brief Construct edge and specify the vertex id (neccessary for computeError).
    * @param vert_idx Index of the vertex (position in the pose sequence)
+   * @param dt_window Number of preceding time diffs the edge depends on (at least 1, at most \c vert_idx)
    */      
-  EdgeDynamicObstacle(size_t vert_idx) : vert_idx_(vert_idx)
+  EdgeDynamicObstacle(size_t vert_idx, size_t dt_window = 1) : cfg_(NULL), teb_(NULL), vert_idx_(0), dt_window_(0)
   {
-    _vertices[0] = _vertices[1] = NULL;
+    setVertexIdx(vert_idx, dt_window);
   }
   
   /**
@@ -97,8 +108,10 @@ public:
    */   
   virtual ~EdgeDynamicObstacle() 
   {
-    if(_vertices[0]) _vertices[0]->edges().erase(this);
-    if(_vertices[1]) _vertices[1]->edges().erase(this);
+    for (unsigned int i=0; i<_vertices.size(); ++i)
+    {
+      if(_vertices[i]) _vertices[i]->edges().erase(this);
+    }
   }
 
   /**
@@ -108,30 +121,55 @@ public:
   {
     ROS_ASSERT_MSG(cfg_, "You must call setTebConfig on EdgeDynamicObstacle()");
     const VertexPose* bandpt = static_cast<const VertexPose*>(_vertices[0]);
-    const VertexTimeDiff* dt_vertex = static_cast<const VertexTimeDiff*>(_vertices[1]);
     
-    // WARNING: vert_idx_*dt is just an approximation for the total time, since we don't have a uniform dt at the moment!
-    Eigen::Vector2d pred_obst_point = _measurement->getCentroid() + double(vert_idx_)*dt_vertex->estimate()*_measurement->getCentroidVelocity();
+    Eigen::Vector2d pred_obst_point = _measurement->getCentroid() + absoluteTime()*_measurement->getCentroidVelocity();
     double dist = (pred_obst_point - bandpt->position()).norm();
-    /*
-    // get point in x-y-t
-    Eigen::Vector3d point(bandpt->estimate().coeffRef(0), bandpt->estimate().coeffRef(1), _vert_idx*dt_vertex->estimate());
-    
-    // calc distance of that point to the obstacle trajectory in x-y-t predicted with a constant velocity
-    Eigen::Vector3d robot_point;
-    robot_point.head(2) = _measurement->getCentroid();
-    robot_point.coeffRef(2) = 0;
-    Eigen::Vector3d robot_vel;
-    robot_vel.head(2) = _measurement->getCentroidVelocity();
-    robot_vel.coeffRef(2) = 1;
-    double dist = 0; //calcDistancePointToLine<Eigen::Vector3d>(point, robot_point, robot_vel);   
-    */ 
     
     _error[0] = penaltyBoundFromBelow(dist, cfg_->obstacles.min_obstacle_dist, cfg_->optim.penalty_epsilon);
 
-    ROS_ASSERT_MSG(std::isfinite(_error[0]), "EdgeDynamicObstacle::computeError() _error[0]=%f _error[1]=%f\n",_error[0],_error[1]);	  
+    ROS_ASSERT_MSG(std::isfinite(_error[0]), "EdgeDynamicObstacle::computeError() _error[0]=%f\n",_error[0]);	  
   }
 
+#ifdef USE_ANALYTIC_JACOBI
+  /**
+   * @brief Jacobi matrix of the cost function specified in computeError().
+   * 
+   * The derivative w.r.t. each time diff of the window is identical, since all of them enter the absolute time with a unit factor.
+   */
+  void linearizeOplus()
+  {
+    ROS_ASSERT_MSG(cfg_, "You must call setTebConfig on EdgeDynamicObstacle()");
+    const VertexPose* bandpt = static_cast<const VertexPose*>(_vertices[0]);
+    
+    const Eigen::Vector2d& obst_vel = _measurement->getCentroidVelocity();
+    Eigen::Vector2d diff = _measurement->getCentroid() + absoluteTime()*obst_vel - bandpt->position();
+    double dist = diff.norm();
+    
+    double dev_dist = penaltyBoundFromBelowDerivative(dist, cfg_->obstacles.min_obstacle_dist, cfg_->optim.penalty_epsilon);
+    
+    double dev_x = 0, dev_y = 0, dev_t = 0;
+    if (dev_dist != 0 && dist > 0)
+    {
+      // d dist / d pos = -diff/dist,  d dist / d t = diff*v/dist
+      double aux = dev_dist / dist;
+      dev_x = -diff.x() * aux;
+      dev_y = -diff.y() * aux;
+      dev_t = diff.dot(obst_vel) * aux;
+    }
+    
+    _jacobianOplus[0].resize(1,3); // pose
+    _jacobianOplus[0](0,0) = dev_x;
+    _jacobianOplus[0](0,1) = dev_y;
+    _jacobianOplus[0](0,2) = 0;
+    
+    for (unsigned int k=1; k<_vertices.size(); ++k)
+    {
+      _jacobianOplus[k].resize(1,1); // deltaT_{k-1}
+      _jacobianOplus[k](0,0) = dev_t;
+    }
+  }
+#endif
+  
   /**
    * @brief Compute and return error / cost value.
    * 
@@ -164,11 +202,19 @@ public:
   
   /**
    * @brief Set the vertex index (position in the pose sequence)
+   * 
+   * This resizes the edge to the pose and its \c dt_window preceding time diffs.
+   * Call it before assigning the vertices.
    * @param vert_idx Index of the vertex
+   * @param dt_window Number of preceding time diffs the edge depends on (at least 1, at most \c vert_idx)
    */  
-  void setVertexIdx(size_t vert_idx)
+  void setVertexIdx(size_t vert_idx, size_t dt_window = 1)
   {
     vert_idx_ = vert_idx;
+    dt_window_ = std::min(std::max<size_t>(dt_window, 1), vert_idx);
+    this->resize(dt_window_+1);
+    for (unsigned int i=0; i<_vertices.size(); ++i)
+      _vertices[i] = NULL;
   }
   
   /**
@@ -188,19 +234,46 @@ public:
   {
     cfg_ = &cfg;
   }
+  
+  /**
+   * @brief Assign the trajectory whose cached time prefix provides the absolute time of the pose.
+   * 
+   * The caller is responsible for keeping the prefix up to date (see TimedElasticBand::timePrefixAction()).
+   * @param teb TimedElasticBand that owns the vertices of this edge
+   */
+  void setTimedElasticBand(const TimedElasticBand& teb)
+  {
+    teb_ = &teb;
+  }
 
 protected:
   
+  /**
+   * @brief Absolute time of the pose w.r.t. the start of the trajectory
+   */
+  double absoluteTime() const
+  {
+    if (teb_ && vert_idx_ < teb_->sizeTimePrefix())
+      return teb_->getTimeAtPose(vert_idx_);
+    
+    if (dt_window_ == 0)
+      return 0;
+    double time = 0;
+    for (unsigned int k=1; k<_vertices.size(); ++k)
+      time += static_cast<const VertexTimeDiff*>(_vertices[k])->dt();
+    return time * double(vert_idx_) / double(dt_window_);
+  }
+  
   const TebConfig* cfg_; //!< Store TebConfig class for parameters
+  const TimedElasticBand* teb_; //!< Trajectory providing the cached time prefix
   size_t vert_idx_; //!< Store vertex index (position in the pose sequence)
+  size_t dt_window_; //!< Number of preceding time diffs the edge depends on
   
 public: 
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
 };
     
- 
-    
 
 } // end namespace
 
@@ -86,12 +86,8 @@ public:
 
     Eigen::Vector2d d_rtoh =
         human_bandpt->position() - robot_bandpt->position();
-    Eigen::Vector2d d_htor =
-        robot_bandpt->position() - human_bandpt->position();
 
-    double dir_cost = (std::max(robot_vel.dot(d_rtoh), 0.0) +
-                       std::max(human_vel.dot(d_htor), 0.0)) /
-                      d_rtoh.dot(d_rtoh);
+    double dir_cost = computeDirCost(robot_vel, human_vel, d_rtoh);
     ROS_DEBUG_THROTTLE(0.5, "dir_cost value : %f", dir_cost);
 
     _error[0] = penaltyBoundFromBelow(dir_cost, cfg_->human.dir_cost_threshold,
@@ -101,6 +97,21 @@ public:
                    "EdgeHumanRobot::computeError() _error[0]=%f\n", _error[0]);
   }
 
+  /**
+   * @brief Directional cost of robot and human moving towards each other
+   * @param robot_vel robot velocity
+   * @param human_vel human velocity
+   * @param d_rtoh relative position (human - robot)
+   * @return directional cost, 0 if both move away from each other
+   */
+  static double computeDirCost(const Eigen::Vector2d &robot_vel,
+                               const Eigen::Vector2d &human_vel,
+                               const Eigen::Vector2d &d_rtoh) {
+    return (std::max(robot_vel.dot(d_rtoh), 0.0) +
+            std::max(-human_vel.dot(d_rtoh), 0.0)) /
+           d_rtoh.dot(d_rtoh);
+  }
+
   ErrorVector &getError() {
     computeError();
     return _error;
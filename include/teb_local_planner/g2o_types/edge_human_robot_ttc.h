@@ -85,22 +85,8 @@ public:
     Eigen::Vector2d human_vel = diff_human / dt_human->dt();
 
     Eigen::Vector2d C = human_bandpt->position() - robot_bandpt->position();
-
-    double ttc = std::numeric_limits<double>::infinity();
     double C_sq = C.dot(C);
-    if (C_sq <= radius_sum_sq_) {
-      ttc = 0.0;
-    } else {
-      Eigen::Vector2d V = robot_vel - human_vel;
-      double C_dot_V = C.dot(V);
-      if (C_dot_V > 0) { // otherwise ttc is infinite
-        double V_sq = V.dot(V);
-        double f = (C_dot_V * C_dot_V) - (V_sq * (C_sq - radius_sum_sq_));
-        if (f > 0) { // otherwise ttc is infinite
-          ttc = (C_dot_V - std::sqrt(f)) / V_sq;
-        }
-      }
-    }
+    double ttc = computeTTC(C, robot_vel - human_vel, radius_sum_sq_);
 
     if (ttc < std::numeric_limits<double>::infinity()) {
       // if (ttc > 0) {
@@ -128,6 +114,31 @@ public:
                    "EdgeHumanRobot::computeError() _error[0]=%f\n", _error[0]);
   }
 
+  /**
+   * @brief Time to collision of two discs moving with constant velocities
+   * @param C relative position (human - robot)
+   * @param V relative velocity (robot - human)
+   * @param radius_sum_sq squared sum of both radii
+   * @return time to collision, 0 if already in collision and infinity if the
+   * discs do not collide
+   */
+  static double computeTTC(const Eigen::Vector2d &C, const Eigen::Vector2d &V,
+                           double radius_sum_sq) {
+    double C_sq = C.dot(C);
+    if (C_sq <= radius_sum_sq)
+      return 0.0;
+
+    double C_dot_V = C.dot(V);
+    if (C_dot_V > 0) { // otherwise ttc is infinite
+      double V_sq = V.dot(V);
+      double f = (C_dot_V * C_dot_V) - (V_sq * (C_sq - radius_sum_sq));
+      if (f > 0) { // otherwise ttc is infinite
+        return (C_dot_V - std::sqrt(f)) / V_sq;
+      }
+    }
+    return std::numeric_limits<double>::infinity();
+  }
+
   ErrorVector &getError() {
     computeError();
     return _error;
@@ -0,0 +1,240 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Copyright (c) 2016 LAAS/CNRS
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Notes:
+ * The following class is derived from a class defined by the
+ * g2o-framework. g2o is licensed under the terms of the BSD License.
+ * Refer to the base class source for detailed licensing information.
+ *********************************************************************/
+
+#ifndef EDGE_KERNELS_H
+#define EDGE_KERNELS_H
+
+#include <teb_local_planner/pose_se2.h>
+#include <teb_local_planner/teb_config.h>
+
+#include <g2o/core/base_multi_edge.h>
+
+#include <Eigen/Core>
+#include <cmath>
+#include <limits>
+
+namespace teb_local_planner {
+
+/**
+ * @brief Scalar type of the kinematic edge kernels.
+ *
+ * Defining \c TEB_FLOAT_PRECISION (CMake option of the same name) evaluates
+ * the kernels in single precision. Vertex estimates, error vectors, the
+ * Hessian and the linear solve remain in double precision (g2o), such that
+ * the optimization runs in mixed precision.
+ *
+ * Only the velocity and acceleration edges use these kernels. The obstacle,
+ * via-point and human edges keep evaluating in double: they are
+ * differentiated numerically by g2o with its fixed step of 1e-9, which
+ * vanishes below the float resolution of map coordinates, so they would need
+ * analytic Jacobians first. The dynamic obstacle edges share the double
+ * precision distance functions of the obstacle snapshot with them. Use
+ * teb_replay to compare the trajectories and costs of both builds on a
+ * recorded log.
+ */
+#ifdef TEB_FLOAT_PRECISION
+typedef float TebScalar;
+#else
+typedef double TebScalar;
+#endif
+
+/**
+ * @brief Normalize an angle to [-pi, pi) (same as g2o::normalize_theta(), but
+ * for any scalar type)
+ */
+template <typename Scalar> inline Scalar normalizeTheta(Scalar theta) {
+  const Scalar pi = Scalar(M_PI);
+  if (theta >= -pi && theta < pi)
+    return theta;
+  Scalar multiplier = std::floor(theta / (2 * pi));
+  theta = theta - multiplier * 2 * pi;
+  if (theta >= pi)
+    theta -= 2 * pi;
+  if (theta < -pi)
+    theta += 2 * pi;
+  return theta;
+}
+
+/**
+ * @brief Compute the signed translational and the rotational velocity between
+ * two consecutive poses.
+ *
+ * The position and angle differences are taken in double precision, the
+ * remaining kernel is evaluated in \c Scalar. The direction of the
+ * translational velocity is approximated by a fast sigmoid of the projection
+ * onto the heading of \c pose1.
+ * @param pose1 first pose
+ * @param pose2 second pose
+ * @param dt time difference between both poses
+ * @param[out] vel translational velocity
+ * @param[out] omega rotational velocity
+ */
+template <typename Scalar>
+inline void computeVelocity(const PoseSE2 &pose1, const PoseSE2 &pose2,
+                            double dt, Scalar &vel, Scalar &omega) {
+  Eigen::Matrix<Scalar, 2, 1> delta_s =
+      (pose2.position() - pose1.position()).template cast<Scalar>();
+  Scalar theta1 = Scalar(pose1.theta());
+  Scalar delta_t = Scalar(dt);
+
+  vel = delta_s.norm() / delta_t;
+  Scalar dir = Scalar(100) * (delta_s.x() * std::cos(theta1) +
+                              delta_s.y() * std::sin(theta1));
+  vel *= dir / (1 + std::abs(dir)); // see fast_sigmoid()
+
+  omega = normalizeTheta(Scalar(pose2.theta() - pose1.theta())) / delta_t;
+}
+
+/**
+ * @brief Step size of the central differences for kernels evaluated in
+ * \c Scalar precision.
+ *
+ * g2o uses a fixed step of 1e-9, which is lost in single precision.
+ */
+template <typename Scalar> inline double numericDiffStep() {
+  return std::cbrt(double(std::numeric_limits<Scalar>::epsilon()));
+}
+
+template <> inline double numericDiffStep<double>() { return 1e-9; }
+
+/**
+ * @brief Velocity and acceleration limits of the kinematic edges.
+ *
+ * The edges copy their limits from the TebConfig in setTebConfig() (the graph
+ * is rebuilt for each optimization), hence computeError() does not chase the
+ * configuration pointer for every evaluation.
+ */
+struct KinematicLimits {
+  double max_vel_x;
+  double max_vel_x_backwards;
+  double max_vel_theta;
+  double acc_lim_x;
+  double acc_lim_theta;
+  double penalty_epsilon;
+
+  //! Limits of the robot
+  static KinematicLimits robot(const TebConfig &cfg) {
+    KinematicLimits limits = {cfg.robot.max_vel_x,
+                              cfg.robot.max_vel_x_backwards,
+                              cfg.robot.max_vel_theta,
+                              cfg.robot.acc_lim_x,
+                              cfg.robot.acc_lim_theta,
+                              cfg.optim.penalty_epsilon};
+    return limits;
+  }
+
+  //! Limits of the humans
+  static KinematicLimits human(const TebConfig &cfg) {
+    KinematicLimits limits = {cfg.human.max_vel_x,
+                              cfg.human.max_vel_x_backwards,
+                              cfg.human.max_vel_theta,
+                              cfg.human.acc_lim_x,
+                              cfg.human.acc_lim_theta,
+                              cfg.optim.penalty_epsilon};
+    return limits;
+  }
+};
+
+/**
+ * @class BaseTebMultiEdge
+ * @brief g2o::BaseMultiEdge with numerical differentiation adapted to
+ * TebScalar.
+ *
+ * In double precision the g2o implementation is used as is. If
+ * \c TEB_FLOAT_PRECISION is defined, linearizeOplus() performs central
+ * differences with the step numericDiffStep<TebScalar>().
+ */
+template <int D, typename E>
+class BaseTebMultiEdge : public g2o::BaseMultiEdge<D, E> {
+public:
+#ifdef TEB_FLOAT_PRECISION
+  /**
+   * @brief Numerical Jacobi matrices of the cost function (central
+   * differences)
+   */
+  virtual void linearizeOplus() {
+    typedef typename g2o::BaseMultiEdge<D, E>::ErrorVector ErrorVector;
+    const double delta = numericDiffStep<TebScalar>();
+    const double scalar = 1.0 / (2 * delta);
+    ErrorVector error_before = this->_error;
+
+    for (std::size_t i = 0; i < this->_vertices.size(); ++i) {
+      g2o::OptimizableGraph::Vertex *vi =
+          static_cast<g2o::OptimizableGraph::Vertex *>(this->_vertices[i]);
+      if (vi->fixed())
+        continue;
+
+      double add_vi[MaxVertexDimension] = {0};
+      for (int d = 0; d < vi->dimension() && d < MaxVertexDimension; ++d) {
+        vi->push();
+        add_vi[d] = delta;
+        vi->oplus(add_vi);
+        this->computeError();
+        ErrorVector error_plus = this->_error;
+        vi->pop();
+
+        vi->push();
+        add_vi[d] = -delta;
+        vi->oplus(add_vi);
+        this->computeError();
+        vi->pop();
+        add_vi[d] = 0;
+
+        this->_jacobianOplus[i].col(d) = scalar * (error_plus - this->_error);
+      }
+    }
+    this->_error = error_before;
+  }
+
+  //! Largest vertex dimension of the TEB graph (VertexPose)
+  static const int MaxVertexDimension = 3;
+#endif
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+} // end namespace
+
+#endif
@@ -67,6 +67,8 @@ namespace teb_local_planner {
  * \e dist2point denotes the minimum distance to the point obstacle. \n
  * \e weight can be set using setInformation(). \n
  * \e penaltyBelow denotes the penalty function, see penaltyBoundFromBelow() \n
+ * If the obstacle is referred to by an ObstacleSnapshot and its index, the
+ * distance is computed with the non-virtual kernels of the snapshot. \n
  * @see TebOptimalPlanner::AddEdgesObstacles
  * @remarks Do not forget to call setTebConfig() and setObstacle()
  */
@@ -76,7 +78,7 @@ public:
   /**
    * @brief Construct edge.
    */
-  EdgeObstacle() {
+  EdgeObstacle() : obstacles_(NULL), obstacle_idx_(0) {
     _measurement = NULL;
     _vertices[0] = NULL;
   }
@@ -103,7 +105,10 @@ public:
                    "setRobotModel() on EdgeObstacle()");
     const VertexPose *bandpt = static_cast<const VertexPose *>(_vertices[0]);
 
-    double dist = robot_model_->calculateDistance(bandpt->pose(), _measurement);
+    double dist =
+        obstacles_ ? robot_model_->calculateDistance(bandpt->pose(), *obstacles_,
+                                                     obstacle_idx_)
+                   : robot_model_->calculateDistance(bandpt->pose(), _measurement);
 
     if (cfg_->obstacles.use_nonlinear_obstacle_penalty) {
       _error[0] = penaltyBoundFromBelowExp(
@@ -224,11 +229,33 @@ public:
     cfg_ = &cfg;
     robot_model_ = robot_model;
     _measurement = obstacle;
+    obstacles_ = NULL;
+  }
+
+  /**
+   * @brief Set all parameters at once (obstacle referred to by a snapshot)
+   * @param cfg TebConfig class
+   * @param robot_model Robot model required for distance calculation
+   * @param obstacles Obstacle snapshot (must be valid as long as the edge)
+   * @param obstacle_idx Index of the obstacle in the snapshot
+   */
+  void setParameters(const TebConfig &cfg,
+                     const BaseRobotFootprintModel *robot_model,
+                     const ObstacleSnapshot *obstacles,
+                     std::size_t obstacle_idx) {
+    cfg_ = &cfg;
+    robot_model_ = robot_model;
+    _measurement = obstacles->obstacle(obstacle_idx);
+    obstacles_ = obstacles;
+    obstacle_idx_ = obstacle_idx;
   }
 
 protected:
   const TebConfig *cfg_; //!< Store TebConfig class for parameters
   const BaseRobotFootprintModel *robot_model_; //!< Store pointer to robot_model
+  const ObstacleSnapshot
+      *obstacles_;          //!< Snapshot containing the obstacle (optional)
+  std::size_t obstacle_idx_; //!< Index of the obstacle in obstacles_
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -51,6 +51,7 @@
 #include <teb_local_planner/g2o_types/vertex_pose.h>
 #include <teb_local_planner/g2o_types/vertex_timediff.h>
 #include <teb_local_planner/g2o_types/penalties.h>
+#include <teb_local_planner/g2o_types/edge_kernels.h>
 #include <teb_local_planner/teb_config.h>
 
 #include <g2o/core/base_multi_edge.h>
@@ -80,7 +81,7 @@ namespace teb_local_planner {
  * @see TebOptimalPlanner::AddEdgesVelocity
  * @remarks Do not forget to call setTebConfig()
  */
-class EdgeVelocity : public g2o::BaseMultiEdge<2, double> {
+class EdgeVelocity : public BaseTebMultiEdge<2, double> {
 public:
   /**
    * @brief Construct edge.
@@ -116,23 +117,15 @@ public:
     const VertexPose *conf2 = static_cast<const VertexPose *>(_vertices[1]);
     const VertexTimeDiff *deltaT =
         static_cast<const VertexTimeDiff *>(_vertices[2]);
-    Eigen::Vector2d deltaS =
-        conf2->estimate().position() - conf1->estimate().position();
-    double vel = deltaS.norm() / deltaT->estimate();
-    //     vel *= g2o::sign(deltaS[0]*cos(conf1->theta()) +
-    //     deltaS[1]*sin(conf1->theta())); // consider direction
-    vel *= fast_sigmoid(
-        100 * (deltaS.x() * cos(conf1->theta()) +
-               deltaS.y() * sin(conf1->theta()))); // consider direction
-
-    double omega = g2o::normalize_theta(conf2->theta() - conf1->theta()) /
-                   deltaT->estimate();
-
-    _error[0] = penaltyBoundToInterval(vel, -cfg_->robot.max_vel_x_backwards,
-                                       cfg_->robot.max_vel_x,
-                                       cfg_->optim.penalty_epsilon);
-    _error[1] = penaltyBoundToInterval(omega, cfg_->robot.max_vel_theta,
-                                       cfg_->optim.penalty_epsilon);
+    TebScalar vel, omega; // vel considers the direction
+    computeVelocity(conf1->pose(), conf2->pose(), deltaT->estimate(), vel,
+                    omega);
+
+    _error[0] = penaltyBoundToInterval(vel, -limits_.max_vel_x_backwards,
+                                       limits_.max_vel_x,
+                                       limits_.penalty_epsilon);
+    _error[1] = penaltyBoundToInterval(omega, limits_.max_vel_theta,
+                                       limits_.penalty_epsilon);
 
     ROS_ASSERT_MSG(std::isfinite(_error[0]),
                    "EdgeVelocity::computeError() _error[0]=%f _error[1]=%f\n",
@@ -162,8 +155,8 @@ public:
     double vel = dist * aux2;
     double omega = g2o::normalize_theta(conf2->theta() - conf1->theta()) * aux2;
 
-    double dev_border_vel = penaltyBoundToIntervalDerivative(vel, -cfg_->robot.max_vel_x_backwards, cfg_->robot.max_vel_x,cfg_->optim.penalty_epsilon);
-    double dev_border_omega = penaltyBoundToIntervalDerivative(omega, cfg_->robot.max_vel_theta,cfg_->optim.penalty_epsilon);
+    double dev_border_vel = penaltyBoundToIntervalDerivative(vel, -limits_.max_vel_x_backwards, limits_.max_vel_x,limits_.penalty_epsilon);
+    double dev_border_omega = penaltyBoundToIntervalDerivative(omega, limits_.max_vel_theta,limits_.penalty_epsilon);
 
     _jacobianOplus[0].resize(2,3); // conf1
     _jacobianOplus[1].resize(2,3); // conf2
@@ -249,16 +242,20 @@ public:
    * @brief Assign the TebConfig class for parameters.
    * @param cfg TebConfig class
    */
-  void setTebConfig(const TebConfig &cfg) { cfg_ = &cfg; }
+  void setTebConfig(const TebConfig &cfg) {
+    cfg_ = &cfg;
+    limits_ = KinematicLimits::robot(cfg);
+  }
 
 protected:
-  const TebConfig *cfg_; //!< Store TebConfig class for parameters
+  const TebConfig *cfg_;   //!< Store TebConfig class for parameters
+  KinematicLimits limits_; //!< Limits copied from cfg_
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
-class EdgeVelocityHuman : public g2o::BaseMultiEdge<3, double> {
+class EdgeVelocityHuman : public BaseTebMultiEdge<3, double> {
 public:
   EdgeVelocityHuman() {
     this->resize(3);
@@ -279,23 +276,15 @@ public:
     const VertexPose *conf2 = static_cast<const VertexPose *>(_vertices[1]);
     const VertexTimeDiff *deltaT =
         static_cast<const VertexTimeDiff *>(_vertices[2]);
-    Eigen::Vector2d deltaS =
-        conf2->estimate().position() - conf1->estimate().position();
-    double vel = deltaS.norm() / deltaT->estimate();
-    // vel *= g2o::sign(deltaS[0]*cos(conf1->theta()) +
-    // deltaS[1]*sin(conf1->theta())); // consider direction
-    vel *= fast_sigmoid(
-        100 * (deltaS.x() * cos(conf1->theta()) +
-               deltaS.y() * sin(conf1->theta()))); // consider direction
-
-    double omega = g2o::normalize_theta(conf2->theta() - conf1->theta()) /
-                   deltaT->estimate();
-
-    _error[0] = penaltyBoundToInterval(vel, -cfg_->human.max_vel_x_backwards,
-                                       cfg_->human.max_vel_x,
-                                       cfg_->optim.penalty_epsilon);
-    _error[1] = penaltyBoundToInterval(omega, cfg_->human.max_vel_theta,
-                                       cfg_->optim.penalty_epsilon);
+    TebScalar vel, omega; // vel considers the direction
+    computeVelocity(conf1->pose(), conf2->pose(), deltaT->estimate(), vel,
+                    omega);
+
+    _error[0] = penaltyBoundToInterval(vel, -limits_.max_vel_x_backwards,
+                                       limits_.max_vel_x,
+                                       limits_.penalty_epsilon);
+    _error[1] = penaltyBoundToInterval(omega, limits_.max_vel_theta,
+                                       limits_.penalty_epsilon);
 
     if (cfg_->optim.use_human_elastic_vel) {
       double vel_diff = std::abs(cfg_->human.nominal_vel_x - vel);
@@ -328,10 +317,14 @@ public:
     return os.good();
   }
 
-  void setTebConfig(const TebConfig &cfg) { cfg_ = &cfg; }
+  void setTebConfig(const TebConfig &cfg) {
+    cfg_ = &cfg;
+    limits_ = KinematicLimits::human(cfg);
+  }
 
 protected:
   const TebConfig *cfg_;
+  KinematicLimits limits_;
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
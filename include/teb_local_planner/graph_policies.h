@@ -0,0 +1,129 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Copyright (c) 2016 LAAS/CNRS
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef GRAPH_POLICIES_H_
+#define GRAPH_POLICIES_H_
+
+#include <teb_local_planner/teb_config.h>
+
+namespace teb_local_planner {
+
+//! Values of TebConfig::planning_mode
+enum PlanningMode {
+  PLANNING_MODE_ROBOT = 0,       //!< Robot only
+  PLANNING_MODE_HUMAN_AWARE = 1, //!< Robot and human trajectories
+  PLANNING_MODE_APPROACH = 2     //!< Robot approaching a single human
+};
+
+//! Optional cost terms of the human-aware planning mode (bit flags)
+enum HumanTerms {
+  HUMAN_TERMS_NONE = 0,
+  HUMAN_TERM_BANDS = 1 << 0, //!< Constraints of the human bands themselves
+  HUMAN_TERM_ROBOT_SAFETY = 1 << 1, //!< optim.use_human_robot_safety_c
+  HUMAN_TERM_HUMAN_SAFETY = 1 << 2, //!< optim.use_human_human_safety_c
+  HUMAN_TERM_ROBOT_TTC = 1 << 3,    //!< optim.use_human_robot_ttc_c
+  HUMAN_TERM_ROBOT_DIR = 1 << 4,    //!< optim.use_human_robot_dir_c
+  HUMAN_TERMS_ALL = (1 << 5) - 1
+};
+
+/**
+ * @brief Check whether the robot is modeled as carlike robot, i.e. whether the
+ * turning radius is bounded from below.
+ */
+inline bool isCarlikeGraph(const TebConfig &cfg) {
+  return cfg.robot.min_turning_radius != 0 &&
+         cfg.optim.weight_kinematics_turning_radius != 0;
+}
+
+/**
+ * @brief Collect the enabled human cost terms of the configuration.
+ * @return combination of HumanTerms flags
+ */
+inline unsigned int humanGraphTerms(const TebConfig &cfg) {
+  unsigned int terms = HUMAN_TERMS_NONE;
+  // with pre-optimization the human bands are already optimized w.r.t.
+  // their own constraints, only the coupling edges are added to the graph
+  if (!cfg.optim.human_pre_optimization)
+    terms |= HUMAN_TERM_BANDS;
+  if (cfg.optim.use_human_robot_safety_c)
+    terms |= HUMAN_TERM_ROBOT_SAFETY;
+  if (cfg.optim.use_human_human_safety_c)
+    terms |= HUMAN_TERM_HUMAN_SAFETY;
+  if (cfg.optim.use_human_robot_ttc_c)
+    terms |= HUMAN_TERM_ROBOT_TTC;
+  if (cfg.optim.use_human_robot_dir_c)
+    terms |= HUMAN_TERM_ROBOT_DIR;
+  return terms;
+}
+
+/**
+ * @brief Compile-time structure of the TEB hyper-graph.
+ *
+ * The graph builders of TebOptimalPlanner query the planning mode, the
+ * kinematic model and the enabled human cost terms through a policy. For this
+ * policy all queries are constants, hence the compiler removes the branches
+ * of disabled terms.
+ * @tparam Mode planning mode (see PlanningMode)
+ * @tparam Carlike \c true for carlike, \c false for differential drive robots
+ * @tparam Terms enabled human cost terms (see HumanTerms)
+ */
+template <int Mode, bool Carlike, unsigned int Terms> struct GraphPolicy {
+  static int mode(const TebConfig &) { return Mode; }
+  static bool carlike(const TebConfig &) { return Carlike; }
+  static bool hasTerm(const TebConfig &, unsigned int term) {
+    return (Terms & term) != 0;
+  }
+};
+
+/**
+ * @brief Graph structure read from the configuration at runtime.
+ *
+ * Used for the combinations without a dedicated instantiation.
+ */
+struct RuntimeGraphPolicy {
+  static int mode(const TebConfig &cfg) { return cfg.planning_mode; }
+  static bool carlike(const TebConfig &cfg) { return isCarlikeGraph(cfg); }
+  static bool hasTerm(const TebConfig &cfg, unsigned int term) {
+    return (humanGraphTerms(cfg) & term) != 0;
+  }
+};
+
+} // namespace teb_local_planner
+
+#endif /* GRAPH_POLICIES_H_ */
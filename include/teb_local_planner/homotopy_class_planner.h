@@ -61,6 +61,8 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/random.hpp>
 #include <boost/utility.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/array.hpp>
 
 
 #include <visualization_msgs/Marker.h>
@@ -74,6 +76,10 @@
 #include <teb_local_planner/teb_config.h>
 #include <teb_local_planner/obstacles.h>
 #include <teb_local_planner/optimal_planner.h>
+#include <teb_local_planner/optimizer_pool.h>
+#include <teb_local_planner/worker_pool.h>
+#include <teb_local_planner/obstacle_snapshot.h>
+#include <teb_local_planner/obstacle_grid.h>
 #include <teb_local_planner/visualization.h>
 #include <teb_local_planner/robot_footprint_model.h>
 
@@ -103,6 +109,37 @@ typedef boost::graph_traits<HcGraph>::edge_iterator HcGraphEdgeIterator;
 //! Abbrev. for the adjacency iterator that iterates vertices that are adjecent to the specified one
 typedef boost::graph_traits<HcGraph>::adjacency_iterator HcGraphAdjecencyIterator;
 
+//! Obstacle dependent coefficients of the H-signature of paths sharing the same start and end point (see HomotopyClassPlanner::calculateHSignatureCoefficients())
+struct HSignatureCoefficients
+{
+  std::vector< std::complex<long double> > obstacles; //!< Obstacle centroids
+  std::vector< std::complex<long double> > coefficients; //!< Coefficient \f$ A_l \f$ for each obstacle
+};
+
+//! Axis-aligned bounding box of an obstacle (min x, min y, max x, max y)
+typedef boost::array<double,4> ObstacleBox;
+
+//! Samples and edge collision checks of the probabilistic roadmap that are reused in the next cycle (see HomotopyClassPlanner::createProbRoadmapGraph())
+struct ProbRoadmapCache
+{
+  ProbRoadmapCache() : area_origin(Eigen::Vector2d::Zero()), area_phi(0), area_length(0), area_width(0), next_id(0), dist_to_obst(-1), obstacles_bounded(false) {}
+  
+  Point2dContainer samples; //!< Collision free samples of the last roadmap (in the planning frame)
+  std::vector<unsigned int> ids; //!< Unique id of each sample
+  Eigen::Vector2d area_origin; //!< Bottom left corner of the last sampling area
+  double area_phi; //!< Orientation of the last sampling area
+  double area_length; //!< Length of the last sampling area (direction start to goal)
+  double area_width; //!< Width of the last sampling area
+  unsigned int next_id; //!< Id that is assigned to the next new sample
+  boost::unordered_map< std::pair<unsigned int, unsigned int>, bool > edge_collision; //!< Results of the collision checks between samples (referred to by their ids)
+  std::vector<ObstacleBox> obstacle_boxes; //!< Sorted bounding boxes of the obstacles that were used for the checks
+  double dist_to_obst; //!< Minimum distance to obstacles that was used for the checks
+  bool obstacles_bounded; //!< \c false if the checks involved obstacles of unknown type (the edges cannot be reused)
+  
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
 /**
  * @class HomotopyClassPlanner
  * @brief Local planner that explores alternative homotopy classes, create a plan for each alternative
@@ -231,11 +268,39 @@ public:
    */
   TebOptimalPlannerPtr bestTeb() const {return tebs_.empty() ? TebOptimalPlannerPtr() : tebs_.size()==1 ? tebs_.front() : best_teb_;}
 
+  /**
+   * @brief Seed the random number generator that samples the keypoints of the probabilistic roadmap.
+   *
+   * The planner behaves deterministically for identical inputs if the generator is seeded before the first cycle (e.g. for replays).
+   * @param seed Seed of the generator
+   */
+  void seedRandomGenerator(unsigned int seed) {rnd_generator_.seed(seed);}
+  
+  /**
+   * @brief Replace the time budget of the roadmap search by a fixed number of expanded vertices.
+   *
+   * The time budget \c roadmap_graph_search_time depends on the machine. A replay reproduces the recorded search
+   * by cutting it off after the number of expansions reported by getSearchExpansions() while recording.
+   * @param max_expansions Number of expanded vertices after which each search is cut off
+   *                       (\c std::numeric_limits<unsigned long>::max() to search without any limit)
+   */
+  void limitSearchExpansions(unsigned long max_expansions) {search_expansion_limit_ = max_expansions; search_expansions_limited_ = true;}
+  
+  /**
+   * @brief Number of vertices expanded by the last roadmap search (see DepthFirst())
+   * @param[out] cut_off \c true if the search has been cut off by the time budget or the expansion limit
+   *                     (and not by reaching \c max_number_classes or by exploring the whole graph)
+   * @return number of expanded vertices
+   */
+  unsigned long getSearchExpansions(bool& cut_off) const {cut_off = search_cut_off_; return search_expansions_;}
+
   /**
    * @brief Check whether the planned trajectory is feasible or not.
    *
    * This method currently checks only that the trajectory, or a part of the trajectory is collision free.
    * Obstacles are here represented as costmap instead of the internal ObstacleContainer.
+   * All candidates are checked (in parallel if multithreading is enabled). If the best candidate is not feasible,
+   * the cheapest feasible candidate is selected instead (see selectBestTeb()).
    * @param costmap_model Pointer to the costmap model
    * @param footprint_spec The specification of the footprint of the robot in world coordinates
    * @param inscribed_radius The radius of the inscribed circle of the robot
@@ -246,6 +311,14 @@ public:
    */
   virtual bool isTrajectoryFeasible(base_local_planner::CostmapModel* costmap_model, const std::vector<geometry_msgs::Point>& footprint_spec,
                                     double inscribed_radius = 0.0, double circumscribed_radius=0.0, int look_ahead_idx=-1);
+  
+  /**
+   * @brief Check the feasibility of a single candidate (task of isTrajectoryFeasible())
+   * @param idx Index of the candidate in tebs_
+   * @param[out] feasible result of TebOptimalPlanner::isTrajectoryFeasible() for each candidate in tebs_
+   */
+  void checkTebFeasibilityTask(std::size_t idx, base_local_planner::CostmapModel* costmap_model, const std::vector<geometry_msgs::Point>* footprint_spec,
+                               double inscribed_radius, double circumscribed_radius, int look_ahead_idx, std::vector<char>* feasible) const;
 
   //@}
 
@@ -329,6 +402,14 @@ public:
    * @param start_velocity start velocity (optional)
    */
   void addAndInitNewTeb(const std::vector<geometry_msgs::PoseStamped>& initial_plan, boost::optional<const Eigen::Vector2d&> start_velocity);
+
+  /**
+   * @brief Create a new candidate planner that uses an optimizer of the internal pool
+   * 
+   * The optimizer is returned to the pool as soon as the candidate is deleted.
+   * @return shared pointer to the initialized TebOptimalPlanner
+   */
+  TebOptimalPlannerPtr createCandidatePlanner();
   
   /**
    * @brief Update TEBs with new pose, goal and current velocity.
@@ -342,16 +423,62 @@ public:
   /**
    * @brief Optimize all available trajectories by invoking the optimizer on each one.
    * 
-   * Depending on the configuration parameters, the optimization is performed either single or multi threaded.
+   * Depending on the configuration parameters, the optimization is performed either single or multi threaded. \n
+   * If hcp.selection_early_abort is enabled, the candidates are compared after half of the outer iterations:
+   * a candidate is not optimized any further if its cost without the time, obstacle and via-point terms
+   * (see selectionCostLowerBound()) exceeds the cost of the incumbent (best_teb_ scaled by the selection hysteresis,
+   * or the cheapest candidate otherwise). The saved outer iterations are distributed among the remaining candidates.
+   * Stopped candidates are resumed if their bound does not exceed the final cost of the incumbent.
    * @param iter_innerloop Number of inner iterations (see TebOptimalPlanner::optimizeTEB())
    * @param iter_outerloop Number of outer iterations (see TebOptimalPlanner::optimizeTEB())
    */
   void optimizeAllTEBs(unsigned int iter_innerloop, unsigned int iter_outerloop);
   
+  /**
+   * @brief Perform the outer iterations \c first ... \c last-1 of some candidates (in parallel if enabled, see optimizeAllTEBs())
+   * 
+   * The cost of each candidate is computed after its last iteration.
+   * @param candidates Indices of the candidates in tebs_
+   * @param first Index of the first outer iteration
+   * @param last Index of the outer iteration after the last one
+   * @param iter_innerloop Number of inner iterations
+   * @param iter_outerloop Nominal number of outer iterations
+   * @param[in,out] success result of TebOptimalPlanner::optimizeTEBIteration() for each candidate in tebs_ (only failed candidates are skipped)
+   */
+  void optimizeTebIterations(const std::vector<std::size_t>& candidates, unsigned int first, unsigned int last,
+                             unsigned int iter_innerloop, unsigned int iter_outerloop, std::vector<char>& success);
+  
+  /**
+   * @brief Perform outer iterations of a single candidate (task of optimizeTebIterations())
+   */
+  void optimizeTebIterationsTask(const std::vector<std::size_t>* candidates, std::size_t idx, unsigned int first, unsigned int last,
+                                 unsigned int iter_innerloop, unsigned int iter_outerloop, std::vector<char>* success) const;
+  
+  /**
+   * @brief Lower bound of the selection cost of a candidate used by optimizeAllTEBs()
+   * 
+   * The optimizer trades the transition time off against the distances to obstacles and via-points, hence these terms
+   * are set to their minimum (zero). The remaining terms (penalties of the kinematic and dynamic limits and of the
+   * human-aware objectives) are assumed not to vanish within the remaining iterations.
+   * @param teb Candidate planner with a valid cost (see TebOptimalPlanner::computeCurrentCost())
+   * @return lower bound of the cost
+   */
+  double selectionCostLowerBound(const TebOptimalPlanner& teb) const;
+  
+  /**
+   * @brief Cost that must be beaten by a candidate in order to be selected (see selectBestTeb())
+   * @param candidates Indices of the candidates in tebs_ that are compared
+   * @param incumbent Index of the previously selected candidate in tebs_ or -1
+   * @param[out] best Index of the candidate defining the cost or -1
+   * @return cost of the incumbent scaled by the selection hysteresis, otherwise the minimum cost of the candidates
+   */
+  double selectionCostToBeat(const std::vector<std::size_t>& candidates, int incumbent, int& best) const;
+  
   /**
    * @brief In case of multiple, internally stored, alternative trajectories, select the best one according to their cost values.
    * 
    * The trajectory cost includes features such as transition time and clearance from obstacles. \n
+   * Candidates that failed the last feasibility check (see isTrajectoryFeasible()) are skipped. \n
    * The best trajectory can be accessed later by bestTeb() within the current sampling interval in order to avoid unessary recalculations.
    * @return Shared pointer to the best TebOptimalPlanner that contains the selected trajectory (TimedElasticBand).
    */
@@ -364,7 +491,7 @@ public:
     * 
     * Clear all previously found H-signatures, paths, tebs and the hcgraph.
     */
-  void clearPlanner() {graph_.clear(); h_signatures_.clear(); tebs_.clear(); initial_plan_ = NULL;}
+  void clearPlanner() {graph_.clear(); clearHSignatures(); tebs_.clear(); initial_plan_ = NULL; roadmap_cache_ = ProbRoadmapCache();}
   
   /**
    * @brief Check if the planner suggests a shorter horizon (e.g. to resolve problems)
@@ -404,6 +531,57 @@ public:
   template<typename BidirIter, typename Fun>
   static std::complex<long double> calculateHSignature(BidirIter path_start, BidirIter path_end, Fun fun_cplx_point, const ObstContainer* obstacles = NULL, double prescaler = 1);
   
+  /**
+   * @brief Compute the obstacle dependent coefficients of the H-signature.
+   * 
+   * The H-signature of a path is the sum of the contributions of its segments (see calculateHSignatureSegment()).
+   * The coefficients only depend on the obstacles and on the first and last point of the path,
+   * hence they can be shared by all paths between the same start and goal (e.g. during the graph search).
+   * @param path_start First point of the path
+   * @param path_end Last point of the path
+   * @param obstacles obstacle container
+   * @param prescaler Change this value only if you observe problems with an huge amount of obstacles: interval (0,1]
+   * @param[out] coeffs resulting coefficients
+   */
+  static void calculateHSignatureCoefficients(const std::complex<long double>& path_start, const std::complex<long double>& path_end,
+                                              const ObstContainer* obstacles, double prescaler, HSignatureCoefficients& coeffs);
+  
+  /**
+   * @brief Compute the obstacle dependent coefficients of the H-signature (uses the precomputed centroids of a snapshot).
+   * @see calculateHSignatureCoefficients(const std::complex<long double>&, const std::complex<long double>&, const ObstContainer*, double, HSignatureCoefficients&)
+   */
+  static void calculateHSignatureCoefficients(const std::complex<long double>& path_start, const std::complex<long double>& path_end,
+                                              const ObstacleSnapshot& obstacles, double prescaler, HSignatureCoefficients& coeffs);
+  
+  /**
+   * @brief Compute the contribution of a single path segment to the H-signature
+   * @param z1 Start of the segment
+   * @param z2 End of the segment
+   * @param coeffs coefficients obtained with calculateHSignatureCoefficients()
+   * @return complex H-signature value of the segment
+   */
+  static std::complex<long double> calculateHSignatureSegment(const std::complex<long double>& z1, const std::complex<long double>& z2,
+                                                              const HSignatureCoefficients& coeffs);
+  
+  /**
+   * @brief Compute the H-signatures of several paths at once (e.g. of all candidate trajectories)
+   * 
+   * The paths are passed as flat arrays of point coordinates (structure of arrays).
+   * The log values of the segments telescope, hence only the crossings of the branch cut are counted per segment
+   * (within loops over the obstacles that the compiler can vectorize) and the logarithms are evaluated once per obstacle.
+   * The rounding error of each path is estimated from the magnitude of the summands: paths for which the estimate
+   * exceeds \c tolerance (ill-conditioned cases) are recomputed in long double precision with calculateHSignatureSegment().
+   * @param x x-coordinates of the points of all paths
+   * @param y y-coordinates of the points of all paths
+   * @param path_offsets Index of the first point of each path in \c x and \c y followed by the total number of points
+   * @param obstacles obstacle snapshot
+   * @param prescaler Change this value only if you observe problems with an huge amount of obstacles: interval (0,1]
+   * @param tolerance Admissible absolute error of the double precision result
+   * @param[out] H complex H-signature value of each path
+   */
+  static void calculateHSignatures(const std::vector<double>& x, const std::vector<double>& y, const std::vector<std::size_t>& path_offsets,
+                                   const ObstacleSnapshot& obstacles, double prescaler, double tolerance, std::vector< std::complex<long double> >& H);
+  
   /**
    * @brief Read-only access to the internal trajectory container.
    * @return read-only reference to the teb container.
@@ -466,6 +644,9 @@ protected:
    * This version of the graph samples keypoints in a predefined area (config) in the current frame between start and goal. \n
    * Afterwards all feasible paths between start and goal point are extracted using a Depth First Search. \n
    * Use the sampling method for complex, non-point or huge obstacles. \n
+   * Samples of the previous roadmap that are still inside the area and collision free are kept, new samples are
+   * preferably drawn in the newly uncovered part of the area. Collision checks of edges between kept samples are reused
+   * unless an obstacle changed in their vicinity (see roadmap_cache_). \n
    * You may call createGraph() instead.
    * 
    * @see createGraph
@@ -478,6 +659,47 @@ protected:
    */  
   void createProbRoadmapGraph(const PoseSE2& start, const PoseSE2& goal, double dist_to_obst, int no_samples, double obstacle_heading_threshold, boost::optional<const Eigen::Vector2d&> start_velocity);
   
+  /**
+   * @brief Add all collision free edges to the graph.
+   * 
+   * The collision checks are distributed among multiple threads if multithreading is enabled.
+   * The broad phase obstacle_grid_ must be up to date.
+   * @param candidate_edges Pairs of vertices (source, target) that should be connected if the line segment is collision free
+   * @param min_dist Minimum distance allowed to the obstacles
+   * @param[in,out] collision Optional collision flag for each candidate edge: entries 0 and 1 are known results,
+   *                          all other values are checked. Contains the results of all candidate edges afterwards.
+   */
+  void addCollisionFreeEdges(const std::vector< std::pair<HcGraphVertexType,HcGraphVertexType> >& candidate_edges, double min_dist,
+                             std::vector<char>* collision = NULL);
+  
+  /**
+   * @brief Check a range of candidate edges for collisions (see addCollisionFreeEdges())
+   * @param candidate_edges Pairs of vertices (source, target)
+   * @param min_dist Minimum distance allowed to the obstacles
+   * @param indices Indices of the candidate edges that require a check
+   * @param begin First entry of \c indices to check
+   * @param end Entry of \c indices after the last one to check
+   * @param[out] collision Collision flag for each candidate edge (only the entries referred to by \c indices [begin, end) are written)
+   */
+  void checkEdgesCollision(const std::vector< std::pair<HcGraphVertexType,HcGraphVertexType> >& candidate_edges, double min_dist,
+                           const std::vector<std::size_t>& indices, std::size_t begin, std::size_t end, std::vector<char>* collision) const;
+  
+  /**
+   * @brief Check the share \c chunk of the candidate edges for collisions (task of addCollisionFreeEdges())
+   * @param chunk Index of the share
+   * @param no_chunks Total number of shares
+   * @see checkEdgesCollision()
+   */
+  void checkEdgesCollisionTask(const std::vector< std::pair<HcGraphVertexType,HcGraphVertexType> >* candidate_edges, double min_dist,
+                               const std::vector<std::size_t>* indices, std::size_t chunk, std::size_t no_chunks, std::vector<char>* collision) const;
+  
+  /**
+   * @brief Compute the sorted bounding boxes of all obstacles in obstacle_snapshot_ (see ProbRoadmapCache)
+   * @param[out] boxes Bounding boxes of all obstacles of known type
+   * @return \c false if at least one obstacle is of unknown type
+   */
+  bool computeObstacleBoxes(std::vector<ObstacleBox>& boxes) const;
+  
   /**
    * @brief Check if a h-signature exists already.
    * @param H h-signature that should be tested
@@ -485,6 +707,28 @@ protected:
    */ 
   bool hasHSignature(const std::complex<long double>& H) const;
   
+  /**
+   * @brief Remove all known h-signatures (including the lookup buckets)
+   */
+  void clearHSignatures();
+  
+  /**
+   * @brief Rebuild the h-signature buckets if the h-signature threshold has been changed
+   */
+  void updateHSignatureBuckets();
+  
+  //! Bucket of the h-signature lookup (quantized real and imaginary part)
+  typedef std::pair<long long, long long> HSignatureBucket;
+  //! Indices of h_signatures_ per bucket
+  typedef boost::unordered_map< HSignatureBucket, std::vector<std::size_t> > HSignatureBucketMap;
+  
+  /**
+   * @brief Get the bucket of an h-signature w.r.t. the current bucket size
+   * @param H h-signature
+   * @return quantized real and imaginary part
+   */
+  HSignatureBucket hSignatureBucket(const std::complex<long double>& H) const;
+  
   /**
    * @brief Internal helper function that adds a h-signature to the list of known h-signatures only if it is unique.
    * @param H h-signature that should be tested
@@ -518,6 +762,10 @@ protected:
    * @brief Depth First Search implementation to find all paths between the start and the specified goal vertex.
    * 
    * Complete paths are stored to the internal path container.
+   * The H-signature is accumulated along the current path prefix, neighbours are expanded in the order of the
+   * estimated path length via the neighbour towards the goal. The search stops as soon as \c max_number_classes
+   * trajectories exist or the time budget \c roadmap_graph_search_time is exhausted (or the expansion limit is
+   * reached, see limitSearchExpansions()).
    * @sa http://www.technical-recipes.com/2011/a-recursive-algorithm-to-find-all-paths-between-two-given-nodes/
    * @param g Graph on which the depth first should be performed
    * @param visited A container that stores visited vertices (pass an empty container, it will be filled inside during recursion).
@@ -528,6 +776,24 @@ protected:
    */
   void DepthFirst(HcGraph& g, std::vector<HcGraphVertexType>& visited, const HcGraphVertexType& goal,
                   double start_orientation, double goal_orientation, boost::optional<const Eigen::Vector2d&> start_velocity);
+  
+  /**
+   * @brief Recursion step of DepthFirst()
+   * @param g Graph on which the depth first should be performed
+   * @param visited Vertices of the current path prefix
+   * @param visited_flags Visited flag for each vertex of \c g (consistent with \c visited)
+   * @param h_prefix H-signature of the current path prefix
+   * @param h_coeffs H-signature coefficients of all paths between start and goal
+   * @param goal Desired goal vertex
+   * @param deadline Wall time at which the search is aborted (zero disables the limit)
+   * @param start_orientation Orientation of the first trajectory pose, required to initialize the trajectory/TEB
+   * @param goal_orientation Orientation of the goal trajectory pose, required to initialize the trajectory/TEB
+   * @param start_velocity start velocity (optional)
+   * @return \c false if the search should be aborted (enough classes found, time budget exhausted or expansion limit reached)
+   */
+  bool DepthFirstStep(HcGraph& g, std::vector<HcGraphVertexType>& visited, std::vector<bool>& visited_flags, const std::complex<long double>& h_prefix,
+                      const HSignatureCoefficients& h_coeffs, const HcGraphVertexType& goal, const ros::WallTime& deadline,
+                      double start_orientation, double goal_orientation, boost::optional<const Eigen::Vector2d&> start_velocity);
  
   /**
    * @brief Clear any existing graph of the homotopy class search
@@ -557,14 +823,28 @@ protected:
   const std::vector<geometry_msgs::PoseStamped>* initial_plan_; //!< Store the initial plan if available for a better trajectory initialization
   std::complex<long double> initial_plan_h_sig_; //!< Store the h_signature of the initial plan
   
+  ObstacleSnapshot obstacle_snapshot_; //!< Flat copy of the obstacles that is shared by all candidates (rebuilt in each plan() call)
+  ObstacleGrid obstacle_grid_; //!< Broad phase for the collision checks during the roadmap creation (rebuilt in createGraph() and createProbRoadmapGraph())
+  ProbRoadmapCache roadmap_cache_; //!< Samples and collision checks of the last probabilistic roadmap (see createProbRoadmapGraph())
+  
   TebOptPlannerContainer tebs_; //!< Container that stores multiple local teb planners (for alternative homotopy classes) and their corresponding costs
+  std::set<const TebOptimalPlanner*> infeasible_tebs_; //!< Candidates that failed the feasibility check in the current cycle
+  OptimizerPool optimizer_pool_; //!< Pre-initialized optimizers that are shared by the candidate planners in tebs_
+  WorkerPool worker_pool_; //!< Persistent threads optimizing the candidates (see optimizeAllTEBs())
   
   HcGraph graph_; //!< Store the graph that is utilized to find alternative homotopy classes.
  
   std::vector< std::pair<std::complex<long double>, bool> > h_signatures_; //!< Store all known h-signatures to allow checking for duplicates after finding and adding new ones. 
 									  //   The second parameter denotes whether to exclude the h-signature from detour deletion or not (true: keep).
+  HSignatureBucketMap h_signature_buckets_; //!< Spatial hash of h_signatures_ with cell size h_signature_threshold (neighbouring cells contain all similar h-signatures)
+  double h_signature_bucket_size_; //!< Cell size of h_signature_buckets_ (0 if the buckets are not used)
   
   boost::random::mt19937 rnd_generator_; //!< Random number generator used by createProbRoadmapGraph to sample graph keypoints.   
+  
+  unsigned long search_expansions_; //!< Number of vertices expanded by the last roadmap search
+  bool search_cut_off_; //!< The last roadmap search has been cut off by the time budget or the expansion limit
+  unsigned long search_expansion_limit_; //!< Expansions after which the search is cut off (see limitSearchExpansions())
+  bool search_expansions_limited_; //!< Use search_expansion_limit_ instead of the time budget
       
   bool initialized_; //!< Keeps track about the correct initialization of this class
   
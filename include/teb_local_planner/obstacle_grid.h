@@ -0,0 +1,120 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************/
+
+#ifndef OBSTACLE_GRID_H_
+#define OBSTACLE_GRID_H_
+
+#include <vector>
+
+#include <teb_local_planner/obstacle_snapshot.h>
+
+
+namespace teb_local_planner
+{
+
+/**
+ * @class ObstacleGrid
+ * @brief Uniform grid over the axis-aligned bounding boxes of an obstacle snapshot (broad phase for collision checks).
+ * 
+ * Point, line and polygon obstacles are registered in all cells overlapped by their bounding box.
+ * Obstacles of unknown type are checked for every query.
+ * The grid stores a pointer to the obstacle snapshot, hence rebuild it whenever the snapshot changes.
+ * All query methods are const and can be called from multiple threads concurrently.
+ */
+class ObstacleGrid
+{
+public:
+  
+  /**
+   * @brief Construct an empty grid
+   */
+  ObstacleGrid();
+  
+  /**
+   * @brief (Re-)build the grid for the given obstacles
+   * @param obstacles Obstacle snapshot (must outlive the grid or the next call to build())
+   * @param cell_size Desired edge length of a cell, it is increased if the number of cells would exceed an internal limit
+   */
+  void build(const ObstacleSnapshot* obstacles, double cell_size);
+  
+  /**
+   * @brief Check if a point collides with any obstacle (see Obstacle::checkCollision())
+   * @param point 2D reference position
+   * @param min_dist Minimum distance allowed to the obstacles
+   * @return \c true if the point is in collision
+   */
+  bool checkCollision(const Eigen::Vector2d& point, double min_dist) const;
+  
+  /**
+   * @brief Check if a line segment intersects with any obstacle (see Obstacle::checkLineIntersection())
+   * @param line_start 2D point for the start of the line segment
+   * @param line_end 2D point for the end of the line segment
+   * @param min_dist Minimum distance allowed to the obstacles
+   * @return \c true if the line segment intersects with at least one obstacle
+   */
+  bool checkLineIntersection(const Eigen::Vector2d& line_start, const Eigen::Vector2d& line_end, double min_dist) const;
+  
+  /**
+   * @brief Collect the indices of all obstacles whose bounding box might overlap the given box
+   * @param box_min lower left corner of the query box
+   * @param box_max upper right corner of the query box
+   * @param[out] candidates sorted obstacle indices without duplicates (unknown obstacle types are not included)
+   */
+  void queryBox(const Eigen::Vector2d& box_min, const Eigen::Vector2d& box_max, std::vector<unsigned int>& candidates) const;
+  
+protected:
+  
+  /**
+   * @brief Convert a coordinate to a (clamped) cell index along one axis
+   */
+  int cellIndex(double coord, int axis) const;
+  
+  const ObstacleSnapshot* obstacles_; //!< Obstacles registered in the grid
+  Eigen::Vector2d origin_; //!< Lower left corner of the grid
+  double cell_size_; //!< Edge length of a cell
+  int cells_x_; //!< Number of cells along x
+  int cells_y_; //!< Number of cells along y
+  std::vector< std::vector<unsigned int> > cells_; //!< Obstacle indices per cell (row-major)
+  std::vector<unsigned int> unbounded_; //!< Obstacles of unknown type (checked for every query)
+  
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+} // namespace teb_local_planner
+
+#endif /* OBSTACLE_GRID_H_ */
@@ -0,0 +1,240 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************/
+
+#ifndef OBSTACLE_SNAPSHOT_H_
+#define OBSTACLE_SNAPSHOT_H_
+
+#include <vector>
+
+#include <teb_local_planner/obstacles.h>
+
+
+namespace teb_local_planner
+{
+
+/**
+ * @class ObstacleSnapshot
+ * @brief Immutable, flat copy of the obstacle container that is shared by all planners within a planning cycle.
+ * 
+ * The snapshot stores raw pointers to the obstacles (the container keeps ownership), their centroids and
+ * axis-aligned bounding boxes as well as a contiguous array per obstacle type (points, lines and polygons).
+ * Hot loops iterate the snapshot instead of the container of shared pointers and do not need any virtual call
+ * or dynamic_cast to access centroids, bounding boxes or the geometry.
+ * The snapshot must be rebuilt whenever the obstacle container changes (usually once per cycle). 
+ * Each obstacle is tagged with its type and its index within the corresponding array, such that distances
+ * can be computed by non-virtual kernels (see getMinimumDistance()). Obstacles of unknown type fall back
+ * to the virtual methods of the Obstacle class.
+ * All query methods are const and can be called from multiple threads concurrently.
+ */
+class ObstacleSnapshot
+{
+public:
+  
+  //! Type tag of an obstacle within the snapshot
+  enum ObstacleType
+  {
+    POINT_OBSTACLE,
+    LINE_OBSTACLE,
+    POLYGON_OBSTACLE,
+    UNKNOWN_OBSTACLE
+  };
+  
+  /**
+   * @brief Construct an empty snapshot
+   */
+  ObstacleSnapshot();
+  
+  /**
+   * @brief (Re-)build the snapshot for the given obstacles
+   * @param obstacles Obstacle container (the obstacles must outlive the snapshot or the next call to build())
+   */
+  void build(const ObstContainer* obstacles);
+  
+  /**
+   * @brief Remove all obstacles from the snapshot
+   */
+  void clear();
+  
+  //! Number of obstacles
+  std::size_t size() const {return obstacles_.size();}
+  
+  //! Check if the snapshot contains any obstacle
+  bool empty() const {return obstacles_.empty();}
+  
+  //! Access the obstacle with index \c idx (same index as in the source container)
+  const Obstacle* obstacle(std::size_t idx) const {return obstacles_[idx];}
+  
+  //! Access all obstacles
+  const std::vector<const Obstacle*>& obstacles() const {return obstacles_;}
+  
+  //! Centroid of the obstacle with index \c idx
+  const Eigen::Vector2d& centroid(std::size_t idx) const {return centroids_[idx];}
+  
+  //! Centroids of all obstacles
+  const Point2dContainer& centroids() const {return centroids_;}
+  
+  //! Check if the obstacle with index \c idx has a bounding box (false for obstacles of unknown type)
+  bool hasBoundingBox(std::size_t idx) const {return bounded_[idx];}
+  
+  //! Lower left corner of the bounding box of the obstacle with index \c idx
+  const Eigen::Vector2d& boxMin(std::size_t idx) const {return box_min_[idx];}
+  
+  //! Upper right corner of the bounding box of the obstacle with index \c idx
+  const Eigen::Vector2d& boxMax(std::size_t idx) const {return box_max_[idx];}
+  
+  //! Type of the obstacle with index \c idx
+  ObstacleType type(std::size_t idx) const {return type_[idx];}
+  
+  //! Index of the obstacle \c idx within the array of its type (e.g. pointPositions() for point obstacles)
+  unsigned int typeIndex(std::size_t idx) const {return type_idx_[idx];}
+  
+  /**
+   * @brief Compute the minimum distance between a point and an obstacle (see Obstacle::getMinimumDistance())
+   * @param idx Index of the obstacle
+   * @param position 2d reference position
+   * @return The nearest possible distance to the obstacle
+   */
+  double getMinimumDistance(std::size_t idx, const Eigen::Vector2d& position) const
+  {
+    unsigned int k = type_idx_[idx];
+    switch (type_[idx])
+    {
+      case POINT_OBSTACLE:
+        return (position - point_pos_[k]).norm();
+      case LINE_OBSTACLE:
+        return distance_point_to_segment_2d(position, line_start_[k], line_end_[k]);
+      case POLYGON_OBSTACLE:
+        return distance_point_to_polygon_2d(position, polygonVertices(k), polygonSize(k));
+      default:
+        return obstacles_[idx]->getMinimumDistance(position);
+    }
+  }
+  
+  /**
+   * @brief Compute the minimum distance between a line segment and an obstacle (see Obstacle::getMinimumDistance())
+   * @param idx Index of the obstacle
+   * @param line_start 2d position of the begin of the line segment
+   * @param line_end 2d position of the end of the line segment
+   * @return The nearest possible distance to the obstacle
+   */
+  double getMinimumDistance(std::size_t idx, const Eigen::Vector2d& line_start, const Eigen::Vector2d& line_end) const
+  {
+    unsigned int k = type_idx_[idx];
+    switch (type_[idx])
+    {
+      case POINT_OBSTACLE:
+        return distance_point_to_segment_2d(point_pos_[k], line_start, line_end);
+      case LINE_OBSTACLE:
+        return distance_segment_to_segment_2d(line_start_[k], line_end_[k], line_start, line_end);
+      case POLYGON_OBSTACLE:
+        return distance_segment_to_polygon_2d(line_start, line_end, polygonVertices(k), polygonSize(k));
+      default:
+        return obstacles_[idx]->getMinimumDistance(line_start, line_end);
+    }
+  }
+  
+  //! Indices of all static obstacles
+  const std::vector<unsigned int>& staticIndices() const {return static_idx_;}
+  
+  //! Indices of all dynamic obstacles
+  const std::vector<unsigned int>& dynamicIndices() const {return dynamic_idx_;}
+  
+  //! Indices of all point obstacles
+  const std::vector<unsigned int>& pointIndices() const {return point_idx_;}
+  
+  //! Positions of all point obstacles (same order as pointIndices())
+  const Point2dContainer& pointPositions() const {return point_pos_;}
+  
+  //! Indices of all line obstacles
+  const std::vector<unsigned int>& lineIndices() const {return line_idx_;}
+  
+  //! Start points of all line obstacles (same order as lineIndices())
+  const Point2dContainer& lineStarts() const {return line_start_;}
+  
+  //! End points of all line obstacles (same order as lineIndices())
+  const Point2dContainer& lineEnds() const {return line_end_;}
+  
+  //! Indices of all polygon obstacles
+  const std::vector<unsigned int>& polygonIndices() const {return polygon_idx_;}
+  
+  //! Offsets of the vertices of each polygon obstacle in polygonVertices() followed by the total number of vertices
+  const std::vector<unsigned int>& polygonVertexOffsets() const {return polygon_offsets_;}
+  
+  //! Vertices of all polygon obstacles
+  const Point2dContainer& polygonVertices() const {return polygon_vertices_;}
+  
+  //! Pointer to the first vertex of the polygon obstacle with type index \c k (not dereferenceable for polygons without vertices)
+  const Eigen::Vector2d* polygonVertices(unsigned int k) const {return polygon_vertices_.data() + polygon_offsets_[k];}
+  
+  //! Number of vertices of the polygon obstacle with type index \c k
+  std::size_t polygonSize(unsigned int k) const {return polygon_offsets_[k+1] - polygon_offsets_[k];}
+  
+  //! Indices of all obstacles of unknown type
+  const std::vector<unsigned int>& unknownIndices() const {return unknown_idx_;}
+  
+  /**
+   * @brief Compute the axis-aligned bounding box of an obstacle
+   * @return \c false if the obstacle type is unknown
+   */
+  static bool boundingBox(const Obstacle& obstacle, Eigen::Vector2d& box_min, Eigen::Vector2d& box_max);
+  
+protected:
+  
+  std::vector<const Obstacle*> obstacles_; //!< Obstacles in the order of the source container
+  Point2dContainer centroids_; //!< Centroid of each obstacle
+  Point2dContainer box_min_; //!< Lower left corner of the bounding box of each obstacle
+  Point2dContainer box_max_; //!< Upper right corner of the bounding box of each obstacle
+  std::vector<char> bounded_; //!< Flag for each obstacle if the bounding box is valid
+  std::vector<ObstacleType> type_; //!< Type of each obstacle
+  std::vector<unsigned int> type_idx_; //!< Index of each obstacle within the array of its type
+  std::vector<unsigned int> static_idx_; //!< Indices of the static obstacles
+  std::vector<unsigned int> dynamic_idx_; //!< Indices of the dynamic obstacles
+  
+  std::vector<unsigned int> point_idx_; //!< Indices of the point obstacles
+  Point2dContainer point_pos_; //!< Positions of the point obstacles
+  std::vector<unsigned int> line_idx_; //!< Indices of the line obstacles
+  Point2dContainer line_start_; //!< Start points of the line obstacles
+  Point2dContainer line_end_; //!< End points of the line obstacles
+  std::vector<unsigned int> polygon_idx_; //!< Indices of the polygon obstacles
+  std::vector<unsigned int> polygon_offsets_; //!< Vertex offsets of the polygon obstacles
+  Point2dContainer polygon_vertices_; //!< Vertices of all polygon obstacles
+  std::vector<unsigned int> unknown_idx_; //!< Indices of the obstacles of unknown type
+};
+
+} // namespace teb_local_planner
+
+#endif /* OBSTACLE_SNAPSHOT_H_ */
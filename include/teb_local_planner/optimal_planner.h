@@ -52,6 +52,12 @@
 #include <teb_local_planner/planner_interface.h>
 #include <teb_local_planner/visualization.h>
 #include <teb_local_planner/robot_footprint_model.h>
+#include <teb_local_planner/distance_calculations.h>
+#include <teb_local_planner/obstacle_snapshot.h>
+#include <teb_local_planner/parallel_block_solver.h>
+#include <teb_local_planner/worker_pool.h>
+#include <teb_local_planner/graph_policies.h>
+#include <teb_local_planner/trajectory_export.h>
 
 // g2o lib stuff
 #include "g2o/core/sparse_optimizer.h"
@@ -83,6 +89,7 @@
 
 #include <nav_msgs/Odometry.h>
 #include <limits.h>
+#include <set>
 
 namespace teb_local_planner {
 
@@ -166,6 +173,35 @@ public:
                   const std::map<uint64_t, ViaPointContainer>
                       *humans_via_points_map = NULL);
 
+  /**
+   * @brief Use an existing optimizer instead of allocating a new one.
+   *
+   * Call this method before initialize(). The graph of \c optimizer must be
+   * empty. This allows to share pre-initialized optimizers (see
+   * OptimizerPool).
+   * @param optimizer shared pointer to an initialized g2o::SparseOptimizer
+   * (see initOptimizer())
+   */
+  void setOptimizer(boost::shared_ptr<g2o::SparseOptimizer> optimizer) {
+    optimizer_ = optimizer;
+  }
+
+  /**
+   * @brief Initialize and configure the g2o sparse optimizer.
+   * @return shared pointer to the g2o::SparseOptimizer instance
+   */
+  static boost::shared_ptr<g2o::SparseOptimizer> initOptimizer();
+
+  /**
+   * @brief Set the number of threads linearizing the edges of \c optimizer.
+   *
+   * Only affects optimizers created by initOptimizer() (see
+   * ParallelBlockSolver).
+   * @param optimizer optimizer created by initOptimizer()
+   * @param num_threads number of threads (< 2: serial linearization)
+   */
+  static void setEdgeThreads(g2o::SparseOptimizer *optimizer, int num_threads);
+
   /** @name Plan a trajectory  */
   //@{
 
@@ -306,6 +342,38 @@ public:
                    double viapoint_cost_scale = 1.0,
                    bool alternative_time_cost = false);
 
+  /**
+   * @brief Perform a single outer loop iteration of optimizeTEB().
+   *
+   * Calling this method for \c iteration = 0 ... \c iterations_outerloop-1
+   * is equivalent to optimizeTEB(), but allows to inspect the intermediate
+   * cost between the iterations (e.g. to stop the optimization early).
+   * The first iteration resets the optimization state and pre-optimizes the
+   * human trajectories (if enabled).
+   * @param iteration Index of the outer loop iteration
+   * @param iterations_innerloop Number of iterations for the actual solver loop
+   * @param iterations_outerloop Total number of outer loop iterations (used for
+   * the human pre-optimization)
+   * @param compute_cost if \c true Calculate the cost vector after this
+   * iteration according to computeCurrentCost()
+   * @param obst_cost_scale Specify extra scaling for obstacle costs (only used
+   * if \c compute_cost is true)
+   * @param viapoint_cost_scale Specify extra scaling for via-point costs (only
+   * used if \c compute_cost is true)
+   * @param alternative_time_cost Replace the cost for the time optimal
+   * objective by the actual (weighted) transition time
+   *          (only used if \c compute_cost is true).
+   * @return \c true if the iteration terminates successfully, \c false
+   * otherwise (further iterations should not be performed)
+   */
+  bool optimizeTEBIteration(unsigned int iteration,
+                            unsigned int iterations_innerloop,
+                            unsigned int iterations_outerloop,
+                            bool compute_cost = false,
+                            double obst_cost_scale = 1.0,
+                            double viapoint_cost_scale = 1.0,
+                            bool alternative_time_cost = false);
+
   //@}
 
   /** @name Desired initial and final velocity */
@@ -367,6 +435,28 @@ public:
    */
   const ObstContainer &getObstVector() const { return *obstacles_; }
 
+  /**
+   * @brief Share an obstacle snapshot of the current obstacle container (e.g.
+   * between the candidates of the HomotopyClassPlanner).
+   *
+   * The owner must rebuild the snapshot whenever the obstacle container
+   * changes. Without a shared snapshot, the planner builds its own at the
+   * beginning of each optimization.
+   * @param snapshot pointer to the snapshot (NULL to use an internal one)
+   */
+  void setObstacleSnapshot(const ObstacleSnapshot *snapshot) {
+    shared_obstacle_snapshot_ = snapshot;
+  }
+
+  /**
+   * @brief Access the obstacle snapshot used for building the graph.
+   * @return Const reference to the shared or internal snapshot
+   */
+  const ObstacleSnapshot &obstacleSnapshot() const {
+    return shared_obstacle_snapshot_ ? *shared_obstacle_snapshot_
+                                     : obstacle_snapshot_;
+  }
+
   //@}
 
   /** @name Take via-points into account */
@@ -421,6 +511,7 @@ public:
   virtual void clearPlanner() {
     clearGraph();
     teb_.clearTimedElasticBand();
+    trajectory_export_valid_ = false;
   }
 
   /**
@@ -535,6 +626,17 @@ public:
    */
   double getCurrentCost() const { return cost_; }
 
+  /**
+   * @brief Access the unscaled cost of an edge family.
+   *
+   * The value is calculated by computeCurrentCost() as well.
+   * @param family Edge family
+   * @return accumulated squared errors of the edges of the family
+   */
+  double getCurrentCost(TelemetryCost family) const {
+    return cost_families_[family];
+  }
+
   /**
    * @brief Extract the velocity from consecutive poses and a time difference
    *
@@ -596,6 +698,31 @@ public:
   getFullHumanTrajectory(const uint64_t human_id,
                          std::vector<TrajectoryPointMsg> &human_trajectory);
 
+  /**
+   * @brief Access the robot and human trajectories of the current cycle.
+   *
+   * The export is computed on the first access after an optimization and then
+   * shared by all consumers (see getFullTrajectory()). The returned buffer is
+   * never modified afterwards; a later cycle writes to a new buffer if the
+   * previous one is still referenced.
+   * @return shared immutable trajectory export
+   */
+  TrajectoryExportConstPtr getTrajectoryExport() const;
+
+  /**
+   * @brief Append the current cycle to a telemetry log.
+   *
+   * The record contains the robot and human bands, the obstacles, the costs
+   * per edge family of the last computeCurrentCost() call and the number of
+   * solver iterations of the last optimizeTEB() call.
+   * @param recorder opened telemetry recorder
+   * @param phase_times durations of the phases of the cycle (see
+   * TelemetryPhase)
+   * @return \c false if the record has been dropped
+   */
+  bool recordTelemetry(TelemetryRecorder &recorder,
+                       const double (&phase_times)[TELEMETRY_PHASES]) const;
+
   /**
    * @brief Check whether the planned trajectory is feasible or not.
    *
@@ -664,6 +791,16 @@ protected:
    */
   bool buildGraph();
 
+  /**
+   * @brief Build the hyper-graph for a fixed graph structure.
+   *
+   * buildGraph() dispatches to the instantiation matching the planning mode,
+   * the kinematic model and the enabled human cost terms.
+   * @tparam Policy graph structure (see GraphPolicy and RuntimeGraphPolicy)
+   * @return \c true, if the graph was created successfully
+   */
+  template <typename Policy> bool buildGraphWith();
+
   /**
    * @brief Optimize the previously constructed hyper-graph to deform / optimize
    * the TEB.
@@ -690,6 +827,82 @@ protected:
    */
   void clearGraph();
 
+  /**
+   * @brief Keep the cached time prefix of a band up to date during the
+   * optimization of \c optimizer (required by EdgeDynamicObstacle).
+   * @param optimizer optimizer containing time dependent edges of \c teb
+   * @param teb trajectory whose prefix is refreshed before errors are computed
+   * @see TimedElasticBand::timePrefixAction
+   */
+  void addTimePrefixAction(g2o::SparseOptimizer *optimizer,
+                           TimedElasticBand &teb);
+
+  /**
+   * @brief Adapt the temporal resolution of a band to trajectory.dt_ref.
+   *
+   * Depending on trajectory.teb_autosize_resample the band is either resampled
+   * in a single pass (TimedElasticBand::resample()) or resized incrementally
+   * (TimedElasticBand::autoResize()).
+   * @param teb trajectory to resize
+   * @param min_samples minimum number of samples of the resized trajectory
+   */
+  void resizeTEB(TimedElasticBand &teb, int min_samples) const;
+
+  /**
+   * @brief Optimize every human trajectory in isolation.
+   *
+   * Each human band is optimized in its own hyper-graph containing only its
+   * velocity, acceleration, time-optimal, kinematic, via-point and obstacle
+   * edges. Bands are processed in parallel if multithreading is enabled. The
+   * subsequent joint solve then only adds the human-robot coupling edges.
+   * @param iterations_innerloop Number of solver iterations per outer iteration
+   * @param iterations_outerloop Number of resize-and-optimize iterations
+   * @return \c true, if all human bands were optimized successfully
+   */
+  bool optimizeHumanTEBs(unsigned int iterations_innerloop,
+                         unsigned int iterations_outerloop);
+
+  /**
+   * @brief Optimize a single human trajectory in a separate hyper-graph.
+   * @param optimizer Optimizer dedicated to this human (must be empty)
+   * @param human_id Id of the human (for start velocity and via-points)
+   * @param human_teb Human trajectory to optimize
+   * @param iterations_innerloop Number of solver iterations per outer iteration
+   * @param iterations_outerloop Number of resize-and-optimize iterations
+   * @return \c true, if optimization terminates successfully
+   */
+  bool optimizeHumanTEB(g2o::SparseOptimizer *optimizer, uint64_t human_id,
+                        TimedElasticBand &human_teb,
+                        unsigned int iterations_innerloop,
+                        unsigned int iterations_outerloop);
+
+  /**
+   * @brief Select the level of detail for each human.
+   *
+   * The closest approach between robot and human is predicted assuming
+   * constant velocities (bounded by human.lod_time_horizon). Humans that stay
+   * farther away than human.lod_distance are not optimized jointly. Depending
+   * on human.lod_mode they are added as dynamic obstacles, kept as fixed bands
+   * or ignored.
+   * @remarks The start velocities of the humans must be set before.
+   */
+  void updateHumansLevelOfDetail();
+
+  /**
+   * @brief Check if the band of a human is optimized in the current cycle.
+   * @param human_id Id of the human
+   * @return \c true, if the human is close enough to be optimized jointly
+   */
+  bool isHumanOptimized(uint64_t human_id) const;
+
+  /**
+   * @brief Check if the band of a human is part of the hyper-graph, either
+   * optimized or fixed.
+   * @param human_id Id of the human
+   * @return \c true, if the vertices of the human are added to the graph
+   */
+  bool isHumanInGraph(uint64_t human_id) const;
+
   /**
    * @brief Add all relevant vertices to the hyper-graph as optimizable
    * variables.
@@ -703,10 +916,23 @@ protected:
    * optimization.
    * @see VertexPose
    * @see VertexTimeDiff
+   * @tparam Policy graph structure (see GraphPolicy)
    * @see buildGraph
    * @see optimizeGraph
    */
-  void AddTEBVertices();
+  template <typename Policy> void AddTEBVerticesWith();
+
+  /**
+   * @brief Add the vertices of a human band to a hyper-graph.
+   * @param optimizer graph of the joint solve or of a pre-optimization
+   * @param human_teb band of the human
+   * @param id_counter next vertex id (incremented for each vertex)
+   * @param fixed if \c true, the vertices are fixed until clearGraph() (e.g.
+   * bands that have been pre-optimized and have no own edges in the graph)
+   */
+  void AddTEBVerticesForHuman(g2o::SparseOptimizer *optimizer,
+                              TimedElasticBand &human_teb,
+                              unsigned int &id_counter, bool fixed = false);
 
   /**
    * @brief Add all edges (local cost functions) for limiting the translational
@@ -717,6 +943,8 @@ protected:
    */
   void AddEdgesVelocity();
   void AddEdgesVelocityForHumans();
+  void AddEdgesVelocityForHuman(g2o::SparseOptimizer *optimizer,
+                                uint64_t human_id, TimedElasticBand &human_teb);
 
   /**
    * @brief Add all edges (local cost functions) for limiting the translational
@@ -729,6 +957,9 @@ protected:
    */
   void AddEdgesAcceleration();
   void AddEdgesAccelerationForHumans();
+  void AddEdgesAccelerationForHuman(g2o::SparseOptimizer *optimizer,
+                                    uint64_t human_id,
+                                    TimedElasticBand &human_teb);
 
   /**
    * @brief Add all edges (local cost functions) for minimizing the transition
@@ -739,6 +970,9 @@ protected:
    */
   void AddEdgesTimeOptimal();
   void AddEdgesTimeOptimalForHumans();
+  void AddEdgesTimeOptimalForHuman(g2o::SparseOptimizer *optimizer,
+                                   uint64_t human_id,
+                                   TimedElasticBand &human_teb);
 
   /**
    * @brief Add all edges (local cost functions) related to keeping a distance
@@ -749,6 +983,9 @@ protected:
    */
   void AddEdgesObstacles();
   void AddEdgesObstaclesForHumans();
+  void AddEdgesObstaclesForHuman(g2o::SparseOptimizer *optimizer,
+                                 uint64_t human_id,
+                                 TimedElasticBand &human_teb);
 
   /**
    * @brief Add all edges (local cost functions) related to minimizing the
@@ -759,6 +996,9 @@ protected:
    */
   void AddEdgesViaPoints();
   void AddEdgesViaPointsForHumans();
+  void AddEdgesViaPointsForHuman(g2o::SparseOptimizer *optimizer,
+                                 uint64_t human_id,
+                                 TimedElasticBand &human_teb);
 
   /**
    * @brief Add all edges (local cost functions) related to keeping a distance
@@ -770,6 +1010,10 @@ protected:
    */
   void AddEdgesDynamicObstacles();
   void AddEdgesDynamicObstaclesForHumans();
+  //! @return \c true if at least one edge has been added for \c human_teb
+  bool AddEdgesDynamicObstaclesForHuman(g2o::SparseOptimizer *optimizer,
+                                        uint64_t human_id,
+                                        TimedElasticBand &human_teb);
 
   /**
    * @brief Add all edges (local cost functions) for satisfying kinematic
@@ -780,6 +1024,9 @@ protected:
    */
   void AddEdgesKinematicsDiffDrive();
   void AddEdgesKinematicsDiffDriveForHumans();
+  void AddEdgesKinematicsDiffDriveForHuman(g2o::SparseOptimizer *optimizer,
+                                           uint64_t human_id,
+                                           TimedElasticBand &human_teb);
 
   /**
    * @brief Add all edges (local cost functions) for satisfying kinematic
@@ -795,20 +1042,47 @@ protected:
   void AddEdgesHumanRobotTTC();
   void AddEdgesHumanRobotDirectional();
 
+  /**
+   * @brief Find the band indices at which the human-robot TTC or directional
+   * edges are active or close to active.
+   *
+   * The condition is evaluated once on the current bands (thresholds inflated
+   * by optim.human_coupling_margin). Active indices are padded by
+   * optim.human_coupling_window on each side. Since the graph is rebuilt in
+   * every outer iteration, the windows follow the optimized bands. If sparse
+   * coupling is disabled, all indices are marked.
+   * @param human_teb Human trajectory
+   * @param directional \c true for directional edges, \c false for TTC edges
+   * @return mask with one entry per coupling index
+   */
+  std::vector<bool>
+  activeHumanCouplingIndices(const TimedElasticBand &human_teb,
+                             bool directional) const;
+
   void AddVertexEdgesApproach();
 
   //@}
 
   /**
-   * @brief Initialize and configure the g2o sparse optimizer.
-   * @return shared pointer to the g2o::SparseOptimizer instance
+   * @brief Write the poses, velocities and times from start of a band to a
+   * trajectory.
+   * @param teb band to export
+   * @param vel_start velocity at the first pose
+   * @param vel_goal velocity at the last pose
+   * @param[out] trajectory resulting trajectory (resized to the band)
    */
-  boost::shared_ptr<g2o::SparseOptimizer> initOptimizer();
+  void exportTrajectory(const TimedElasticBand &teb,
+                        const Eigen::Vector2d &vel_start,
+                        const Eigen::Vector2d &vel_goal,
+                        std::vector<TrajectoryPointMsg> &trajectory) const;
 
   // external objects (store weak pointers)
   const TebConfig
       *cfg_; //!< Config class that stores and manages all related parameters
   ObstContainer *obstacles_; //!< Store obstacles that are relevant for planning
+  const ObstacleSnapshot
+      *shared_obstacle_snapshot_; //!< Snapshot of obstacles_ shared by the
+                                  //! owner (optional)
   const ViaPointContainer *via_points_; //!< Store via points for planning
   const std::map<uint64_t, ViaPointContainer> *humans_via_points_map_;
 
@@ -831,6 +1105,26 @@ protected:
       vel_goal_; //!< Store the final velocity at the goal pose
   std::map<uint64_t, std::pair<bool, Eigen::Vector2d>> humans_vel_start_,
       humans_vel_goal_;
+  std::map<uint64_t, boost::shared_ptr<g2o::SparseOptimizer>>
+      humans_optimizers_; //!< optimizers for the per-human pre-optimization
+  WorkerPool human_workers_; //!< Persistent threads of the per-human
+                             //! pre-optimization (see optimizeHumanTEBs())
+  std::set<uint64_t> passive_humans_; //!< humans that are not optimized
+                                      //! jointly (level of detail)
+  ObstContainer human_obstacles_; //!< passive humans as dynamic obstacles
+  ObstacleSnapshot obstacle_snapshot_; //!< snapshot of obstacles_ (used if no
+                                       //! shared snapshot is set)
+  std::vector<g2o::HyperGraphAction *>
+      time_prefix_actions_; //!< time prefix actions registered at optimizer_
+  std::vector<g2o::OptimizableGraph::Vertex *>
+      fixed_human_vertices_; //!< human vertices fixed for the joint solve
+                             //! (released by clearGraph())
+  double cost_families_[TELEMETRY_COSTS]; //!< costs per edge family
+  unsigned int no_iterations_; //!< solver iterations of the current cycle
+  mutable TrajectoryExportPtr
+      trajectory_export_; //!< trajectories of the current cycle
+  mutable bool trajectory_export_valid_; //!< \c false if trajectory_export_
+                                         //! is outdated
 
   bool initialized_; //!< Keeps track about the correct initialization of this
                      //!class
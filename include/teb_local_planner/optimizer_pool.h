@@ -0,0 +1,112 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Copyright (c) 2016 LAAS/CNRS
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef OPTIMIZER_POOL_H_
+#define OPTIMIZER_POOL_H_
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "g2o/core/sparse_optimizer.h"
+
+namespace teb_local_planner {
+
+/**
+ * @class OptimizerPool
+ * @brief Pool of pre-initialized g2o optimizers (solver, block solver and
+ * linear solver) that can be shared by short-living planners.
+ *
+ * Optimizers obtained by acquire() are returned to the pool automatically as
+ * soon as the last reference is released, as long as their graph is empty
+ * and the pool still exists. Otherwise they are destroyed as usual.
+ * @see HomotopyClassPlanner
+ */
+class OptimizerPool {
+public:
+  typedef boost::shared_ptr<g2o::SparseOptimizer> OptimizerPtr;
+
+  /**
+   * @brief Construct an empty pool
+   * @param max_size Maximum number of idle optimizers kept in the pool
+   */
+  OptimizerPool(std::size_t max_size = 8);
+
+  /**
+   * @brief Check out an optimizer, a new one is created if the pool is empty
+   * @return shared pointer to an optimizer with an empty graph
+   */
+  OptimizerPtr acquire();
+
+  /**
+   * @brief Pre-initialize optimizers until \c num_optimizers are idle.
+   *
+   * The maximum pool size is increased accordingly.
+   * @param num_optimizers Number of idle optimizers
+   */
+  void reserve(std::size_t num_optimizers);
+
+  /**
+   * @brief Get the number of idle optimizers
+   */
+  std::size_t sizeIdle() const;
+
+protected:
+  //! Idle optimizers, shared with the deleters of the checked out optimizers
+  struct Storage {
+    boost::mutex mutex;
+    std::vector<OptimizerPtr> idle;
+    std::size_t max_size;
+  };
+
+  //! Deleter returning an optimizer to the pool (see acquire())
+  struct ReturnToPool {
+    boost::weak_ptr<Storage> storage;
+    OptimizerPtr optimizer;
+    void operator()(g2o::SparseOptimizer *);
+  };
+
+  boost::shared_ptr<Storage> storage_;
+};
+
+} // namespace teb_local_planner
+
+#endif /* OPTIMIZER_POOL_H_ */
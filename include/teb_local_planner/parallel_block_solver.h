@@ -0,0 +1,155 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Copyright (c) 2016 LAAS/CNRS
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef PARALLEL_BLOCK_SOLVER_H_
+#define PARALLEL_BLOCK_SOLVER_H_
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include <teb_local_planner/worker_pool.h>
+
+#include "g2o/core/block_solver.h"
+#include "g2o/core/jacobian_workspace.h"
+#include "g2o/core/sparse_optimizer.h"
+
+namespace teb_local_planner {
+
+/**
+ * @class ParallelBlockSolver
+ * @brief Block solver that linearizes the edges of the graph on multiple
+ * threads.
+ *
+ * The Jacobians of all active edges and their contributions to the Hessian
+ * blocks and the gradient are computed in buildSystem(). The edges are
+ * partitioned into colors, such that no two edges of the same color share a
+ * non-fixed vertex. The edges of one color are processed concurrently without
+ * any locking, since each edge only writes to its own Jacobians and Hessian
+ * blocks and to the quadratic forms of its (non-fixed) vertices. Numerical
+ * differentiation only perturbs non-fixed vertices as well. The colors are
+ * processed one after another on persistent worker threads.
+ *
+ * The edges are colored in the order of decreasing vertex degree, which keeps
+ * the number of colors close to the maximum degree. Colors with less than
+ * MinParallelColorEdges edges (edges clustered at vertices shared by many
+ * edges) are not worth a synchronization of the threads, they are linearized
+ * as one serial batch after the parallel colors.
+ *
+ * The coloring is computed once per graph (see init()). Small graphs and a
+ * single thread fall back to the serial g2o implementation.
+ */
+class ParallelBlockSolver : public g2o::BlockSolverX {
+public:
+  /**
+   * @brief Construct the block solver
+   * @param linear_solver Linear solver (ownership is transferred)
+   */
+  explicit ParallelBlockSolver(LinearSolverType *linear_solver);
+
+  /**
+   * @brief Set the number of threads used for the edge linearization
+   * @param num_threads number of threads (values < 2 disable the parallel
+   * path)
+   */
+  void setNumThreads(int num_threads) { num_threads_ = num_threads; }
+
+  /**
+   * @brief Get the number of threads used for the edge linearization
+   */
+  int numThreads() const { return num_threads_; }
+
+  /**
+   * @brief Initialize the solver for the current graph of \c optimizer
+   *
+   * Invalidates the edge coloring.
+   */
+  virtual bool init(g2o::SparseOptimizer *optimizer, bool online = false);
+
+  /**
+   * @brief Linearize all active edges and build the Hessian and the gradient
+   */
+  virtual bool buildSystem();
+
+  //! Minimum number of active edges required for the parallel path
+  static const std::size_t MinParallelEdges = 256;
+
+  //! Minimum number of edges of a color processed in parallel
+  static const std::size_t MinParallelColorEdges = 32;
+
+protected:
+  /**
+   * @brief Partition the active edges into colors (greedy first-fit in the
+   * order of decreasing vertex degree)
+   */
+  void computeColoring();
+
+  /**
+   * @brief Linearize and accumulate the share \c chunk of a color
+   * @param color index of the color
+   * @param chunk index of the share (and of the Jacobian workspace)
+   * @param num_chunks total number of shares
+   */
+  void linearizeColor(std::size_t color, std::size_t chunk,
+                      std::size_t num_chunks);
+
+  /**
+   * @brief Linearize and accumulate the edges \c first ... \c last-1 of
+   * colored_edges_
+   */
+  void linearizeEdges(std::size_t first, std::size_t last,
+                      g2o::JacobianWorkspace &workspace);
+
+  int num_threads_; //!< Number of threads for the edge linearization
+  bool coloring_valid_; //!< \c false if the graph has been re-initialized
+  std::vector<g2o::OptimizableGraph::Edge *>
+      colored_edges_; //!< Active edges ordered by color
+  std::vector<std::size_t>
+      color_offsets_; //!< Offset of each parallel color in colored_edges_
+                      //! followed by the offset of the serial batch
+  std::vector<std::vector<boost::uint64_t>>
+      vertex_colors_; //!< Colors already used at each vertex (bit mask)
+  std::vector<g2o::JacobianWorkspace>
+      workspaces_;     //!< Jacobian workspace of each share of a color
+  WorkerPool workers_; //!< Persistent threads linearizing the colors
+};
+
+} // namespace teb_local_planner
+
+#endif /* PARALLEL_BLOCK_SOLVER_H_ */
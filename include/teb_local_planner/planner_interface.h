@@ -60,6 +60,7 @@
 #include <hanp_msgs/HumanPath.h>
 
 #include <teb_local_planner/TrajectoryMsg.h>
+#include <teb_local_planner/telemetry_recorder.h>
 
 namespace teb_local_planner {
 
@@ -234,7 +235,18 @@ public:
   getFullHumanTrajectory(const uint64_t human_id,
                          std::vector<TrajectoryPointMsg> &human_trajectory) = 0;
 
+  /**
+   * @brief Record every planning cycle to a telemetry log.
+   * @param recorder opened recorder (an empty pointer disables recording)
+   */
+  void setTelemetryRecorder(TelemetryRecorderPtr recorder) {
+    telemetry_ = recorder;
+  }
+
   double local_weight_optimaltime_;
+
+protected:
+  TelemetryRecorderPtr telemetry_; //!< Telemetry log (optional)
 };
 
 //! Abbrev. for shared instances of PlannerInterface or it's subclasses
@@ -0,0 +1,231 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Copyright (c) 2016 LAAS/CNRS
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef REPLAY_LOG_H_
+#define REPLAY_LOG_H_
+
+#include <teb_local_planner/obstacles.h>
+#include <teb_local_planner/optimal_planner.h>
+#include <teb_local_planner/planner_interface.h>
+#include <teb_local_planner/telemetry_recorder.h>
+
+namespace teb_local_planner {
+
+/**
+ * @name Binary layout of the replay log
+ *
+ * The replay log stores the inputs of TebLocalPlannerROS at the boundary to
+ * the planner (the arguments of PlannerInterface::plan() and the containers
+ * shared with the planner) together with the resulting trajectory. All tf,
+ * costmap, odometry and prediction service queries happen before this
+ * boundary, hence the teb_replay tool reproduces the planning cycles without
+ * any of them. The log is written by a TelemetryRecorder and follows the same
+ * conventions as the telemetry log (8-byte aligned, memory-mappable). A record
+ * consists of:
+ *  - ReplayCycleHeader
+ *  - ReplayPose[no_plan_poses] (transformed global plan)
+ *  - double[2 * no_via_points]
+ *  - for each human: ReplayHumanHeader, ReplayPose[no_poses]
+ *  - for each set of human via-points: ReplayViaPointsHeader,
+ *    double[2 * no_via_points]
+ *  - for each obstacle: ReplayObstacleHeader, double[2 * no_vertices]
+ *  - TelemetryPose[no_result_poses] (optimized trajectory)
+ */
+//@{
+
+//! Version of the replay log format
+static const uint32_t REPLAY_VERSION = 1;
+//! Magic number at the beginning of the replay log
+static const char REPLAY_MAGIC[8] = {'T', 'E', 'B', 'R', 'P', 'L', 0, 0};
+//! Seed of the random number generator of the HomotopyClassPlanner while
+//! recording
+static const uint32_t REPLAY_RANDOM_SEED = 5489;
+
+//! Flags of a replay record
+enum ReplayFlags {
+  REPLAY_FREE_GOAL_VEL = 1,  //!< plan() has been called with free_goal_vel
+  REPLAY_SUCCESS = 2,        //!< plan() has returned \c true
+  REPLAY_CLEARED = 4,        //!< The planner has been cleared since the last
+                             //!< record
+  REPLAY_SEARCH_CUT_OFF = 8  //!< The roadmap search has been cut off after
+                             //!< search_expansions
+};
+
+//! Header of a replay record (one call of plan())
+struct ReplayCycleHeader {
+  TelemetryRecordHeader record;
+  double stamp;              //!< Time of the cycle [s]
+  double start_vel[6];       //!< Start velocity (linear xyz, angular xyz)
+  double weight_optimaltime; //!< PlannerInterface::local_weight_optimaltime_
+  double plan_time;          //!< Duration of plan() while recording [s]
+  uint32_t flags;            //!< Combination of ReplayFlags
+  uint32_t random_seed;      //!< Seed of the planner (REPLAY_RANDOM_SEED)
+  uint32_t no_plan_poses;
+  uint32_t no_via_points;
+  uint32_t no_humans;
+  uint32_t no_human_via_points; //!< Number of sets of human via-points
+  uint32_t no_obstacles;
+  uint32_t no_result_poses;
+  uint64_t search_expansions; //!< Vertices expanded by the last roadmap search
+                              //!< of the HomotopyClassPlanner
+};
+
+//! Exact copy of a geometry_msgs::Pose
+struct ReplayPose {
+  double position[3];
+  double orientation[4]; //!< x, y, z, w
+};
+
+//! Header of a predicted human plan, followed by its poses
+struct ReplayHumanHeader {
+  uint64_t id;
+  uint32_t no_poses;
+  uint32_t reserved;
+  double start_vel[6]; //!< linear xyz, angular xyz
+  double goal_vel[6];  //!< linear xyz, angular xyz
+};
+
+//! Header of the via-points of a human, followed by the via-points (x, y)
+struct ReplayViaPointsHeader {
+  uint64_t id;
+  uint32_t no_via_points;
+  uint32_t reserved;
+};
+
+//! Header of an obstacle, followed by its vertices (x, y)
+struct ReplayObstacleHeader {
+  uint32_t type; //!< ObstacleSnapshot::ObstacleType
+  uint32_t no_vertices;
+  uint32_t dynamic;
+  uint32_t reserved;
+  double velocity[2]; //!< Velocity of the centroid of a dynamic obstacle
+};
+
+//@}
+
+//! Inputs and result of a recorded planning cycle
+struct ReplayCycle {
+  ReplayCycleHeader header;
+  std::vector<geometry_msgs::PoseStamped> plan;
+  geometry_msgs::Twist start_vel;
+  ViaPointContainer via_points;
+  HumanPlanVelMap humans;
+  std::map<uint64_t, ViaPointContainer> human_via_points;
+  ObstContainer obstacles;
+  std::vector<TelemetryPose> result;
+};
+
+/**
+ * @brief Access the trajectory that has been selected by a planner
+ * @param planner TebOptimalPlanner or HomotopyClassPlanner
+ * @return Selected trajectory or \c NULL if none is available
+ */
+const TimedElasticBand *plannedTrajectory(const PlannerInterface &planner);
+
+/**
+ * @brief Open a replay log
+ * @param recorder closed recorder
+ * @param filename Path of the log (an existing file is overwritten)
+ * @param buffer_size Size of the ring buffer in bytes
+ * @return \c true if the file has been created
+ */
+bool openReplayLog(TelemetryRecorder &recorder, const std::string &filename,
+                   std::size_t buffer_size);
+
+/**
+ * @brief Record a call of PlannerInterface::plan() to a replay log
+ * @param recorder Recorder opened by openReplayLog()
+ * @param header stamp, weight_optimaltime, plan_time, flags and random_seed of
+ * the record (the remaining fields and REPLAY_SEARCH_CUT_OFF are set by this
+ * function)
+ * @param plan Plan passed to plan()
+ * @param start_vel Start velocity passed to plan() (can be \c NULL)
+ * @param humans Human plans passed to plan() (can be \c NULL)
+ * @param via_points Via-points of the robot
+ * @param human_via_points Via-points of the humans
+ * @param obstacles Obstacles
+ * @param planner Planner after plan() (provides the resulting trajectory)
+ * @return \c false if the record has been dropped
+ */
+bool recordReplayCycle(
+    TelemetryRecorder &recorder, ReplayCycleHeader header,
+    const std::vector<geometry_msgs::PoseStamped> &plan,
+    const geometry_msgs::Twist *start_vel, const HumanPlanVelMap *humans,
+    const ViaPointContainer &via_points,
+    const std::map<uint64_t, ViaPointContainer> &human_via_points,
+    const ObstContainer &obstacles, const PlannerInterface &planner);
+
+/**
+ * @class ReplayLogReader
+ * @brief Sequential reader of a memory-mapped replay log
+ */
+class ReplayLogReader : boost::noncopyable {
+public:
+  ReplayLogReader();
+  ~ReplayLogReader();
+
+  /**
+   * @brief Map a replay log into memory and check its header
+   * @return \c false if the file cannot be read or has a different version
+   */
+  bool open(const std::string &filename);
+
+  //! Unmap the log
+  void close();
+
+  /**
+   * @brief Read the next record
+   * @param[out] cycle inputs and result of the record
+   * @return \c false at the end of the log or if the record is truncated
+   */
+  bool next(ReplayCycle &cycle);
+
+  //! Check if the last record of the log is incomplete
+  bool truncated() const { return truncated_; }
+
+private:
+  const char *data_; //!< mapped file
+  std::size_t size_; //!< size of the mapped file
+  std::size_t pos_;  //!< offset of the next record
+  bool truncated_;
+};
+
+} // namespace teb_local_planner
+
+#endif /* REPLAY_LOG_H_ */
@@ -46,6 +46,7 @@
 
 #include <teb_local_planner/pose_se2.h>
 #include <teb_local_planner/obstacles.h>
+#include <teb_local_planner/obstacle_snapshot.h>
 #include <visualization_msgs/Marker.h>
 
 namespace teb_local_planner
@@ -86,6 +87,20 @@ public:
     */
   virtual double calculateDistance(const PoseSE2& current_pose, const Obstacle* obstacle) const = 0;
 
+  /**
+    * @brief Calculate the distance between the robot and an obstacle of a snapshot
+    *
+    * Models that override this method use the non-virtual distance kernels of the snapshot.
+    * @param current_pose Current robot pose
+    * @param obstacles Obstacle snapshot
+    * @param obstacle_idx Index of the obstacle in the snapshot
+    * @return Euclidean distance to the robot
+    */
+  virtual double calculateDistance(const PoseSE2& current_pose, const ObstacleSnapshot& obstacles, std::size_t obstacle_idx) const
+  {
+    return calculateDistance(current_pose, obstacles.obstacle(obstacle_idx));
+  }
+
   /**
     * @brief Visualize the robot using a markers
     *
@@ -149,6 +164,12 @@ public:
     return obstacle->getMinimumDistance(current_pose.position());
   }
 
+  // implements calculateDistance() of the base class using the snapshot kernels
+  virtual double calculateDistance(const PoseSE2& current_pose, const ObstacleSnapshot& obstacles, std::size_t obstacle_idx) const
+  {
+    return obstacles.getMinimumDistance(obstacle_idx, current_pose.position());
+  }
+
   virtual double getCircumscribedRadius() const {
     return 0.0;
   }
@@ -193,6 +214,12 @@ public:
     return obstacle->getMinimumDistance(current_pose.position()) - radius_;
   }
 
+  // implements calculateDistance() of the base class using the snapshot kernels
+  virtual double calculateDistance(const PoseSE2& current_pose, const ObstacleSnapshot& obstacles, std::size_t obstacle_idx) const
+  {
+    return obstacles.getMinimumDistance(obstacle_idx, current_pose.position()) - radius_;
+  }
+
   /**
     * @brief Visualize the robot using a markers
     *
@@ -272,6 +299,15 @@ public:
     return std::min(dist_front, dist_rear);
   }
 
+  // implements calculateDistance() of the base class using the snapshot kernels
+  virtual double calculateDistance(const PoseSE2& current_pose, const ObstacleSnapshot& obstacles, std::size_t obstacle_idx) const
+  {
+    Eigen::Vector2d dir = current_pose.orientationUnitVec();
+    double dist_front = obstacles.getMinimumDistance(obstacle_idx, current_pose.position() + front_offset_*dir) - front_radius_;
+    double dist_rear = obstacles.getMinimumDistance(obstacle_idx, current_pose.position() - rear_offset_*dir) - rear_radius_;
+    return std::min(dist_front, dist_rear);
+  }
+
   /**
     * @brief Visualize the robot using a markers
     *
@@ -395,18 +431,19 @@ public:
     */
   virtual double calculateDistance(const PoseSE2& current_pose, const Obstacle* obstacle) const
   {
-    // here we are doing the transformation into the world frame manually
-    double cos_th = std::cos(current_pose.theta());
-    double sin_th = std::sin(current_pose.theta());
-    Eigen::Vector2d line_start_world;
-    line_start_world.x() = current_pose.x() + cos_th * line_start_.x() - sin_th * line_start_.y();
-    line_start_world.y() = current_pose.y() + sin_th * line_start_.x() + cos_th * line_start_.y();
-    Eigen::Vector2d line_end_world;
-    line_end_world.x() = current_pose.x() + cos_th * line_end_.x() - sin_th * line_end_.y();
-    line_end_world.y() = current_pose.y() + sin_th * line_end_.x() + cos_th * line_end_.y();
+    Eigen::Vector2d line_start_world, line_end_world;
+    transformToWorld(current_pose, line_start_world, line_end_world);
     return obstacle->getMinimumDistance(line_start_world, line_end_world);
   }
 
+  // implements calculateDistance() of the base class using the snapshot kernels
+  virtual double calculateDistance(const PoseSE2& current_pose, const ObstacleSnapshot& obstacles, std::size_t obstacle_idx) const
+  {
+    Eigen::Vector2d line_start_world, line_end_world;
+    transformToWorld(current_pose, line_start_world, line_end_world);
+    return obstacles.getMinimumDistance(obstacle_idx, line_start_world, line_end_world);
+  }
+
   /**
     * @brief Visualize the robot using a markers
     *
@@ -452,6 +489,23 @@ public:
 
 private:
 
+  /**
+    * @brief Transform the line segment into the world frame
+    * @param current_pose Current robot pose
+    * @param[out] line_start_world Start of the line segment in the world frame
+    * @param[out] line_end_world End of the line segment in the world frame
+    */
+  void transformToWorld(const PoseSE2& current_pose, Eigen::Vector2d& line_start_world, Eigen::Vector2d& line_end_world) const
+  {
+    // here we are doing the transformation into the world frame manually
+    double cos_th = std::cos(current_pose.theta());
+    double sin_th = std::sin(current_pose.theta());
+    line_start_world.x() = current_pose.x() + cos_th * line_start_.x() - sin_th * line_start_.y();
+    line_start_world.y() = current_pose.y() + sin_th * line_start_.x() + cos_th * line_start_.y();
+    line_end_world.x() = current_pose.x() + cos_th * line_end_.x() - sin_th * line_end_.y();
+    line_end_world.y() = current_pose.y() + sin_th * line_end_.x() + cos_th * line_end_.y();
+  }
+
   Eigen::Vector2d line_start_;
   Eigen::Vector2d line_end_;
 
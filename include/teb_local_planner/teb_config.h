@@ -65,6 +65,11 @@ public:
   std::string odom_topic; //!< Topic name of the odometry message, provided by
                           //! the robot driver or simulator
   std::string map_frame;  //!< Global planning frame
+  std::string telemetry_file; //!< Binary log of all planning cycles (empty:
+                              //! recording disabled)
+  int telemetry_buffer_size;  //!< Size of the telemetry ring buffer [kB]
+  std::string replay_file; //!< Log of all planner inputs for teb_replay
+                           //! (empty: recording disabled)
 
   int planning_mode;
 
@@ -72,6 +77,9 @@ public:
   struct Trajectory {
     double teb_autosize; //!< Enable automatic resizing of the trajectory w.r.t
                          //! to the temporal resolution (recommended)
+    bool teb_autosize_resample; //!< Resample the whole trajectory in a single
+                                //! pass instead of inserting/removing single
+                                //! samples (see TimedElasticBand::resample())
     double dt_ref; //!< Desired temporal resolution of the trajectory (should be
                    //! in the magniture of the underlying control rate)
     double dt_hysteresis; //!< Hysteresis for automatic resizing depending on
@@ -155,6 +163,12 @@ public:
     double ttc_threshold;
     double dir_cost_threshold;
     double pose_prediction_reset_time;
+    double lod_distance; //!< Humans with a predicted closest approach farther
+                         //! than this are not optimized jointly (0 disables)
+    double lod_time_horizon; //!< Time horizon for the closest approach
+                             //! prediction
+    int lod_mode; //!< Handling of distant humans: 0 = dynamic obstacle,
+                  //! 1 = fixed band, 2 = ignored
   } human;
 
   //! Goal tolerance related parameters
@@ -183,6 +197,9 @@ public:
                                  //! closest pose on the trajectory to reduce
     //! computational effort, but take a number of
     //! neighbors into account as well
+    int dynamic_obstacle_dt_window; //!< Number of preceding time differences
+                                    //! a dynamic obstacle edge is linearized
+                                    //! w.r.t. (the predicted time is exact)
     std::string costmap_converter_plugin; //!< Define a plugin name of the
                                           //! costmap_converter package (costmap
     //! cells are converted to
@@ -206,6 +223,8 @@ public:
 
     bool optimization_activate; //!< Activate the optimization
     bool optimization_verbose;  //!< Print verbose information
+    int edge_threads; //!< Number of threads linearizing the edges of large
+                      //! graphs (see ParallelBlockSolver, < 2: serial)
 
     double penalty_epsilon; //!< Add a small safety margin to penalty functions
                             //! for hard-constraint approximations
@@ -269,6 +288,16 @@ public:
     bool disable_warm_start;
     bool disable_rapid_omega_chage;
     double omega_chage_time_seperation;
+    bool human_pre_optimization; //!< Optimize each human trajectory on its own
+                                 //! before the joint solve, which then only
+                                 //! contains the human-robot coupling edges
+    bool sparse_human_coupling; //!< Add TTC and directional edges only in
+                                //! time windows where they are (nearly) active
+    int human_coupling_window;  //!< Number of additional indices added on each
+                                //! side of an active coupling window
+    double human_coupling_margin; //!< Relative margin on the TTC and
+                                  //! directional thresholds for the activity
+    //! check of sparse coupling
   } optim;                     //!< Optimization related parameters
 
   struct HomotopyClasses {
@@ -300,6 +329,8 @@ public:
     //! candidate.
     bool selection_alternative_time_cost; //!< If true, time cost is replaced by
                                           //! the total transition time.
+    bool selection_early_abort; //!< Stop optimizing candidates that cannot
+                                //! beat the current best candidate anymore.
 
     int roadmap_graph_no_samples; //! < Specify the number of samples generated
                                   //! for creating the roadmap graph, if
@@ -308,6 +339,9 @@ public:
                                      //! in a rectangular region between start
     //! and goal. Specify the width of that
     //! region in meters.
+    double roadmap_graph_search_time; //!< Time budget [s] for exploring the
+                                      //! graph for distinctive paths (0
+                                      //! disables the limit).
     double h_signature_prescaler; //!< Scale number of obstacle value in order
                                   //! to allow huge number of obstacles. Do not
     //! choose it extremly low, otherwise obstacles
@@ -386,12 +420,16 @@ public:
 
     odom_topic = "odom";
     map_frame = "odom";
+    telemetry_file = "";
+    telemetry_buffer_size = 4096;
+    replay_file = "";
 
     planning_mode = 1; // Human-Aware planning by default
 
     // Trajectory
 
     trajectory.teb_autosize = true;
+    trajectory.teb_autosize_resample = false;
     trajectory.dt_ref = 0.3;
     trajectory.dt_hysteresis = 0.1;
     trajectory.min_samples = 3;
@@ -435,6 +473,9 @@ public:
     human.predict_human_behind_robot = false;
     human.ttc_threshold = 5.0;
     human.pose_prediction_reset_time = 2.0;
+    human.lod_distance = 0.0;
+    human.lod_time_horizon = 5.0;
+    human.lod_mode = 0;
 
     // GoalTolerance
 
@@ -450,6 +491,7 @@ public:
     obstacles.include_costmap_obstacles = true;
     obstacles.costmap_obstacles_behind_robot_dist = 0.5;
     obstacles.obstacle_poses_affected = 25;
+    obstacles.dynamic_obstacle_dt_window = 2;
     obstacles.costmap_converter_plugin = "";
     obstacles.costmap_converter_spin_thread = true;
     obstacles.costmap_converter_rate = 5;
@@ -460,6 +502,7 @@ public:
     optim.no_outer_iterations = 4;
     optim.optimization_activate = true;
     optim.optimization_verbose = false;
+    optim.edge_threads = 1;
     optim.penalty_epsilon = 0.1;
     optim.time_penalty_epsilon = 0.1;
     optim.cap_optimaltime_penalty = true;
@@ -495,6 +538,10 @@ public:
     optim.disable_warm_start = false;
     optim.disable_rapid_omega_chage = true;
     optim.omega_chage_time_seperation = 1.0;
+    optim.human_pre_optimization = false;
+    optim.sparse_human_coupling = false;
+    optim.human_coupling_window = 2;
+    optim.human_coupling_margin = 0.5;
 
     // Homotopy Class Planner
 
@@ -506,11 +553,13 @@ public:
     hcp.selection_obst_cost_scale = 100.0;
     hcp.selection_viapoint_cost_scale = 1.0;
     hcp.selection_alternative_time_cost = false;
+    hcp.selection_early_abort = false;
 
     hcp.obstacle_keypoint_offset = 0.1;
     hcp.obstacle_heading_threshold = 0.45;
     hcp.roadmap_graph_no_samples = 15;
     hcp.roadmap_graph_area_width = 6; // [m]
+    hcp.roadmap_graph_search_time = 0.05; // [s]
     hcp.h_signature_prescaler = 1;
     hcp.h_signature_threshold = 0.1;
 
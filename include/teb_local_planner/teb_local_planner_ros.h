@@ -55,6 +55,7 @@
 #include <teb_local_planner/optimal_planner.h>
 #include <teb_local_planner/homotopy_class_planner.h>
 #include <teb_local_planner/visualization.h>
+#include <teb_local_planner/replay_log.h>
 
 // message types
 #include <nav_msgs/Path.h>
@@ -452,6 +453,10 @@ private:
   std::map<uint64_t, ViaPointContainer> humans_via_points_map_;
   TebVisualizationPtr visualization_; //!< Instance of the visualization class
                                       //!(local/global plan, obstacles, ...)
+  TelemetryRecorderPtr telemetry_; //!< Telemetry log of all planning cycles
+                                   //!(optional)
+  TelemetryRecorderPtr replay_log_; //!< Log of all planner inputs for
+                                    //!teb_replay (optional)
   boost::shared_ptr<base_local_planner::CostmapModel> costmap_model_;
   TebConfig
       cfg_; //!< Config class that stores and manages all related parameters
@@ -488,6 +493,8 @@ private:
                          //!temporary
   ros::Time horizon_reduced_stamp_; //!< Store at which time stamp the horizon
                                     //!reduction was requested
+  bool planner_cleared_; //!< store whether the planner has been cleared since
+                         //!the last record of the replay log
 
   std::vector<geometry_msgs::Point>
       footprint_spec_;            //!< Store the footprint of the robot
@@ -517,6 +524,7 @@ private:
   bool publish_predicted_human_markers_ = true;
 
   void resetHumansPrediction();
+  void resetPlanner(); //!< Clear the planner and mark it in the replay log
   ros::Time last_call_time_;
 
   ros::Time last_omega_sign_change_;
@@ -0,0 +1,272 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Copyright (c) 2016 LAAS/CNRS
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef TELEMETRY_RECORDER_H_
+#define TELEMETRY_RECORDER_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace teb_local_planner {
+
+/**
+ * @name Binary layout of the telemetry log
+ *
+ * The log starts with a TelemetryFileHeader followed by one record per
+ * planning cycle. All fields are stored in the byte order of the recording
+ * machine (little-endian on all supported platforms) and every structure has a
+ * size divisible by 8, hence the log can be memory-mapped and read in place.
+ * Every record begins with a TelemetryRecordHeader (shared with other logs
+ * written by the TelemetryRecorder, e.g. the replay log). A record consists of:
+ *  - TelemetryCycleHeader
+ *  - TelemetryPose[no_robot_poses] (robot trajectory)
+ *  - for each human: TelemetryHumanHeader, TelemetryPose[no_poses]
+ *  - for each obstacle: TelemetryObstacleHeader, double[2 * no_vertices]
+ */
+//@{
+
+//! Version of the log format
+static const uint32_t TELEMETRY_VERSION = 1;
+//! Magic number at the beginning of the log
+static const char TELEMETRY_MAGIC[8] = {'T', 'E', 'B', 'T', 'L', 'M', 0, 0};
+
+//! Phases of a planning cycle with recorded durations
+enum TelemetryPhase {
+  TELEMETRY_PHASE_PREPARATION,  //!< Initialization and update of the band
+  TELEMETRY_PHASE_HUMANS,       //!< Update of the human bands
+  TELEMETRY_PHASE_OPTIMIZATION, //!< Optimization
+  TELEMETRY_PHASE_TOTAL,        //!< Complete cycle
+  TELEMETRY_PHASES
+};
+
+//! Edge families with recorded costs (see TebOptimalPlanner::computeCurrentCost)
+enum TelemetryCost {
+  TELEMETRY_COST_TIME_OPTIMAL,
+  TELEMETRY_COST_KINEMATICS_DIFF_DRIVE,
+  TELEMETRY_COST_KINEMATICS_CARLIKE,
+  TELEMETRY_COST_VELOCITY,
+  TELEMETRY_COST_ACCELERATION,
+  TELEMETRY_COST_OBSTACLE,
+  TELEMETRY_COST_DYNAMIC_OBSTACLE,
+  TELEMETRY_COST_VIA_POINT,
+  TELEMETRY_COST_HUMAN_ROBOT_SAFETY,
+  TELEMETRY_COST_HUMAN_HUMAN_SAFETY,
+  TELEMETRY_COST_HUMAN_ROBOT_TTC,
+  TELEMETRY_COST_HUMAN_ROBOT_DIRECTIONAL,
+  TELEMETRY_COSTS
+};
+
+//! Name of a TelemetryPhase (e.g. for column headers)
+const char *telemetryPhaseName(int phase);
+//! Name of a TelemetryCost (e.g. for column headers)
+const char *telemetryCostName(int cost);
+
+//! Header of the log file
+struct TelemetryFileHeader {
+  char magic[8];        //!< TELEMETRY_MAGIC
+  uint32_t version;     //!< TELEMETRY_VERSION
+  uint32_t header_size; //!< Size of the record header (e.g. sizeof(TelemetryCycleHeader))
+};
+
+//! Common beginning of all records (completed by commitRecord())
+struct TelemetryRecordHeader {
+  uint32_t size;    //!< Size of the record in bytes (including header)
+  uint32_t dropped; //!< Records dropped since the previous record
+  uint64_t cycle;   //!< Index of the record since the log was opened
+};
+
+//! Header of a record (one planning cycle)
+struct TelemetryCycleHeader {
+  TelemetryRecordHeader record;
+  uint32_t no_iterations;  //!< Number of solver iterations
+  uint32_t no_robot_poses; //!< Number of poses of the robot trajectory
+  double stamp;            //!< Time of the cycle [s]
+  double phase_times[TELEMETRY_PHASES]; //!< Durations of the phases [s]
+  double costs[TELEMETRY_COSTS];        //!< Costs per edge family
+  uint32_t no_humans;    //!< Number of human trajectories
+  uint32_t no_obstacles; //!< Number of obstacles
+};
+
+//! State of a trajectory
+struct TelemetryPose {
+  double x, y, theta;
+  double dt; //!< Time difference to the next pose (0 for the last pose)
+};
+
+//! Header of a human trajectory, followed by its poses
+struct TelemetryHumanHeader {
+  uint64_t id;
+  uint32_t no_poses;
+  uint32_t reserved;
+};
+
+//! Header of an obstacle, followed by its vertices (x, y)
+struct TelemetryObstacleHeader {
+  uint32_t type; //!< ObstacleSnapshot::ObstacleType
+  uint32_t no_vertices;
+};
+
+//@}
+
+/**
+ * @class TelemetryRecorder
+ * @brief Append-only binary log of the planning cycles.
+ *
+ * The planner serializes each cycle with beginRecord(), write() and
+ * commitRecord() into a scratch buffer and copies it into a lock-free ring
+ * buffer (single producer, single consumer). A background thread writes the
+ * ring buffer to the file, so the planning thread never waits for the disk.
+ * If the ring buffer is full, the record is dropped and counted in the next
+ * record. Use the telemetry_reader tool to convert the log to CSV or MAT
+ * files.
+ */
+class TelemetryRecorder : boost::noncopyable {
+public:
+  /**
+   * @brief Construct a closed recorder
+   */
+  TelemetryRecorder();
+
+  /**
+   * @brief Destruct the recorder (remaining records are written to the file)
+   */
+  ~TelemetryRecorder();
+
+  /**
+   * @brief Create the log file and start the flush thread
+   * @param filename Path of the log (an existing file is overwritten)
+   * @param buffer_size Size of the ring buffer in bytes
+   * @param flush_period Period of the flush thread [s]
+   * @return \c true if the file has been created
+   */
+  bool open(const std::string &filename, std::size_t buffer_size,
+            double flush_period = 0.1);
+
+  /**
+   * @brief Create a log with a custom file header (e.g. a ReplayLog)
+   * @param filename Path of the log (an existing file is overwritten)
+   * @param file_header Header written at the beginning of the file
+   * @param buffer_size Size of the ring buffer in bytes
+   * @param flush_period Period of the flush thread [s]
+   * @return \c true if the file has been created
+   */
+  bool open(const std::string &filename, const TelemetryFileHeader &file_header,
+            std::size_t buffer_size, double flush_period = 0.1);
+
+  /**
+   * @brief Stop the flush thread, write the remaining records and close the
+   * file
+   */
+  void close();
+
+  //! Check if the log is open
+  bool isOpen() const { return file_ != NULL; }
+
+  //! Number of records dropped since the log was opened
+  uint64_t droppedRecords() const { return dropped_total_.load(); }
+
+  /** @name Producer interface (must be called from a single thread) */
+  //@{
+
+  /**
+   * @brief Start a new record
+   * @param header header of the record, it must begin with a
+   * TelemetryRecordHeader (size, cycle and dropped are set by commitRecord())
+   */
+  template <typename Header> void beginRecord(const Header &header) {
+    record_.clear();
+    write(header);
+  }
+
+  //! Append a trivially copyable value to the current record
+  template <typename T> void write(const T &value) {
+    write(&value, sizeof(T));
+  }
+
+  //! Append raw data to the current record
+  void write(const void *data, std::size_t size) {
+    std::size_t offset = record_.size();
+    record_.resize(offset + size);
+    std::memcpy(&record_[offset], data, size);
+  }
+
+  /**
+   * @brief Finish the current record and copy it into the ring buffer
+   * @return \c false if the record has been dropped (buffer full or log
+   * closed)
+   */
+  bool commitRecord();
+
+  //@}
+
+private:
+  //! Write the content of the ring buffer to the file
+  void flush();
+  //! Main loop of the flush thread
+  void flushThread(double flush_period);
+
+  std::FILE *file_;
+  boost::thread flush_thread_;
+  std::atomic<bool> running_;
+
+  std::vector<char> ring_;         //!< ring buffer
+  std::atomic<std::size_t> head_;  //!< bytes consumed by the flush thread
+  std::atomic<std::size_t> tail_;  //!< bytes produced by the planner
+
+  std::vector<char> record_;       //!< scratch buffer of the current record
+  uint64_t cycle_;                 //!< index of the next record
+  uint32_t dropped_;               //!< records dropped since the last commit
+  std::atomic<uint64_t> dropped_total_;
+};
+
+//! Abbrev. for shared instances of the TelemetryRecorder
+typedef boost::shared_ptr<TelemetryRecorder> TelemetryRecorderPtr;
+
+} // namespace teb_local_planner
+
+#endif /* TELEMETRY_RECORDER_H_ */
@@ -48,8 +48,11 @@
 
 #include <complex>
 #include <iterator>
+#include <limits>
 
 #include <teb_local_planner/obstacles.h>
+#include <teb_local_planner/obstacle_snapshot.h>
+#include <teb_local_planner/vertex_pool.h>
 
 // G2O Types
 #include <teb_local_planner/g2o_types/vertex_pose.h>
@@ -64,6 +67,35 @@ typedef std::vector<VertexPose*> PoseSequence;
 //! Container of time differences that define the temporal of the trajectory
 typedef std::vector<VertexTimeDiff*> TimeDiffSequence;
 
+class TimedElasticBand;
+
+/**
+ * @class TimePrefixUpdateAction
+ * @brief g2o action that refreshes the cached time prefix of a TimedElasticBand.
+ *
+ * Register it as compute-error and pre-iteration action of an optimizer
+ * in order to keep TimedElasticBand::getTimeAtPose() consistent with the current time diff estimates.
+ * @see TimedElasticBand::timePrefixAction()
+ */
+class TimePrefixUpdateAction : public g2o::HyperGraphAction
+{
+public:
+  TimePrefixUpdateAction() : teb_(NULL) {}
+
+  /**
+   * @brief Set the trajectory to be refreshed
+   */
+  void setBand(TimedElasticBand* teb) {teb_ = teb;}
+
+  /**
+   * @brief Refresh the time prefix (called by g2o)
+   */
+  virtual g2o::HyperGraphAction* operator()(const g2o::HyperGraph* graph, g2o::HyperGraphAction::Parameters* parameters = 0);
+
+protected:
+  TimedElasticBand* teb_; //!< Trajectory whose time prefix is refreshed
+};
+
 
 /**
  * @class TimedElasticBand
@@ -79,6 +111,8 @@ typedef std::vector<VertexTimeDiff*> TimeDiffSequence;
  * The tuple of both sequences defines the underlying trajectory.
  *
  * Poses and time differences are wrapped into a g2o::Vertex class in order to enable the efficient optimization in TebOptimalPlanner. \n
+ * The vertices are stored in chunked pools (see VertexPool) and referenced by pointers, which remain valid until the
+ * corresponding state is removed from the band. The band is not copyable. \n
  * TebOptimalPlanner utilizes this Timed_Elastic_band class for representing an optimizable trajectory.
  *
  * @todo Move decision if the start or goal state should be marked as fixed or unfixed for the optimization to the TebOptimalPlanner class.
@@ -467,13 +501,31 @@ public:
    * 	- inserts a new sample if \f$ \Delta T_i > \Delta T_{ref} + \Delta T_{hyst} \f$
    *    - removes a sample if \f$ \Delta T_i < \Delta T_{ref} - \Delta T_{hyst} \f$
    *
-   * Each call only one new sample (pose-dt-pair) is inserted or removed.
+   * Each call only one new sample (pose-dt-pair) is inserted or removed per time difference.
+   * The resized sequence is rebuilt in a single pass (existing vertices are moved, not copied).
    * @param dt_ref reference temporal resolution
    * @param dt_hysteresis hysteresis to avoid oscillations
 	 * @param min_samples minimum number of samples that should be remain in the trajectory after resizing
    */
   void autoResize(double dt_ref, double dt_hysteresis, int min_samples = 3);
 
+  /**
+   * @brief Resample the whole trajectory w.r.t. a reference temporal resolution in a single pass.
+   *
+   * In contrast to autoResize(), which inserts or removes at most one sample per time difference and call,
+   * the target number of time differences is computed directly from the total transition time
+   * ($ round(\sum \Delta T_i / \Delta T_{ref}) $, but at least \c min_samples).
+   * The current trajectory is linearly interpolated at equidistant time instances, such that the band
+   * reaches its target resolution immediately. Start and goal vertex are kept, intermediate vertices are reused.
+   *
+   * The trajectory remains untouched as long as all time differences satisfy
+   * $ | \Delta T_i - \Delta T_{ref} | \leq \Delta T_{hyst} $.
+   * @param dt_ref reference temporal resolution
+   * @param dt_hysteresis hysteresis to avoid oscillations
+   * @param min_samples minimum number of samples (time differences) of the resampled trajectory
+   */
+  void resample(double dt_ref, double dt_hysteresis, int min_samples = 3);
+
 
   /**
    * @brief Set a pose vertex at pos \c index of the pose sequence to be fixed or unfixed during optimization.
@@ -548,6 +600,15 @@ public:
    */
   int findClosestTrajectoryPose(const Point2dContainer& vertices, double* distance = NULL) const;
 
+  /**
+   * @brief Find the closest point on the trajectory w.r.t. to a provided reference polygon (given as plain array).
+   * @param vertices pointer to the first vertex (the last and first point are connected)
+   * @param no_vertices number of vertices
+   * @param[out] distance [optional] the resulting minimum distance
+   * @return Index to the closest pose in the pose sequence
+   */
+  int findClosestTrajectoryPose(const Eigen::Vector2d* vertices, std::size_t no_vertices, double* distance = NULL) const;
+
   /**
    * @brief Find the closest point on the trajectory w.r.t to a provided obstacle type
    *
@@ -561,6 +622,33 @@ public:
    */
   int findClosestTrajectoryPose(const Obstacle& obstacle, double* distance = NULL) const;
 
+  /**
+   * @brief Find the closest point on the trajectory w.r.t. an obstacle of an ObstacleSnapshot.
+   *
+   * Same as findClosestTrajectoryPose(const Obstacle&, double*), but the obstacle geometry
+   * is taken from the type arrays of the snapshot instead of casting the obstacle.
+   *
+   * @param obstacles Obstacle snapshot
+   * @param obstacle_idx Index of the obstacle in the snapshot
+   * @param[out] distance [optional] the resulting minimum distance
+   * @return Index to the closest pose in the pose sequence
+   */
+  int findClosestTrajectoryPose(const ObstacleSnapshot& obstacles, std::size_t obstacle_idx, double* distance = NULL) const;
+
+  /**
+   * @brief Find the closest pose w.r.t. an obstacle starting from the association of the previous call
+   *
+   * The association is stored per position \c obstacle_idx inside the obstacle container together with the obstacle centroid.
+   * As long as the centroid remains unchanged, only the neighbourhood of the previously associated pose is searched
+   * (descent along the trajectory until the distance increases). A changed centroid invalidates the entry and
+   * the global search findClosestTrajectoryPose() is performed. All associations are reset by clearTimedElasticBand().
+   *
+   * @param obstacles Obstacle snapshot
+   * @param obstacle_idx Stable position of the obstacle inside the snapshot (and its source container)
+   * @return Index to the closest pose in the pose sequence
+   */
+  int findClosestTrajectoryPoseCached(const ObstacleSnapshot& obstacles, std::size_t obstacle_idx);
+
 
   /**
    * @brief Get the length of the internal pose sequence
@@ -582,6 +670,44 @@ public:
    */
   double getSumOfAllTimeDiffs() const;
 
+  /**
+   * @brief Update the cached absolute time \f$ t_i = \sum_{k<i} \Delta T_k \f$ of each pose.
+   *
+   * Only the part of the prefix following the first time difference that changed since the last update is recomputed.
+   * Inserted or removed poses are detected the same way, hence no explicit invalidation is required.
+   * @see getTimeAtPose, timePrefixAction
+   */
+  void updateTimePrefix();
+
+  /**
+   * @brief Get the cached absolute time of pose \c index (requires a preceding updateTimePrefix())
+   * @param index element position inside the pose sequence
+   * @return absolute time w.r.t. the start pose
+   */
+  double getTimeAtPose(unsigned int index) const
+  {
+    ROS_ASSERT(index<time_prefix_.size());
+    return time_prefix_[index];
+  }
+
+  /**
+   * @brief Get the length of the cached time prefix (number of poses at the last updateTimePrefix())
+   */
+  std::size_t sizeTimePrefix() const {return time_prefix_.size();}
+
+  /**
+   * @brief Access a g2o action that calls updateTimePrefix() for this trajectory.
+   *
+   * Register it with g2o::SparseOptimizer::addComputeErrorAction() and g2o::OptimizableGraph::addPreIterationAction()
+   * whenever edges depending on the absolute time are part of the graph. Remove it before the trajectory is destroyed.
+   * @return pointer to the action owned by this trajectory
+   */
+  g2o::HyperGraphAction* timePrefixAction()
+  {
+    time_prefix_action_.setBand(this);
+    return &time_prefix_action_;
+  }
+
   /**
    * @brief Calculate the length (accumulated euclidean distance) of the trajectory
    */
@@ -609,6 +735,20 @@ public:
 protected:
   PoseSequence pose_vec_; //!< Internal container storing the sequence of optimzable pose vertices
   TimeDiffSequence timediff_vec_;  //!< Internal container storing the sequence of optimzable timediff vertices
+  VertexPool<VertexPose> pose_pool_; //!< Storage of the pose vertices (stable handles, recycled slots)
+  VertexPool<VertexTimeDiff> timediff_pool_; //!< Storage of the timediff vertices (stable handles, recycled slots)
+  PoseSequence resize_pose_vec_; //!< Scratch sequence used by autoResize() and resample()
+  TimeDiffSequence resize_timediff_vec_; //!< Scratch sequence used by autoResize() and resample()
+  Point2dContainer resample_positions_; //!< Scratch copy of the positions used by resample()
+  std::vector<double> resample_thetas_; //!< Scratch copy of the orientations used by resample()
+  std::vector<double> resample_times_; //!< Scratch time prefix used by resample()
+
+  std::vector<double> time_prefix_; //!< Cached absolute time of each pose (see updateTimePrefix())
+  std::vector<double> time_prefix_dt_; //!< Time diff values the cached prefix has been computed with
+  TimePrefixUpdateAction time_prefix_action_; //!< g2o action refreshing the cached prefix
+
+  Point2dContainer obstacle_assoc_centroids_; //!< Obstacle centroids of the cached obstacle-pose associations
+  std::vector<int> obstacle_assoc_poses_; //!< Cached pose index per obstacle (-1 if invalid, see findClosestTrajectoryPoseCached())
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -0,0 +1,76 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Copyright (c) 2016 LAAS/CNRS
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef TRAJECTORY_EXPORT_H_
+#define TRAJECTORY_EXPORT_H_
+
+#include <map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <teb_local_planner/TrajectoryMsg.h>
+
+namespace teb_local_planner {
+
+/**
+ * @struct TrajectoryExport
+ * @brief Optimized robot and human trajectories of one planning cycle.
+ *
+ * The export is created once after the optimization with poses (including
+ * orientation quaternions), velocities and times from start. It is shared as
+ * immutable buffer by getFullTrajectory(), the visualization and the feedback
+ * message, so that the trajectories are not recomputed by every consumer.
+ * @see TebOptimalPlanner::getTrajectoryExport
+ */
+struct TrajectoryExport {
+  //! Robot trajectory
+  std::vector<TrajectoryPointMsg> robot;
+  //! Trajectories of the humans in the graph, identified by the human id
+  std::map<uint64_t, std::vector<TrajectoryPointMsg>> humans;
+};
+
+//! Abbrev. for shared instances of a TrajectoryExport
+typedef boost::shared_ptr<TrajectoryExport> TrajectoryExportPtr;
+//! Abbrev. for shared immutable instances of a TrajectoryExport
+typedef boost::shared_ptr<const TrajectoryExport> TrajectoryExportConstPtr;
+
+} // namespace teb_local_planner
+
+#endif /* TRAJECTORY_EXPORT_H_ */
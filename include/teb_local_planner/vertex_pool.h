@@ -0,0 +1,146 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************/
+
+#ifndef VERTEX_POOL_H_
+#define VERTEX_POOL_H_
+
+#include <vector>
+#include <utility>
+
+#include <boost/noncopyable.hpp>
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+
+namespace teb_local_planner
+{
+
+/**
+ * @class VertexPool
+ * @brief Chunked storage for g2o vertices of a TimedElasticBand
+ * 
+ * Vertices are constructed in place inside preallocated, aligned chunks of \c ChunkSize elements.
+ * The returned pointers remain valid until the vertex is destroyed (chunks are never moved or shrunk),
+ * such that they can be used as stable handles by the optimizer. Destroyed slots are recycled by subsequent
+ * calls to create(), hence inserting and removing states of the band does not hit the heap after warm-up
+ * and consecutive states are located close to each other in memory.
+ * 
+ * All vertices must be destroyed with destroy() before the pool itself is destroyed.
+ * @tparam VertexType vertex type (e.g. VertexPose or VertexTimeDiff)
+ * @tparam ChunkSize number of vertices that are allocated at once
+ */
+template <typename VertexType, std::size_t ChunkSize = 64>
+class VertexPool : boost::noncopyable
+{
+public:
+  
+  /**
+   * @brief Construct an empty pool (no memory is allocated until the first vertex is created)
+   */
+  VertexPool() {}
+  
+  /**
+   * @brief Destruct the pool and release all chunks
+   */
+  ~VertexPool()
+  {
+    for (std::size_t i=0; i < chunks_.size(); ++i)
+      allocator_.deallocate(chunks_[i], ChunkSize);
+  }
+  
+  /**
+   * @brief Construct a new vertex inside the pool
+   * @param args Arguments that are forwarded to the constructor of \c VertexType
+   * @return Pointer to the new vertex
+   */
+  template <typename... Args>
+  VertexType* create(Args&&... args)
+  {
+    if (free_.empty())
+      allocateChunk();
+    VertexType* slot = free_.back();
+    free_.pop_back();
+    return ::new (static_cast<void*>(slot)) VertexType(std::forward<Args>(args)...);
+  }
+  
+  /**
+   * @brief Destruct a vertex previously obtained by create() and recycle its slot
+   * @param vertex Pointer to the vertex
+   */
+  void destroy(VertexType* vertex)
+  {
+    vertex->~VertexType();
+    free_.push_back(vertex);
+  }
+  
+  /**
+   * @brief Make sure that at least \c size vertices can be created without allocating a new chunk
+   * @param size Number of vertices that are alive at the same time
+   */
+  void reserve(std::size_t size)
+  {
+    while (chunks_.size()*ChunkSize < size)
+      allocateChunk();
+  }
+  
+  //! Number of vertices that can be created in total without allocating a new chunk
+  std::size_t capacity() const {return chunks_.size()*ChunkSize;}
+  
+protected:
+  
+  /**
+   * @brief Allocate a new chunk and add its slots to the free list
+   * 
+   * The slots are pushed in reverse order such that subsequent calls to create() return ascending addresses.
+   */
+  void allocateChunk()
+  {
+    VertexType* chunk = allocator_.allocate(ChunkSize);
+    chunks_.push_back(chunk);
+    free_.reserve(free_.size() + ChunkSize);
+    for (std::size_t i = ChunkSize; i > 0; --i)
+      free_.push_back(chunk + i - 1);
+  }
+  
+  Eigen::aligned_allocator<VertexType> allocator_; //!< Allocator respecting the alignment of fixed-size Eigen members
+  std::vector<VertexType*> chunks_; //!< Allocated chunks (\c ChunkSize vertices each)
+  std::vector<VertexType*> free_; //!< Unused slots
+};
+
+} // namespace teb_local_planner
+
+#endif /* VERTEX_POOL_H_ */
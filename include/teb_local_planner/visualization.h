@@ -51,6 +51,7 @@
 
 // ros stuff
 #include <ros/publisher.h>
+#include <ros/single_subscriber_publisher.h>
 #include <base_local_planner/goal_functions.h>
 
 // boost
@@ -58,7 +59,9 @@
 #include <boost/graph/graph_traits.hpp>
 
 // std
+#include <atomic>
 #include <iterator>
+#include <map>
 
 // messages
 #include <nav_msgs/Path.h>
@@ -90,6 +93,66 @@ typedef struct {
 
 class TebOptimalPlanner; //!< Forward Declaration
 
+/**
+ * @class MarkerDeltaFilter
+ * @brief Suppress markers that do not differ from the marker sent before with
+ * the same namespace and id.
+ *
+ * Unchanged markers are sent again when half of their lifetime has passed, so
+ * that they do not expire. The filter is reset whenever a subscriber connects
+ * to the topic (see subscriberConnected()), hence new subscribers receive the
+ * complete state, even if they replace a subscriber that just disconnected.
+ */
+class MarkerDeltaFilter {
+public:
+  MarkerDeltaFilter() : reset_(false) {}
+
+  /**
+   * @brief Connect callback of the publisher, requests a reset of the filter
+   *
+   * Called by the ROS spinner thread, the reset is applied by the next call
+   * of update().
+   */
+  void subscriberConnected(const ros::SingleSubscriberPublisher &);
+
+  /**
+   * @brief Request a reset of the filter, e.g. after the markers were deleted
+   *
+   * Safe to call from any thread, the reset is applied by the next call of
+   * update().
+   */
+  void requestReset() { reset_ = true; }
+
+  /**
+   * @brief Reset the filter if requested since the last call
+   * @return \c true if the filter has been reset
+   */
+  bool update();
+
+  /**
+   * @brief Reset the filter and the number of markers sent in the last cycle
+   * if requested since the last call
+   * @param[in,out] last_no_markers number of markers sent in the last cycle
+   */
+  void update(int &last_no_markers);
+
+  /**
+   * @brief Check whether a marker must be sent and remember it if so
+   * @param marker marker to be published
+   * @param now current time
+   * @return \c true if the marker is new, changed or about to expire
+   */
+  bool changed(const visualization_msgs::Marker &marker, const ros::Time &now);
+
+private:
+  struct SentMarker {
+    visualization_msgs::Marker marker;
+    ros::Time stamp;
+  };
+  std::map<std::pair<std::string, int32_t>, SentMarker> sent_;
+  std::atomic<bool> reset_; //!< a reset has been requested
+};
+
 /**
  * @class TebVisualization
  * @brief Visualize stuff from the teb_local_planner
@@ -146,16 +209,17 @@ public:
    * @brief Publish Timed_Elastic_Band related stuff (local plan, pose
    * sequence).
    *
-   * Given a Timed_Elastic_Band instance, publish the local plan to  \e
-   * ../../local_plan
+   * Given the exported trajectory of a Timed_Elastic_Band, publish the local
+   * plan to  \e ../../local_plan
    * and the pose sequence to  \e ../../teb_poses.
-   * @param teb const reference to a Timed_Elastic_Band
+   * @param trajectory trajectory of the current cycle (see TrajectoryExport)
    */
-  void
-  publishLocalPlanAndPoses(const TimedElasticBand &teb,
-                           const BaseRobotFootprintModel &robot_model) const;
+  void publishLocalPlanAndPoses(
+      const std::vector<TrajectoryPointMsg> &trajectory,
+      const BaseRobotFootprintModel &robot_model) const;
   void publishHumanPlanPoses(
-      const std::map<uint64_t, TimedElasticBand> &humans_tebs_map,
+      const std::map<uint64_t, std::vector<TrajectoryPointMsg>>
+          &humans_trajectories,
       const BaseRobotFootprintModel &human_model) const;
   void publishHumanTrajectories(
       const std::vector<HumanPlanTrajCombined> &humans_plans_combined) const;
@@ -297,6 +361,37 @@ protected:
    */
   bool printErrorWhenNotInitialized() const;
 
+  /**
+   * @brief Publish a marker to \e ../../teb_markers if it changed since the
+   * last cycle (see MarkerDeltaFilter)
+   * @param marker marker to be published
+   * @param now current time
+   */
+  void publishMarker(const visualization_msgs::Marker &marker,
+                     const ros::Time &now) const;
+
+  /**
+   * @brief Publish the footprint model at each pose of a trajectory as marker
+   * array (only changed markers are sent)
+   * @param poses trajectory poses
+   * @param model footprint model
+   * @param ns namespace of the markers
+   * @param now current time
+   * @param filter delta filter of \c publisher
+   * @param[in,out] last_no_markers number of markers of the previous cycle
+   * @param publisher marker array publisher
+   */
+  void publishFootprintPoses(const std::vector<geometry_msgs::Pose> &poses,
+                             const BaseRobotFootprintModel &model,
+                             const std::string &ns, const ros::Time &now,
+                             MarkerDeltaFilter &filter, int &last_no_markers,
+                             const ros::Publisher &publisher) const;
+
+  //! Check whether anyone listens to \e ../../teb_markers
+  bool hasMarkerSubscribers() const {
+    return teb_marker_pub_.getNumSubscribers() > 0;
+  }
+
   ros::Publisher global_plan_pub_;         //!< Publisher for the global plan
   ros::Publisher local_plan_pub_;          //!< Publisher for the local plan
   ros::Publisher humans_global_plans_pub_; //!< Publisher for the local plan
@@ -325,6 +420,9 @@ protected:
 
   mutable int last_robot_fp_poses_idx_, last_human_fp_poses_idx_;
 
+  mutable MarkerDeltaFilter marker_filter_; //!< filter of teb_marker_pub_
+  mutable MarkerDeltaFilter robot_fp_poses_filter_, human_fp_poses_filter_;
+
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
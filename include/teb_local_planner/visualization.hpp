@@ -47,16 +47,18 @@ namespace teb_local_planner
 template <typename GraphType>
 void TebVisualization::publishGraph(const GraphType& graph, const std::string& ns_prefix)
 {
-  if ( printErrorWhenNotInitialized() )
+  if ( printErrorWhenNotInitialized() || !hasMarkerSubscribers() )
     return;
 
+  ros::Time now = ros::Time::now();
+
   typedef typename boost::graph_traits<GraphType>::vertex_iterator GraphVertexIterator;
   typedef typename boost::graph_traits<GraphType>::edge_iterator GraphEdgeIterator;
 
   // Visualize Edges
   visualization_msgs::Marker marker;
   marker.header.frame_id = cfg_->map_frame;
-  marker.header.stamp = ros::Time::now();
+  marker.header.stamp = now;
   marker.ns = ns_prefix + "Edges";
   marker.id = 0;
 // #define TRIANGLE
@@ -121,11 +123,13 @@ void TebVisualization::publishGraph(const GraphType& graph, const std::string& n
   marker.color.b = 0.0;
 
   // Now publish edge markers
-  teb_marker_pub_.publish( marker );
+  publishMarker( marker, now );
 
   // Visualize vertices
+  marker.points.clear();
+  marker.colors.clear();
   marker.header.frame_id = cfg_->map_frame;
-  marker.header.stamp = ros::Time::now();
+  marker.header.stamp = now;
   marker.ns = ns_prefix + "Vertices";
   marker.id = 0;
   marker.type = visualization_msgs::Marker::POINTS;
@@ -172,18 +176,20 @@ void TebVisualization::publishGraph(const GraphType& graph, const std::string& n
   marker.color.b = 0.0;
 
   // Now publish vertex markers
-  teb_marker_pub_.publish( marker );
+  publishMarker( marker, now );
 }
 
 template <typename BidirIter>
 void TebVisualization::publishPathContainer(BidirIter first, BidirIter last, const std::string& ns)
 {
-  if ( printErrorWhenNotInitialized() )
+  if ( printErrorWhenNotInitialized() || !hasMarkerSubscribers() )
     return;
 
+  ros::Time now = ros::Time::now();
+
   visualization_msgs::Marker marker;
   marker.header.frame_id = cfg_->map_frame;
-  marker.header.stamp = ros::Time::now();
+  marker.header.stamp = now;
   marker.ns = ns;
   marker.id = 0;
   marker.type = visualization_msgs::Marker::LINE_LIST;
@@ -218,7 +224,7 @@ void TebVisualization::publishPathContainer(BidirIter first, BidirIter last, con
   marker.color.g = 1.0;
   marker.color.b = 0.0;
 
-  teb_marker_pub_.publish( marker );
+  publishMarker( marker, now );
 }
 
 
@@ -0,0 +1,117 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Copyright (c) 2016 LAAS/CNRS
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef WORKER_POOL_H_
+#define WORKER_POOL_H_
+
+#include <cstddef>
+
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace teb_local_planner {
+
+/**
+ * @class WorkerPool
+ * @brief Persistent worker threads that execute batches of independent tasks.
+ *
+ * The threads are created on demand and are kept alive between calls of run(),
+ * hence repeated parallel sections (e.g. in every optimization cycle) do not
+ * pay for creating and joining threads.
+ * @see HomotopyClassPlanner, ParallelBlockSolver
+ */
+class WorkerPool {
+public:
+  typedef boost::function<void(std::size_t)> Task;
+
+  /**
+   * @brief Construct a pool without threads (see run())
+   */
+  WorkerPool();
+
+  /**
+   * @brief Stop and join all threads
+   */
+  ~WorkerPool();
+
+  /**
+   * @brief Execute task(0) ... task(no_tasks-1) in parallel and wait for them.
+   *
+   * The calling thread executes tasks as well, hence at most
+   * <tt>max_threads-1</tt> workers are involved. Only one batch is executed at
+   * a time, run() must not be called concurrently or from within a task.
+   * @param no_tasks Number of tasks
+   * @param task Function that is called with the index of each task
+   * @param max_threads Maximum number of threads executing the tasks (incl. the
+   * calling thread)
+   */
+  void run(std::size_t no_tasks, const Task &task, std::size_t max_threads);
+
+  /**
+   * @brief Get the number of worker threads (excluding the calling thread)
+   */
+  std::size_t sizeThreads() const;
+
+protected:
+  //! Main loop of the worker threads
+  void work();
+
+  //! Execute tasks of the current batch until all of them are claimed
+  void executeTasks(boost::mutex::scoped_lock &lock);
+
+  mutable boost::mutex mutex_;
+  boost::condition_variable start_cond_; //!< A new batch is available
+  boost::condition_variable done_cond_;  //!< All tasks of a batch finished
+  boost::thread_group threads_;
+  std::size_t no_threads_;
+
+  const Task *task_;       //!< Task of the current batch
+  std::size_t no_tasks_;   //!< Number of tasks of the current batch
+  std::size_t max_active_; //!< Workers allowed to join the current batch
+  std::size_t next_task_;  //!< Next unclaimed task of the current batch
+  std::size_t pending_;    //!< Claimed or unclaimed tasks that did not finish
+  unsigned long batch_;    //!< Counter of the batches
+  bool stop_;
+};
+
+} // namespace teb_local_planner
+
+#endif /* WORKER_POOL_H_ */
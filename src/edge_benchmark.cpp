@@ -0,0 +1,606 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************/
+
+#include <teb_local_planner/g2o_types/edge_velocity.h>
+#include <teb_local_planner/g2o_types/edge_acceleration.h>
+#include <teb_local_planner/g2o_types/edge_kinematics.h>
+#include <teb_local_planner/g2o_types/edge_time_optimal.h>
+#include <teb_local_planner/g2o_types/edge_obstacle.h>
+#include <teb_local_planner/g2o_types/edge_dynamic_obstacle.h>
+#include <teb_local_planner/g2o_types/edge_via_point.h>
+#include <teb_local_planner/g2o_types/edge_human_robot_safety.h>
+#include <teb_local_planner/g2o_types/edge_human_human_safety.h>
+#include <teb_local_planner/g2o_types/edge_human_robot_ttc.h>
+#include <teb_local_planner/g2o_types/edge_human_robot_directional.h>
+#include <teb_local_planner/obstacle_snapshot.h>
+#include <teb_local_planner/robot_footprint_model.h>
+
+#include "g2o/core/jacobian_workspace.h"
+
+#include <ros/time.h>
+
+#include <boost/make_shared.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+
+using namespace teb_local_planner; // it is ok here to import everything for benchmarking purposes
+
+// Micro-benchmarks of computeError() and linearizeOplus() of all edge types (see g2o_types/).
+// linearizeOplus() is called through the JacobianWorkspace as in the optimizer, hence edges without
+// analytic Jacobian are measured with the numerical differentiation of g2o.
+// Every benchmark evaluates one edge per state of a random (but seeded) trajectory of the robot and a
+// crossing human with obstacles next to the trajectory.
+//
+// Usage: edge_benchmark [--benchmark_filter=<substring>] [--benchmark_min_time=<s>]
+//                       [--benchmark_repetitions=<n>] [--benchmark_out=<file>] [--poses=<n>]
+// The results are written as JSON (to stdout by default) in the layout of Google Benchmark,
+// hence the files of two commits can be compared with its tools/compare.py.
+
+
+typedef std::vector<g2o::OptimizableGraph::Edge*> EdgeContainer;
+
+//! Trajectories of the robot and a human, obstacles and via-points along the robot trajectory
+struct Scenario
+{
+  Scenario(unsigned int no_poses, unsigned int seed);
+  ~Scenario();
+  
+  std::vector<VertexPose*> robot_poses, human_poses;
+  std::vector<VertexTimeDiff*> robot_dts, human_dts;
+  Point2dContainer via_points;
+  ObstContainer point_obstacles, line_obstacles, polygon_obstacles, dynamic_obstacles;
+  Eigen::Vector2d start_vel, goal_vel;
+};
+
+Scenario::Scenario(unsigned int no_poses, unsigned int seed) : start_vel(0.3, 0.1), goal_vel(0, 0)
+{
+  boost::random::mt19937 rng(seed);
+  boost::random::uniform_real_distribution<double> turn(-0.15, 0.15), step(0.05, 0.25), dt(0.1, 0.35), unit(-1, 1), offset(0.2, 1.0);
+  
+  // the human walks towards the robot, both trajectories cross in the middle
+  PoseSE2 robot(0, 0, 0);
+  PoseSE2 human(no_poses * 0.3, 0.5, M_PI);
+  for (unsigned int i=0; i < no_poses; ++i)
+  {
+    robot_poses.push_back(new VertexPose(robot));
+    human_poses.push_back(new VertexPose(human));
+    if (i+1 < no_poses)
+    {
+      robot_dts.push_back(new VertexTimeDiff(dt(rng)));
+      human_dts.push_back(new VertexTimeDiff(dt(rng)));
+    }
+    via_points.push_back(robot.position() + 0.3 * Eigen::Vector2d(unit(rng), unit(rng)));
+    
+    // obstacles on either side of the trajectory
+    Eigen::Vector2d tangent(std::cos(robot.theta()), std::sin(robot.theta()));
+    Eigen::Vector2d normal(-tangent.y(), tangent.x());
+    Eigen::Vector2d center = robot.position() + (unit(rng) < 0 ? -1 : 1) * offset(rng) * normal;
+    point_obstacles.push_back(boost::make_shared<PointObstacle>(center));
+    line_obstacles.push_back(boost::make_shared<LineObstacle>(center - 0.3 * tangent, center + 0.3 * tangent));
+    PolygonObstacle* polygon = new PolygonObstacle;
+    polygon->pushBackVertex(center + 0.2 * (-tangent - normal));
+    polygon->pushBackVertex(center + 0.2 * (tangent - normal));
+    polygon->pushBackVertex(center + 0.2 * (tangent + normal));
+    polygon->pushBackVertex(center + 0.2 * (-tangent + normal));
+    polygon->finalizePolygon();
+    polygon_obstacles.push_back(ObstaclePtr(polygon));
+    ObstaclePtr dynamic = boost::make_shared<PointObstacle>(center);
+    dynamic->setCentroidVelocity(Eigen::Vector2d(0.5 * unit(rng), 0.5 * unit(rng)));
+    dynamic_obstacles.push_back(dynamic);
+    
+    robot.theta() = g2o::normalize_theta(robot.theta() + turn(rng));
+    robot.position() += step(rng) * Eigen::Vector2d(std::cos(robot.theta()), std::sin(robot.theta()));
+    human.theta() = g2o::normalize_theta(human.theta() + turn(rng));
+    human.position() += step(rng) * Eigen::Vector2d(std::cos(human.theta()), std::sin(human.theta()));
+  }
+}
+
+Scenario::~Scenario()
+{
+  for (std::size_t i=0; i < robot_poses.size(); ++i)
+  {
+    delete robot_poses[i];
+    delete human_poses[i];
+  }
+  for (std::size_t i=0; i < robot_dts.size(); ++i)
+  {
+    delete robot_dts[i];
+    delete human_dts[i];
+  }
+}
+
+
+//! Edges of a single benchmark (owned)
+struct Benchmark
+{
+  Benchmark(const std::string& benchmark_name) : name(benchmark_name) {}
+  
+  std::string name;
+  EdgeContainer edges;
+};
+
+//! Allocate an edge with identity information matrix and add it to \c edges
+template <typename EdgeType>
+EdgeType* makeEdge(EdgeContainer& edges, EdgeType* edge = NULL)
+{
+  if (!edge)
+    edge = new EdgeType;
+  edge->setInformation(EdgeType::InformationType::Identity());
+  edges.push_back(edge);
+  return edge;
+}
+
+//! Robot footprint models with a name
+typedef std::vector< std::pair<std::string, RobotFootprintModelPtr> > FootprintContainer;
+
+FootprintContainer createFootprints()
+{
+  Point2dContainer rectangle;
+  rectangle.push_back(Eigen::Vector2d(-0.3, -0.2));
+  rectangle.push_back(Eigen::Vector2d(0.3, -0.2));
+  rectangle.push_back(Eigen::Vector2d(0.3, 0.2));
+  rectangle.push_back(Eigen::Vector2d(-0.3, 0.2));
+  
+  FootprintContainer footprints;
+  footprints.push_back(std::make_pair("point_footprint", RobotFootprintModelPtr(new PointRobotFootprint())));
+  footprints.push_back(std::make_pair("circular_footprint", RobotFootprintModelPtr(new CircularRobotFootprint(0.3))));
+  footprints.push_back(std::make_pair("two_circles_footprint", RobotFootprintModelPtr(new TwoCirclesRobotFootprint(0.2, 0.25, 0.2, 0.25))));
+  footprints.push_back(std::make_pair("line_footprint", RobotFootprintModelPtr(new LineRobotFootprint(Eigen::Vector2d(-0.3, 0), Eigen::Vector2d(0.3, 0)))));
+  footprints.push_back(std::make_pair("polygon_footprint", RobotFootprintModelPtr(new PolygonRobotFootprint(rectangle))));
+  return footprints;
+}
+
+//! Create the edges of all benchmarks (in the order of TebOptimalPlanner::buildGraph())
+void createBenchmarks(const Scenario& s, const TebConfig& cfg, const TebConfig& cfg_carlike, const FootprintContainer& footprints,
+                      const std::vector< std::pair<std::string, const ObstContainer*> >& obstacles,
+                      const std::vector<ObstacleSnapshot*>& snapshots, std::vector<Benchmark>& benchmarks)
+{
+  const std::size_t n = s.robot_dts.size(); // number of consecutive pairs of poses
+  
+  for (std::size_t f=0; f < footprints.size(); ++f)
+  {
+    for (std::size_t o=0; o < obstacles.size(); ++o)
+    {
+      benchmarks.push_back(Benchmark("EdgeObstacle/" + footprints[f].first + "/" + obstacles[o].first + "/virtual"));
+      for (std::size_t i=0; i < s.robot_poses.size(); ++i)
+      {
+        EdgeObstacle* edge = makeEdge<EdgeObstacle>(benchmarks.back().edges);
+        edge->setVertex(0, s.robot_poses[i]);
+        edge->setParameters(cfg, footprints[f].second.get(), (*obstacles[o].second)[i].get());
+      }
+      benchmarks.push_back(Benchmark("EdgeObstacle/" + footprints[f].first + "/" + obstacles[o].first + "/snapshot"));
+      for (std::size_t i=0; i < s.robot_poses.size(); ++i)
+      {
+        EdgeObstacle* edge = makeEdge<EdgeObstacle>(benchmarks.back().edges);
+        edge->setVertex(0, s.robot_poses[i]);
+        edge->setParameters(cfg, footprints[f].second.get(), snapshots[o], i);
+      }
+    }
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeDynamicObstacle"));
+  for (std::size_t i=0; i < s.robot_poses.size(); ++i)
+  {
+    std::size_t window = std::min<std::size_t>(i, std::max(cfg.obstacles.dynamic_obstacle_dt_window, 1));
+    EdgeDynamicObstacle* edge = makeEdge(benchmarks.back().edges, new EdgeDynamicObstacle(i, window));
+    edge->setVertex(0, s.robot_poses[i]);
+    for (std::size_t k=0; k < window; ++k)
+      edge->setVertex(k+1, s.robot_dts[i - window + k]);
+    edge->setObstacle(s.dynamic_obstacles[i].get());
+    edge->setTebConfig(cfg);
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeViaPoint"));
+  for (std::size_t i=0; i < s.robot_poses.size(); ++i)
+  {
+    EdgeViaPoint* edge = makeEdge<EdgeViaPoint>(benchmarks.back().edges);
+    edge->setVertex(0, s.robot_poses[i]);
+    edge->setParameters(cfg, &s.via_points[i]);
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeVelocity"));
+  for (std::size_t i=0; i < n; ++i)
+  {
+    EdgeVelocity* edge = makeEdge<EdgeVelocity>(benchmarks.back().edges);
+    edge->setVertex(0, s.robot_poses[i]);
+    edge->setVertex(1, s.robot_poses[i+1]);
+    edge->setVertex(2, s.robot_dts[i]);
+    edge->setTebConfig(cfg);
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeVelocityHuman"));
+  for (std::size_t i=0; i < n; ++i)
+  {
+    EdgeVelocityHuman* edge = makeEdge<EdgeVelocityHuman>(benchmarks.back().edges);
+    edge->setVertex(0, s.human_poses[i]);
+    edge->setVertex(1, s.human_poses[i+1]);
+    edge->setVertex(2, s.human_dts[i]);
+    edge->setTebConfig(cfg);
+  }
+  
+  // start and goal edges exist only once per trajectory, they are evaluated on every pair of poses here
+  benchmarks.push_back(Benchmark("EdgeAccelerationStart"));
+  for (std::size_t i=0; i < n; ++i)
+  {
+    EdgeAccelerationStart* edge = makeEdge<EdgeAccelerationStart>(benchmarks.back().edges);
+    edge->setVertex(0, s.robot_poses[i]);
+    edge->setVertex(1, s.robot_poses[i+1]);
+    edge->setVertex(2, s.robot_dts[i]);
+    edge->setInitialVelocity(s.start_vel);
+    edge->setTebConfig(cfg);
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeAcceleration"));
+  for (std::size_t i=0; i+1 < n; ++i)
+  {
+    EdgeAcceleration* edge = makeEdge<EdgeAcceleration>(benchmarks.back().edges);
+    edge->setVertex(0, s.robot_poses[i]);
+    edge->setVertex(1, s.robot_poses[i+1]);
+    edge->setVertex(2, s.robot_poses[i+2]);
+    edge->setVertex(3, s.robot_dts[i]);
+    edge->setVertex(4, s.robot_dts[i+1]);
+    edge->setTebConfig(cfg);
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeAccelerationGoal"));
+  for (std::size_t i=0; i < n; ++i)
+  {
+    EdgeAccelerationGoal* edge = makeEdge<EdgeAccelerationGoal>(benchmarks.back().edges);
+    edge->setVertex(0, s.robot_poses[i]);
+    edge->setVertex(1, s.robot_poses[i+1]);
+    edge->setVertex(2, s.robot_dts[i]);
+    edge->setGoalVelocity(s.goal_vel);
+    edge->setTebConfig(cfg);
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeAccelerationHumanStart"));
+  for (std::size_t i=0; i < n; ++i)
+  {
+    EdgeAccelerationHumanStart* edge = makeEdge<EdgeAccelerationHumanStart>(benchmarks.back().edges);
+    edge->setVertex(0, s.human_poses[i]);
+    edge->setVertex(1, s.human_poses[i+1]);
+    edge->setVertex(2, s.human_dts[i]);
+    edge->setInitialVelocity(s.start_vel);
+    edge->setTebConfig(cfg);
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeAccelerationHuman"));
+  for (std::size_t i=0; i+1 < n; ++i)
+  {
+    EdgeAccelerationHuman* edge = makeEdge<EdgeAccelerationHuman>(benchmarks.back().edges);
+    edge->setVertex(0, s.human_poses[i]);
+    edge->setVertex(1, s.human_poses[i+1]);
+    edge->setVertex(2, s.human_poses[i+2]);
+    edge->setVertex(3, s.human_dts[i]);
+    edge->setVertex(4, s.human_dts[i+1]);
+    edge->setTebConfig(cfg);
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeAccelerationHumanGoal"));
+  for (std::size_t i=0; i < n; ++i)
+  {
+    EdgeAccelerationHumanGoal* edge = makeEdge<EdgeAccelerationHumanGoal>(benchmarks.back().edges);
+    edge->setVertex(0, s.human_poses[i]);
+    edge->setVertex(1, s.human_poses[i+1]);
+    edge->setVertex(2, s.human_dts[i]);
+    edge->setGoalVelocity(s.goal_vel);
+    edge->setTebConfig(cfg);
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeTimeOptimal"));
+  for (std::size_t i=0; i < n; ++i)
+  {
+    EdgeTimeOptimal* edge = makeEdge<EdgeTimeOptimal>(benchmarks.back().edges);
+    edge->setVertex(0, s.robot_dts[i]);
+    edge->setTebConfig(cfg);
+    edge->setInitialTime(s.robot_dts[i]->dt());
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeKinematicsDiffDrive"));
+  for (std::size_t i=0; i < n; ++i)
+  {
+    EdgeKinematicsDiffDrive* edge = makeEdge<EdgeKinematicsDiffDrive>(benchmarks.back().edges);
+    edge->setVertex(0, s.robot_poses[i]);
+    edge->setVertex(1, s.robot_poses[i+1]);
+    edge->setTebConfig(cfg);
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeKinematicsCarlike"));
+  for (std::size_t i=0; i < n; ++i)
+  {
+    EdgeKinematicsCarlike* edge = makeEdge<EdgeKinematicsCarlike>(benchmarks.back().edges);
+    edge->setVertex(0, s.robot_poses[i]);
+    edge->setVertex(1, s.robot_poses[i+1]);
+    edge->setTebConfig(cfg_carlike);
+  }
+  
+  for (std::size_t f=0; f < footprints.size(); ++f)
+  {
+    benchmarks.push_back(Benchmark("EdgeHumanRobotSafety/" + footprints[f].first));
+    for (std::size_t i=0; i < s.robot_poses.size(); ++i)
+    {
+      EdgeHumanRobotSafety* edge = makeEdge<EdgeHumanRobotSafety>(benchmarks.back().edges);
+      edge->setVertex(0, s.robot_poses[i]);
+      edge->setVertex(1, s.human_poses[i]);
+      edge->setParameters(cfg, footprints[f].second.get(), cfg.human.radius);
+    }
+  }
+  
+  // consecutive poses of the human stand in for two humans close to each other
+  benchmarks.push_back(Benchmark("EdgeHumanHumanSafety"));
+  for (std::size_t i=0; i+1 < s.human_poses.size(); ++i)
+  {
+    EdgeHumanHumanSafety* edge = makeEdge<EdgeHumanHumanSafety>(benchmarks.back().edges);
+    edge->setVertex(0, s.human_poses[i]);
+    edge->setVertex(1, s.human_poses[i+1]);
+    edge->setParameters(cfg, cfg.human.radius);
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeHumanRobotTTC"));
+  for (std::size_t i=0; i < n; ++i)
+  {
+    EdgeHumanRobotTTC* edge = makeEdge<EdgeHumanRobotTTC>(benchmarks.back().edges);
+    edge->setVertex(0, s.robot_poses[i]);
+    edge->setVertex(1, s.robot_poses[i+1]);
+    edge->setVertex(2, s.robot_dts[i]);
+    edge->setVertex(3, s.human_poses[i]);
+    edge->setVertex(4, s.human_poses[i+1]);
+    edge->setVertex(5, s.human_dts[i]);
+    edge->setParameters(cfg, 0.3, cfg.human.radius);
+  }
+  
+  benchmarks.push_back(Benchmark("EdgeHumanRobotDirectional"));
+  for (std::size_t i=0; i < n; ++i)
+  {
+    EdgeHumanRobotDirectional* edge = makeEdge<EdgeHumanRobotDirectional>(benchmarks.back().edges);
+    edge->setVertex(0, s.robot_poses[i]);
+    edge->setVertex(1, s.robot_poses[i+1]);
+    edge->setVertex(2, s.robot_dts[i]);
+    edge->setVertex(3, s.human_poses[i]);
+    edge->setVertex(4, s.human_poses[i+1]);
+    edge->setVertex(5, s.human_dts[i]);
+    edge->setTebConfig(cfg);
+  }
+}
+
+
+//! Result of a measurement
+struct Timing
+{
+  double real_time; //!< wall time per edge [ns]
+  double cpu_time; //!< cpu time per edge [ns]
+  unsigned long iterations; //!< evaluations of all edges
+  
+  bool operator<(const Timing& other) const {return real_time < other.real_time;}
+};
+
+//! Evaluate all edges repeatedly for at least \c min_time seconds (the number of iterations grows as in Google Benchmark)
+Timing measure(const EdgeContainer& edges, bool linearize, g2o::JacobianWorkspace& workspace, double min_time)
+{
+  unsigned long iterations = 1;
+  while (true)
+  {
+    ros::WallTime start = ros::WallTime::now();
+    std::clock_t cpu_start = std::clock();
+    for (unsigned long k=0; k < iterations; ++k)
+    {
+      if (linearize)
+      {
+        for (std::size_t i=0; i < edges.size(); ++i)
+          edges[i]->linearizeOplus(workspace);
+      }
+      else
+      {
+        for (std::size_t i=0; i < edges.size(); ++i)
+          edges[i]->computeError();
+      }
+    }
+    double real = (ros::WallTime::now() - start).toSec();
+    double cpu = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    
+    if (real >= min_time || iterations >= 1000000000ul)
+    {
+      double evaluations = double(iterations) * std::max<std::size_t>(edges.size(), 1);
+      Timing timing = {real / evaluations * 1e9, cpu / evaluations * 1e9, iterations};
+      return timing;
+    }
+    double factor = real > 0 ? std::min(1.4 * min_time / real, 10.0) : 10.0;
+    iterations = std::max(iterations + 1, (unsigned long) (iterations * factor));
+  }
+}
+
+//! Read the value of an option "--name=value"
+bool parseOption(const char* arg, const char* name, std::string& value)
+{
+  std::size_t length = std::strlen(name);
+  if (std::strncmp(arg, name, length) != 0 || arg[length] != '=')
+    return false;
+  value = arg + length + 1;
+  return true;
+}
+
+
+int main(int argc, char** argv)
+{
+  std::string filter, out;
+  double min_time = 0.1;
+  int repetitions = 3;
+  int no_poses = 100;
+  for (int i=1; i < argc; ++i)
+  {
+    std::string value;
+    if (parseOption(argv[i], "--benchmark_filter", value))
+      filter = value;
+    else if (parseOption(argv[i], "--benchmark_min_time", value))
+      min_time = std::atof(value.c_str());
+    else if (parseOption(argv[i], "--benchmark_repetitions", value))
+      repetitions = std::max(std::atoi(value.c_str()), 1);
+    else if (parseOption(argv[i], "--benchmark_out", value))
+      out = value;
+    else if (parseOption(argv[i], "--poses", value))
+      no_poses = std::max(std::atoi(value.c_str()), 3);
+    else
+    {
+      std::fprintf(stderr, "Usage: %s [--benchmark_filter=<substring>] [--benchmark_min_time=<s>] [--benchmark_repetitions=<n>] "
+                           "[--benchmark_out=<file>] [--poses=<n>]\n", argv[0]);
+      return 1;
+    }
+  }
+  
+  std::FILE* file = out.empty() ? stdout : std::fopen(out.c_str(), "w");
+  if (!file)
+  {
+    std::fprintf(stderr, "Cannot write '%s'.\n", out.c_str());
+    return 1;
+  }
+  
+  // default parameters (the carlike edge needs a turning radius)
+  TebConfig cfg;
+  TebConfig cfg_carlike;
+  cfg_carlike.robot.min_turning_radius = 0.5;
+  
+  Scenario scenario(no_poses, 42);
+  FootprintContainer footprints = createFootprints();
+  std::vector< std::pair<std::string, const ObstContainer*> > obstacles;
+  obstacles.push_back(std::make_pair("point_obstacle", &scenario.point_obstacles));
+  obstacles.push_back(std::make_pair("line_obstacle", &scenario.line_obstacles));
+  obstacles.push_back(std::make_pair("polygon_obstacle", &scenario.polygon_obstacles));
+  std::vector<ObstacleSnapshot*> snapshots;
+  for (std::size_t o=0; o < obstacles.size(); ++o)
+  {
+    snapshots.push_back(new ObstacleSnapshot);
+    snapshots.back()->build(obstacles[o].second);
+  }
+  
+  std::vector<Benchmark> benchmarks;
+  createBenchmarks(scenario, cfg, cfg_carlike, footprints, obstacles, snapshots, benchmarks);
+  
+  g2o::JacobianWorkspace workspace;
+  for (std::size_t b=0; b < benchmarks.size(); ++b)
+  {
+    for (std::size_t i=0; i < benchmarks[b].edges.size(); ++i)
+      workspace.updateSize(benchmarks[b].edges[i]);
+  }
+  workspace.allocate();
+  
+  // context in the layout of Google Benchmark
+  char date[64];
+  std::time_t now = std::time(NULL);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+  char host_name[256] = "";
+  gethostname(host_name, sizeof(host_name) - 1);
+  std::fprintf(file, "{\n  \"context\": {\n");
+  std::fprintf(file, "    \"date\": \"%s\",\n    \"host_name\": \"%s\",\n    \"executable\": \"%s\",\n", date, host_name, argv[0]);
+  std::fprintf(file, "    \"num_cpus\": %u,\n", boost::thread::hardware_concurrency());
+#ifdef NDEBUG
+  std::fprintf(file, "    \"library_build_type\": \"release\",\n");
+#else
+  std::fprintf(file, "    \"library_build_type\": \"debug\",\n");
+#endif
+#ifdef TEB_FLOAT_PRECISION
+  std::fprintf(file, "    \"precision\": \"float\",\n");
+#else
+  std::fprintf(file, "    \"precision\": \"double\",\n");
+#endif
+#ifdef USE_ANALYTIC_JACOBI
+  std::fprintf(file, "    \"analytic_jacobians\": true,\n");
+#else
+  std::fprintf(file, "    \"analytic_jacobians\": false,\n");
+#endif
+  std::fprintf(file, "    \"poses\": %d\n  },\n  \"benchmarks\": [", no_poses);
+  
+  bool first = true;
+  for (std::size_t b=0; b < benchmarks.size(); ++b)
+  {
+    const EdgeContainer& edges = benchmarks[b].edges;
+    
+    // sum of the squared errors, identical results across commits indicate unchanged kernels
+    double checksum = 0;
+    for (std::size_t i=0; i < edges.size(); ++i)
+    {
+      edges[i]->computeError();
+      checksum += edges[i]->chi2();
+    }
+    
+    for (int linearize=0; linearize < 2; ++linearize)
+    {
+      std::string name = benchmarks[b].name + (linearize ? "/linearizeOplus" : "/computeError");
+      if (!filter.empty() && name.find(filter) == std::string::npos)
+        continue;
+      
+      std::vector<Timing> timings;
+      for (int r=0; r < repetitions; ++r)
+        timings.push_back(measure(edges, linearize, workspace, min_time));
+      std::sort(timings.begin(), timings.end());
+      const Timing& median = timings[timings.size() / 2];
+      std::fprintf(stderr, "%-75s %10.1f ns\n", name.c_str(), median.real_time);
+      
+      std::fprintf(file, "%s\n    {\n", first ? "" : ",");
+      std::fprintf(file, "      \"name\": \"%s\",\n      \"run_name\": \"%s\",\n      \"run_type\": \"iteration\",\n", name.c_str(), name.c_str());
+      std::fprintf(file, "      \"repetitions\": %d,\n      \"edges\": %lu,\n      \"iterations\": %lu,\n", repetitions, (unsigned long) edges.size(), median.iterations);
+      std::fprintf(file, "      \"real_time\": %.6g,\n      \"cpu_time\": %.6g,\n      \"time_unit\": \"ns\",\n", median.real_time, median.cpu_time);
+      std::fprintf(file, "      \"real_time_min\": %.6g,\n      \"real_time_max\": %.6g,\n", timings.front().real_time, timings.back().real_time);
+      std::fprintf(file, "      \"checksum\": %.17g\n    }", checksum);
+      first = false;
+    }
+  }
+  std::fprintf(file, "\n  ]\n}\n");
+  if (file != stdout)
+    std::fclose(file);
+  
+  // the edges refer to the vertices, obstacles and snapshots
+  for (std::size_t b=0; b < benchmarks.size(); ++b)
+  {
+    for (std::size_t i=0; i < benchmarks[b].edges.size(); ++i)
+      delete benchmarks[b].edges[i];
+  }
+  for (std::size_t o=0; o < snapshots.size(); ++o)
+    delete snapshots[o];
+  return 0;
+}
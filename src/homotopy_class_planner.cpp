@@ -67,12 +67,14 @@ inline std::complex<long double> getCplxFromMsgPoseStamped(const geometry_msgs::
 
 
 HomotopyClassPlanner::HomotopyClassPlanner() : obstacles_(NULL), via_points_(NULL),  cfg_(NULL), robot_model_(new PointRobotFootprint()),
-                                               initial_plan_(NULL), initialized_(false)
+                                               initial_plan_(NULL), h_signature_bucket_size_(0), search_expansions_(0), search_cut_off_(false),
+                                               search_expansion_limit_(0), search_expansions_limited_(false), initialized_(false)
 {
 }
 
 HomotopyClassPlanner::HomotopyClassPlanner(const TebConfig& cfg, ObstContainer* obstacles, RobotFootprintModelPtr robot_model,
-                                           TebVisualizationPtr visual, const ViaPointContainer* via_points) : initial_plan_(NULL)
+                                           TebVisualizationPtr visual, const ViaPointContainer* via_points) : initial_plan_(NULL), h_signature_bucket_size_(0),
+                                           search_expansions_(0), search_cut_off_(false), search_expansion_limit_(0), search_expansions_limited_(false)
 {
   initialize(cfg, obstacles, robot_model, visual, via_points);
 }
@@ -90,6 +92,9 @@ void HomotopyClassPlanner::initialize(const TebConfig& cfg, ObstContainer* obsta
   robot_model_ = robot_model;
   initialized_ = true;
 
+  // pre-initialize a solver context for each candidate
+  optimizer_pool_.reserve(cfg.hcp.max_number_classes);
+
   setVisualization(visual);
 }
 
@@ -136,6 +141,12 @@ bool HomotopyClassPlanner::plan(const PoseSE2& start, const PoseSE2& goal, const
   ROS_ASSERT_MSG(initialized_, "Call initialize() first.");
   auto start_time = ros::Time::now();
 
+  // feasibility results refer to the trajectories of the previous cycle
+  infeasible_tebs_.clear();
+
+  // flat copy of the obstacles that is shared by all candidates during this cycle
+  obstacle_snapshot_.build(obstacles_);
+
   // Update old TEBs with new start, goal and velocity
   auto teb_update_start_time = ros::Time::now();
   updateAllTEBs(start, goal, start_vel);
@@ -166,6 +177,19 @@ bool HomotopyClassPlanner::plan(const PoseSE2& start, const PoseSE2& goal, const
   auto other_time = ros::Time::now() - other_start_time;
 
   auto total_time = ros::Time::now() - start_time;
+
+  // record the selected candidate
+  TebOptimalPlannerConstPtr best_teb = bestTeb();
+  if (telemetry_ && best_teb)
+  {
+    double phase_times[TELEMETRY_PHASES];
+    phase_times[TELEMETRY_PHASE_PREPARATION] = pre_plan_time + teb_update_time.toSec() + hex_time.toSec() + via_time.toSec();
+    phase_times[TELEMETRY_PHASE_HUMANS] = 0;
+    phase_times[TELEMETRY_PHASE_OPTIMIZATION] = teb_time.toSec();
+    phase_times[TELEMETRY_PHASE_TOTAL] = total_time.toSec() + pre_plan_time;
+    best_teb->recordTelemetry(*telemetry_, phase_times);
+  }
+
   ROS_INFO_STREAM_COND((total_time.toSec() + pre_plan_time) > 0.05, "\nhomotopy class plan times:\n" <<
     "\ttotal plan time            " << std::to_string(total_time.toSec() + pre_plan_time) << "\n" <<
     "\tpre-plan time              " << std::to_string(pre_plan_time) << "\n" <<
@@ -208,7 +232,7 @@ void HomotopyClassPlanner::visualize()
     TebOptimalPlannerConstPtr best_teb = bestTeb();
     if (best_teb)
     {
-      visualization_->publishLocalPlanAndPoses(best_teb->teb(), *robot_model_);
+      visualization_->publishLocalPlanAndPoses(best_teb->getTrajectoryExport()->robot, *robot_model_);
 
       if (best_teb->teb().sizePoses() > 0) //TODO maybe store current pose (start) within plan method as class field.
         visualization_->publishRobotFootprintModel(best_teb->teb().Pose(0), *robot_model_);
@@ -251,6 +275,9 @@ void HomotopyClassPlanner::createGraph(const PoseSE2& start, const PoseSE2& goal
   normal.normalize();
   normal = normal*dist_to_obst; // scale with obstacle_distance;
 
+  // broad phase for the collision checks of the roadmap edges
+  obstacle_grid_.build(&obstacle_snapshot_, dist_to_obst);
+
   // Insert Vertices
   HcGraphVertexType start_vtx = boost::add_vertex(graph_); // start vertex
   graph_[start_vtx].pos = start.position();
@@ -260,29 +287,26 @@ void HomotopyClassPlanner::createGraph(const PoseSE2& start, const PoseSE2& goal
   std::pair<HcGraphVertexType,HcGraphVertexType> nearest_obstacle; // both vertices are stored
   double min_dist = DBL_MAX;
 
-  if (obstacles_!=NULL)
+  for (Point2dContainer::const_iterator centroid = obstacle_snapshot_.centroids().begin(); centroid != obstacle_snapshot_.centroids().end(); ++centroid)
   {
-    for (ObstContainer::const_iterator it_obst = obstacles_->begin(); it_obst != obstacles_->end(); ++it_obst)
-    {
-      // check if obstacle is placed in front of start point
-      Eigen::Vector2d start2obst = (*it_obst)->getCentroid() - start.position();
-      double dist = start2obst.norm();
-      if (start2obst.dot(diff)/dist<0.1)
-        continue;
+    // check if obstacle is placed in front of start point
+    Eigen::Vector2d start2obst = *centroid - start.position();
+    double dist = start2obst.norm();
+    if (start2obst.dot(diff)/dist<0.1)
+      continue;
 
-      // Add Keypoints
-      HcGraphVertexType u = boost::add_vertex(graph_);
-      graph_[u].pos = (*it_obst)->getCentroid() + normal;
-      HcGraphVertexType v = boost::add_vertex(graph_);
-      graph_[v].pos = (*it_obst)->getCentroid() - normal;
+    // Add Keypoints
+    HcGraphVertexType u = boost::add_vertex(graph_);
+    graph_[u].pos = *centroid + normal;
+    HcGraphVertexType v = boost::add_vertex(graph_);
+    graph_[v].pos = *centroid - normal;
 
-      // store nearest obstacle
-      if (obstacle_heading_threshold && dist<min_dist)
-      {
-        min_dist = dist;
-        nearest_obstacle.first = u;
-        nearest_obstacle.second = v;
-      }
+    // store nearest obstacle
+    if (obstacle_heading_threshold && dist<min_dist)
+    {
+      min_dist = dist;
+      nearest_obstacle.first = u;
+      nearest_obstacle.second = v;
     }
   }
 
@@ -290,6 +314,7 @@ void HomotopyClassPlanner::createGraph(const PoseSE2& start, const PoseSE2& goal
   graph_[goal_vtx].pos = goal.position();
 
   // Insert Edges
+  std::vector< std::pair<HcGraphVertexType,HcGraphVertexType> > candidate_edges;
   HcGraphVertexIterator it_i, end_i, it_j, end_j;
   for (boost::tie(it_i,end_i) = boost::vertices(graph_); it_i!=end_i-1; ++it_i) // ignore goal in this loop
   {
@@ -323,28 +348,13 @@ void HomotopyClassPlanner::createGraph(const PoseSE2& start, const PoseSE2& goal
         }
       }
 
-      // Collision Check
-
-      if (obstacles_!=NULL)
-      {
-        bool collision = false;
-        for (ObstContainer::const_iterator it_obst = obstacles_->begin(); it_obst != obstacles_->end(); ++it_obst)
-        {
-          if ( (*it_obst)->checkLineIntersection(graph_[*it_i].pos,graph_[*it_j].pos, 0.5*dist_to_obst) )
-          {
-            collision = true;
-            break;
-          }
-        }
-        if (collision)
-          continue;
-      }
-
-      // Create Edge
-      boost::add_edge(*it_i,*it_j,graph_);
+      // Collision check and edge creation are performed below
+      candidate_edges.push_back(std::make_pair(*it_i, *it_j));
     }
   }
 
+  addCollisionFreeEdges(candidate_edges, 0.5*dist_to_obst);
+
 
   // Find all paths between start and goal!
   std::vector<HcGraphVertexType> visited;
@@ -353,6 +363,83 @@ void HomotopyClassPlanner::createGraph(const PoseSE2& start, const PoseSE2& goal
 }
 
 
+void HomotopyClassPlanner::addCollisionFreeEdges(const std::vector< std::pair<HcGraphVertexType,HcGraphVertexType> >& candidate_edges, double min_dist,
+                                                 std::vector<char>* collision)
+{
+  std::vector<char> collision_all;
+  if (collision == NULL)
+  {
+    collision_all.assign(candidate_edges.size(), -1);
+    collision = &collision_all;
+  }
+
+  // collect all edges without a known result
+  std::vector<std::size_t> indices;
+  for (std::size_t i = 0; i < candidate_edges.size(); ++i)
+  {
+    if ((*collision)[i] != 0 && (*collision)[i] != 1)
+      indices.push_back(i);
+  }
+
+  unsigned int no_threads = boost::thread::hardware_concurrency();
+  if (cfg_->hcp.enable_multithreading && no_threads > 1 && indices.size() > 4*no_threads)
+  {
+    // the graph is not modified while checking, hence it can be accessed concurrently
+    worker_pool_.run(no_threads, boost::bind(&HomotopyClassPlanner::checkEdgesCollisionTask, this, &candidate_edges, min_dist, &indices,
+                                             _1, (std::size_t) no_threads, collision),
+                     no_threads);
+  }
+  else
+    checkEdgesCollision(candidate_edges, min_dist, indices, 0, indices.size(), collision);
+
+  // add edges in the original order to keep the graph (and the resulting paths) deterministic
+  for (std::size_t i = 0; i < candidate_edges.size(); ++i)
+  {
+    if (!(*collision)[i])
+      boost::add_edge(candidate_edges[i].first, candidate_edges[i].second, graph_);
+  }
+}
+
+
+void HomotopyClassPlanner::checkEdgesCollision(const std::vector< std::pair<HcGraphVertexType,HcGraphVertexType> >& candidate_edges, double min_dist,
+                                               const std::vector<std::size_t>& indices, std::size_t begin, std::size_t end, std::vector<char>* collision) const
+{
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    const std::pair<HcGraphVertexType,HcGraphVertexType>& edge = candidate_edges[indices[i]];
+    (*collision)[indices[i]] = obstacle_grid_.checkLineIntersection(graph_[edge.first].pos, graph_[edge.second].pos, min_dist);
+  }
+}
+
+void HomotopyClassPlanner::checkEdgesCollisionTask(const std::vector< std::pair<HcGraphVertexType,HcGraphVertexType> >* candidate_edges, double min_dist,
+                                                   const std::vector<std::size_t>* indices, std::size_t chunk, std::size_t no_chunks,
+                                                   std::vector<char>* collision) const
+{
+  checkEdgesCollision(*candidate_edges, min_dist, *indices, indices->size() * chunk / no_chunks, indices->size() * (chunk+1) / no_chunks, collision);
+}
+
+
+bool HomotopyClassPlanner::computeObstacleBoxes(std::vector<ObstacleBox>& boxes) const
+{
+  boxes.clear();
+  bool bounded = true;
+  for (std::size_t i = 0; i < obstacle_snapshot_.size(); ++i)
+  {
+    if (!obstacle_snapshot_.hasBoundingBox(i))
+    {
+      bounded = false;
+      continue;
+    }
+    const Eigen::Vector2d& box_min = obstacle_snapshot_.boxMin(i);
+    const Eigen::Vector2d& box_max = obstacle_snapshot_.boxMax(i);
+    ObstacleBox box = {{box_min.x(), box_min.y(), box_max.x(), box_max.y()}};
+    boxes.push_back(box);
+  }
+  std::sort(boxes.begin(), boxes.end());
+  return bounded;
+}
+
+
 void HomotopyClassPlanner::createProbRoadmapGraph(const PoseSE2& start, const PoseSE2& goal, double dist_to_obst, int no_samples,
                                                   double obstacle_heading_threshold, boost::optional<const Eigen::Vector2d&> start_velocity)
 {
@@ -376,6 +463,9 @@ void HomotopyClassPlanner::createProbRoadmapGraph(const PoseSE2& start, const Po
   Eigen::Vector2d normal(-diff.coeffRef(1),diff.coeffRef(0)); // normal-vector
   normal.normalize();
 
+  // broad phase for the collision checks of the samples and roadmap edges
+  obstacle_grid_.build(&obstacle_snapshot_, dist_to_obst);
+
   // Now sample vertices between start, goal and a specified width between both sides
   // Let's start with a square area between start and goal (maybe change it later to something like a circle or whatever)
 
@@ -389,38 +479,75 @@ void HomotopyClassPlanner::createProbRoadmapGraph(const PoseSE2& start, const Po
 
   Eigen::Vector2d area_origin = start.position() - 0.5*area_width*normal; // bottom left corner of the origin
 
-  // Insert Vertices
-  HcGraphVertexType start_vtx = boost::add_vertex(graph_); // start vertex
-  graph_[start_vtx].pos = start.position();
-  diff.normalize(); // normalize in place
-
+  // Obstacles that appeared, disappeared or moved since the last roadmap invalidate the collision checks in their vicinity
+  std::vector<ObstacleBox> obstacle_boxes;
+  bool obstacles_bounded = computeObstacleBoxes(obstacle_boxes);
+  bool reuse_edges = obstacles_bounded && roadmap_cache_.obstacles_bounded && roadmap_cache_.dist_to_obst == dist_to_obst;
+  std::vector<ObstacleBox> changed_boxes;
+  if (reuse_edges)
+    std::set_symmetric_difference(obstacle_boxes.begin(), obstacle_boxes.end(), roadmap_cache_.obstacle_boxes.begin(), roadmap_cache_.obstacle_boxes.end(),
+                                  std::back_inserter(changed_boxes));
+
+  // Keep previous samples that are still inside the area and collision free (they are stored in the planning frame)
+  Eigen::Rotation2D<double> rot_phi_inv = rot_phi.inverse();
+  Point2dContainer samples;
+  std::vector<unsigned int> sample_ids;
+  for (std::size_t i=0; i < roadmap_cache_.samples.size() && (int)samples.size() < no_samples; ++i)
+  {
+    Eigen::Vector2d area_pos = rot_phi_inv*(roadmap_cache_.samples[i]-area_origin);
+    if (area_pos.x()<0 || area_pos.x()>start_goal_dist || area_pos.y()<0 || area_pos.y()>area_width)
+      continue;
+    if (obstacle_grid_.checkCollision(roadmap_cache_.samples[i], dist_to_obst))
+      continue;
+    samples.push_back(roadmap_cache_.samples[i]);
+    sample_ids.push_back(roadmap_cache_.ids[i]);
+  }
+  bool kept_samples = !samples.empty();
+  Eigen::Rotation2D<double> rot_prev_inv(-roadmap_cache_.area_phi);
 
-  // Start sampling
-  for (int i=0; i < no_samples; ++i)
+  // Top up the samples: the kept ones already cover the previous area, hence new ones are preferably drawn in the uncovered part
+  const int max_uncovered_attempts = 10; // fall back to the whole area if the uncovered part is (almost) empty
+  while ((int)samples.size() < no_samples)
   {
     Eigen::Vector2d sample;
     bool coll_free;
+    int attempts = 0;
     do // sample as long as a collision free sample is found
     {
       // Sample coordinates
       sample = area_origin + rot_phi*Eigen::Vector2d(distribution_x(rnd_generator_), distribution_y(rnd_generator_));
 
-      // Test for collision
-      coll_free = true;
-      for (ObstContainer::const_iterator it_obst = obstacles_->begin(); it_obst != obstacles_->end(); ++it_obst)
+      if (kept_samples && ++attempts <= max_uncovered_attempts)
       {
-        if ( (*it_obst)->checkCollision(sample, dist_to_obst)) // TODO really keep dist_to_obst here?
+        Eigen::Vector2d prev_area_pos = rot_prev_inv*(sample-roadmap_cache_.area_origin);
+        if (prev_area_pos.x()>=0 && prev_area_pos.x()<=roadmap_cache_.area_length && prev_area_pos.y()>=0 && prev_area_pos.y()<=roadmap_cache_.area_width)
         {
           coll_free = false;
-          break;
+          continue;
         }
       }
 
+      // Test for collision
+      coll_free = !obstacle_grid_.checkCollision(sample, dist_to_obst); // TODO really keep dist_to_obst here?
+
     } while (!coll_free && ros::ok());
 
-    // Add new vertex
-    HcGraphVertexType v = boost::add_vertex(graph_);
-    graph_[v].pos = sample;
+    if (!coll_free)
+      return; // ros shutdown
+
+    samples.push_back(sample);
+    sample_ids.push_back(roadmap_cache_.next_id++);
+  }
+
+  // Insert Vertices
+  HcGraphVertexType start_vtx = boost::add_vertex(graph_); // start vertex
+  graph_[start_vtx].pos = start.position();
+  diff.normalize(); // normalize in place
+
+  for (std::size_t i=0; i < samples.size(); ++i)
+  {
+    HcGraphVertexType v = boost::add_vertex(graph_); // sample i is vertex i+1
+    graph_[v].pos = samples[i];
   }
 
   // Now add goal vertex
@@ -429,6 +556,8 @@ void HomotopyClassPlanner::createProbRoadmapGraph(const PoseSE2& start, const Po
 
 
   // Insert Edges
+  std::vector< std::pair<HcGraphVertexType,HcGraphVertexType> > candidate_edges;
+  std::vector<char> collision;
   HcGraphVertexIterator it_i, end_i, it_j, end_j;
   for (boost::tie(it_i,end_i) = boost::vertices(graph_); it_i!=boost::prior(end_i); ++it_i) // ignore goal in this loop
   {
@@ -445,24 +574,49 @@ void HomotopyClassPlanner::createProbRoadmapGraph(const PoseSE2& start, const Po
           continue; // diff is already normalized
 
 
-      // Collision Check
-      bool collision = false;
-      for (ObstContainer::const_iterator it_obst = obstacles_->begin(); it_obst != obstacles_->end(); ++it_obst)
-      {
-        if ( (*it_obst)->checkLineIntersection(graph_[*it_i].pos,graph_[*it_j].pos, dist_to_obst) )
-        {
-          collision = true;
-          break;
-        }
-      }
-      if (collision)
-        continue;
+      // Collision check and edge creation are performed below
+      candidate_edges.push_back(std::make_pair(*it_i, *it_j));
+      collision.push_back(-1);
 
-      // Create Edge
-      boost::add_edge(*it_i,*it_j,graph_);
+      // Reuse the previous check of edges between samples if no obstacle changed close to the edge
+      if (!reuse_edges || *it_i==start_vtx || *it_j==start_vtx || *it_j==goal_vtx)
+        continue;
+      std::pair<unsigned int, unsigned int> key(std::min(sample_ids[*it_i-1], sample_ids[*it_j-1]), std::max(sample_ids[*it_i-1], sample_ids[*it_j-1]));
+      boost::unordered_map< std::pair<unsigned int, unsigned int>, bool >::const_iterator cached = roadmap_cache_.edge_collision.find(key);
+      if (cached == roadmap_cache_.edge_collision.end())
+        continue;
+      Eigen::Vector2d edge_min = graph_[*it_i].pos.cwiseMin(graph_[*it_j].pos).array() - dist_to_obst;
+      Eigen::Vector2d edge_max = graph_[*it_i].pos.cwiseMax(graph_[*it_j].pos).array() + dist_to_obst;
+      bool changed = false;
+      for (std::vector<ObstacleBox>::const_iterator box = changed_boxes.begin(); box != changed_boxes.end() && !changed; ++box)
+        changed = (*box)[0] <= edge_max.x() && (*box)[2] >= edge_min.x() && (*box)[1] <= edge_max.y() && (*box)[3] >= edge_min.y();
+      if (!changed)
+        collision.back() = cached->second;
     }
   }
 
+  addCollisionFreeEdges(candidate_edges, dist_to_obst, &collision);
+
+  // Store samples and edge checks for the next cycle
+  roadmap_cache_.edge_collision.clear();
+  for (std::size_t i=0; i < candidate_edges.size(); ++i)
+  {
+    if (candidate_edges[i].first==start_vtx || candidate_edges[i].second==start_vtx || candidate_edges[i].second==goal_vtx)
+      continue; // the start and goal move with the robot
+    unsigned int id_i = sample_ids[candidate_edges[i].first-1];
+    unsigned int id_j = sample_ids[candidate_edges[i].second-1];
+    roadmap_cache_.edge_collision[std::make_pair(std::min(id_i, id_j), std::max(id_i, id_j))] = collision[i];
+  }
+  roadmap_cache_.samples.swap(samples);
+  roadmap_cache_.ids.swap(sample_ids);
+  roadmap_cache_.area_origin = area_origin;
+  roadmap_cache_.area_phi = phi;
+  roadmap_cache_.area_length = start_goal_dist;
+  roadmap_cache_.area_width = area_width;
+  roadmap_cache_.obstacle_boxes.swap(obstacle_boxes);
+  roadmap_cache_.dist_to_obst = dist_to_obst;
+  roadmap_cache_.obstacles_bounded = obstacles_bounded;
+
   /// Find all paths between start and goal!
   std::vector<HcGraphVertexType> visited;
   visited.push_back(start_vtx);
@@ -470,30 +624,261 @@ void HomotopyClassPlanner::createProbRoadmapGraph(const PoseSE2& start, const Po
 }
 
 
+void HomotopyClassPlanner::calculateHSignatureCoefficients(const std::complex<long double>& path_start, const std::complex<long double>& path_end,
+                                                           const ObstContainer* obstacles, double prescaler, HSignatureCoefficients& coeffs)
+{
+  ObstacleSnapshot snapshot;
+  snapshot.build(obstacles);
+  calculateHSignatureCoefficients(path_start, path_end, snapshot, prescaler, coeffs);
+}
+
+
+void HomotopyClassPlanner::calculateHSignatureCoefficients(const std::complex<long double>& path_start, const std::complex<long double>& path_end,
+                                                           const ObstacleSnapshot& obstacles, double prescaler, HSignatureCoefficients& coeffs)
+{
+  typedef std::complex<long double> cplx;
+
+  coeffs.obstacles.clear();
+  coeffs.coefficients.clear();
+  if (obstacles.empty())
+    return;
+
+  // guess values for f0
+  // paper proposes a+b=N-1 && |a-b|<=1, 1...N obstacles
+  int m = obstacles.size()-1;
+
+  if (m>5)
+    m = 5;  // hardcoded, but this was working in my test cases... TODO further tests requried
+
+  int a = (int) std::ceil(double(m)/2.0);
+  int b = m-a;
+
+  // guess map size (only a really really coarse guess is required
+  // use distance from start to goal as distance to each direction
+  double dist = std::sqrt( std::norm(path_end - path_start) );
+  if (dist < 3.0)
+    dist = 3.0; // set minimum bound on distance (we do not want to have numerical instabilities) and 3.0 performs fine...
+  cplx map_bottom_left(path_start.real(), path_start.imag()-dist);
+  cplx map_top_right(path_start.real()+dist, path_start.imag()+dist);
+
+  coeffs.obstacles.reserve(obstacles.size());
+  for (Point2dContainer::const_iterator centroid = obstacles.centroids().begin(); centroid != obstacles.centroids().end(); ++centroid)
+    coeffs.obstacles.push_back(cplx(centroid->x(), centroid->y()));
+
+  coeffs.coefficients.resize(coeffs.obstacles.size());
+  for (unsigned int l=0; l<coeffs.obstacles.size(); ++l) // iterate all obstacles
+  {
+    const cplx& obst_l = coeffs.obstacles[l];
+    cplx f0 = (long double) prescaler * std::pow(obst_l-map_bottom_left,a) * std::pow(obst_l-map_top_right,b);
+    // denum contains product with all obstacles exepct j==l
+    cplx Al = f0;
+    for (unsigned int j=0; j<coeffs.obstacles.size(); ++j)
+    {
+      if (j==l)
+        continue;
+      cplx diff = obst_l - coeffs.obstacles[j];
+      if (diff.real()!=0 || diff.imag()!=0)
+        Al /= diff;
+    }
+    coeffs.coefficients[l] = Al;
+  }
+}
+
+
+std::complex<long double> HomotopyClassPlanner::calculateHSignatureSegment(const std::complex<long double>& z1, const std::complex<long double>& z2,
+                                                                           const HSignatureCoefficients& coeffs)
+{
+  typedef std::complex<long double> cplx;
+
+  cplx H = 0;
+  double imag_proposals[5];
+  for (unsigned int l=0; l<coeffs.obstacles.size(); ++l) // iterate all obstacles
+  {
+    const cplx& obst_l = coeffs.obstacles[l];
+    // compute log value
+    double diff2 = std::abs(z2-obst_l);
+    double diff1 = std::abs(z1-obst_l);
+    if (diff2 == 0 || diff1 == 0)
+      continue;
+    double log_real = std::log(diff2)-std::log(diff1);
+    // complex ln has more than one solution -> choose minimum abs angle -> paper
+    double arg_diff = std::arg(z2-obst_l)-std::arg(z1-obst_l);
+    imag_proposals[0] = arg_diff;
+    imag_proposals[1] = arg_diff+2*M_PI;
+    imag_proposals[2] = arg_diff-2*M_PI;
+    imag_proposals[3] = arg_diff+4*M_PI;
+    imag_proposals[4] = arg_diff-4*M_PI;
+    double log_imag = *std::min_element(imag_proposals, imag_proposals+5, smaller_than_abs);
+    cplx log_value(log_real,log_imag);
+    //cplx log_value = std::log(z2-obst_l)-std::log(z1-obst_l); // the principal solution doesn't seem to work
+    H += coeffs.coefficients[l]*log_value;
+  }
+  return H;
+}
+
+
+void HomotopyClassPlanner::calculateHSignatures(const std::vector<double>& x, const std::vector<double>& y, const std::vector<std::size_t>& path_offsets,
+                                                const ObstacleSnapshot& obstacles, double prescaler, double tolerance, std::vector< std::complex<long double> >& H)
+{
+  typedef std::complex<long double> cplx;
+
+  std::size_t no_paths = path_offsets.empty() ? 0 : path_offsets.size()-1;
+  H.assign(no_paths, cplx(0,0));
+  if (obstacles.empty())
+    return;
+
+  HSignatureCoefficients coeffs;
+  std::vector<double> obst_x, obst_y, coeff_re, coeff_im, coeff_abs;
+  std::vector<double> crossings, min_dist_sqr; // per obstacle
+  for (std::size_t k=0; k<no_paths; ++k)
+  {
+    std::size_t first = path_offsets[k];
+    std::size_t last = path_offsets[k+1];
+    if (last-first < 2)
+      continue;
+
+    calculateHSignatureCoefficients(cplx(x[first],y[first]), cplx(x[last-1],y[last-1]), obstacles, prescaler, coeffs);
+
+    // convert coefficients to double precision (structure of arrays)
+    std::size_t no_obst = coeffs.obstacles.size();
+    obst_x.resize(no_obst);
+    obst_y.resize(no_obst);
+    coeff_re.resize(no_obst);
+    coeff_im.resize(no_obst);
+    coeff_abs.resize(no_obst);
+    bool representable = true;
+    for (std::size_t l=0; l<no_obst; ++l)
+    {
+      obst_x[l] = (double) coeffs.obstacles[l].real();
+      obst_y[l] = (double) coeffs.obstacles[l].imag();
+      coeff_re[l] = (double) coeffs.coefficients[l].real();
+      coeff_im[l] = (double) coeffs.coefficients[l].imag();
+      coeff_abs[l] = std::abs(coeff_re[l]) + std::abs(coeff_im[l]);
+      representable = representable && std::isfinite(coeff_abs[l]);
+    }
+
+    if (representable)
+    {
+      // The sum of the log values of all segments telescopes: its real part is log|z_last-o| - log|z_first-o|
+      // and its imaginary part is arg(z_last-o) - arg(z_first-o) corrected by 2*pi for each crossing of the branch cut
+      // of atan2 (the ray from the obstacle towards -x). Each segment contributes its argument difference in [-pi,pi]
+      // (the proposal with minimum absolute value, see calculateHSignatureSegment()), hence the correction is -2*pi
+      // for crossing the ray upwards and +2*pi for crossing it downwards.
+      // The loop over the obstacles only counts crossings with comparisons, so the compiler vectorizes it.
+      crossings.assign(no_obst, 0.0);
+      min_dist_sqr.assign(no_obst, std::numeric_limits<double>::infinity());
+      for (std::size_t i=first; i+1<last; ++i)
+      {
+        const double x1 = x[i], y1 = y[i], x2 = x[i+1], y2 = y[i+1];
+        for (std::size_t l=0; l<no_obst; ++l)
+        {
+          // adding 0.0 turns -0.0 into +0.0, points on the ray belong to the upper half as for atan2
+          double dx1 = x1-obst_x[l], dy1 = y1-obst_y[l] + 0.0;
+          double dx2 = x2-obst_x[l], dy2 = y2-obst_y[l] + 0.0;
+          double cross = dx1*dy2 - dy1*dx2; // the segment crosses the ray iff cross < 0 (upwards) or cross > 0 (downwards)
+          double up = (dy1 < 0 && dy2 >= 0 && cross < 0) ? 1.0 : 0.0;
+          double down = (dy1 >= 0 && dy2 < 0 && cross > 0) ? 1.0 : 0.0;
+          crossings[l] += down - up;
+          min_dist_sqr[l] = std::min(min_dist_sqr[l], dx1*dx1 + dy1*dy1);
+        }
+      }
+
+      double h_re = 0, h_im = 0, magnitude = 0;
+      bool touches = false; // segments that touch an obstacle are ignored by calculateHSignatureSegment()
+      for (std::size_t l=0; l<no_obst; ++l)
+      {
+        double dx1 = x[first]-obst_x[l], dy1 = y[first]-obst_y[l] + 0.0;
+        double dx2 = x[last-1]-obst_x[l], dy2 = y[last-1]-obst_y[l] + 0.0;
+        double sqr2 = dx2*dx2 + dy2*dy2;
+        touches = touches || min_dist_sqr[l] == 0 || sqr2 == 0;
+        double log_re = 0.5 * std::log(sqr2 / (dx1*dx1 + dy1*dy1));
+        double log_im = std::atan2(dy2, dx2) - std::atan2(dy1, dx1) + 2*M_PI*crossings[l];
+        h_re += coeff_re[l]*log_re - coeff_im[l]*log_im;
+        h_im += coeff_re[l]*log_im + coeff_im[l]*log_re;
+        magnitude += coeff_abs[l] * (std::abs(log_re) + std::abs(log_im));
+      }
+
+      // condition estimate: rounding errors are proportional to the magnitude of the summands (obstacles)
+      double error_bound = magnitude * double(no_obst+4) * std::numeric_limits<double>::epsilon();
+      if (!touches && error_bound <= tolerance)
+      {
+        H[k] = cplx(h_re, h_im);
+        continue;
+      }
+    }
+
+    // ill-conditioned or touching an obstacle: fall back to long double precision
+    for (std::size_t i=first; i+1<last; ++i)
+      H[k] += calculateHSignatureSegment(cplx(x[i],y[i]), cplx(x[i+1],y[i+1]), coeffs);
+  }
+}
+
+
 void HomotopyClassPlanner::DepthFirst(HcGraph& g, std::vector<HcGraphVertexType>& visited, const HcGraphVertexType& goal,
                                       double start_orientation, double goal_orientation, boost::optional<const Eigen::Vector2d&> start_velocity)
 {
   // see http://www.technical-recipes.com/2011/a-recursive-algorithm-to-find-all-paths-between-two-given-nodes/ for details on finding all simple paths
+  if (visited.empty())
+    return;
+
+  // all paths share start and goal, hence the H-signature coefficients are computed only once
+  HSignatureCoefficients h_coeffs;
+  calculateHSignatureCoefficients(getCplxFromHcGraph(visited.front(), g), getCplxFromHcGraph(goal, g), obstacle_snapshot_, cfg_->hcp.h_signature_prescaler, h_coeffs);
+
+  std::vector<bool> visited_flags(boost::num_vertices(g), false);
+  std::complex<long double> h_prefix = 0;
+  for (std::size_t i=0; i<visited.size(); ++i)
+  {
+    visited_flags[visited[i]] = true;
+    if (i>0)
+      h_prefix += calculateHSignatureSegment(getCplxFromHcGraph(visited[i-1], g), getCplxFromHcGraph(visited[i], g), h_coeffs);
+  }
 
+  // the expansion limit (replays) replaces the machine dependent time budget
+  ros::WallTime deadline;
+  if (!search_expansions_limited_ && cfg_->hcp.roadmap_graph_search_time > 0)
+    deadline = ros::WallTime::now() + ros::WallDuration(cfg_->hcp.roadmap_graph_search_time);
+
+  search_expansions_ = 0;
+  search_cut_off_ = false;
+  DepthFirstStep(g, visited, visited_flags, h_prefix, h_coeffs, goal, deadline, start_orientation, goal_orientation, start_velocity);
+  if (search_cut_off_)
+    ROS_DEBUG("HomotopyClassPlanner::DepthFirst(): search cut off after %lu expansions, %u classes found.", search_expansions_,
+              (unsigned int) tebs_.size());
+}
+
+
+bool HomotopyClassPlanner::DepthFirstStep(HcGraph& g, std::vector<HcGraphVertexType>& visited, std::vector<bool>& visited_flags, const std::complex<long double>& h_prefix,
+                                          const HSignatureCoefficients& h_coeffs, const HcGraphVertexType& goal, const ros::WallTime& deadline,
+                                          double start_orientation, double goal_orientation, boost::optional<const Eigen::Vector2d&> start_velocity)
+{
   if ((int)tebs_.size() >= cfg_->hcp.max_number_classes)
-    return; // We do not need to search for further possible alternative homotopy classes.
+    return false; // We do not need to search for further possible alternative homotopy classes.
+
+  if (search_expansions_limited_ ? search_expansions_ >= search_expansion_limit_
+                                 : !deadline.isZero() && ros::WallTime::now() > deadline)
+  {
+    search_cut_off_ = true;
+    return false; // time budget exhausted or expansion limit reached
+  }
+  ++search_expansions_;
 
   HcGraphVertexType back = visited.back();
+  std::complex<long double> z_back = getCplxFromHcGraph(back, g);
 
   /// Examine adjacent nodes
   HcGraphAdjecencyIterator it, end;
   for ( boost::tie(it,end) = boost::adjacent_vertices(back,g); it!=end; ++it)
   {
-    if ( std::find(visited.begin(), visited.end(), *it)!=visited.end() )
+    if ( visited_flags[*it] )
       continue; // already visited
 
     if ( *it == goal ) // goal reached
     {
       visited.push_back(*it);
 
-
-      // check H-Signature
-      std::complex<long double> H = calculateHSignature(visited.begin(), visited.end(), boost::bind(getCplxFromHcGraph, _1, boost::cref(graph_)), obstacles_, cfg_->hcp.h_signature_prescaler);
+      // complete the H-Signature of the prefix
+      std::complex<long double> H = h_prefix + calculateHSignatureSegment(z_back, getCplxFromHcGraph(goal, g), h_coeffs);
 
       // check if H-Signature is already known
       // and init new TEB if no duplicate was found
@@ -505,31 +890,68 @@ void HomotopyClassPlanner::DepthFirst(HcGraph& g, std::vector<HcGraphVertexType>
       visited.pop_back();
       break;
     }
-}
+  }
 
-/// Recursion for all adjacent vertices
-for ( boost::tie(it,end) = boost::adjacent_vertices(back,g); it!=end; ++it)
-{
-  if ( std::find(visited.begin(), visited.end(), *it)!=visited.end() || *it == goal)
-    continue; // already visited || goal reached
+  /// Recursion for all adjacent vertices, shorter detours (via the neighbour towards the goal) first
+  std::vector< std::pair<double, HcGraphVertexType> > successors;
+  for ( boost::tie(it,end) = boost::adjacent_vertices(back,g); it!=end; ++it)
+  {
+    if ( visited_flags[*it] || *it == goal)
+      continue; // already visited || goal reached
+    double est_length = (g[*it].pos - g[back].pos).norm() + (g[goal].pos - g[*it].pos).norm();
+    successors.push_back(std::make_pair(est_length, *it));
+  }
+  std::sort(successors.begin(), successors.end());
 
+  for (std::size_t i=0; i<successors.size(); ++i)
+  {
+    HcGraphVertexType next = successors[i].second;
+    visited.push_back(next);
+    visited_flags[next] = true;
 
-  visited.push_back(*it);
+    // recursion step
+    bool proceed = DepthFirstStep(g, visited, visited_flags, h_prefix + calculateHSignatureSegment(z_back, getCplxFromHcGraph(next, g), h_coeffs),
+                                  h_coeffs, goal, deadline, start_orientation, goal_orientation, start_velocity);
 
-  // recursion step
-  DepthFirst(g, visited, goal, start_orientation, goal_orientation, start_velocity);
+    visited_flags[next] = false;
+    visited.pop_back();
 
-  visited.pop_back();
-}
+    if (!proceed)
+      return false;
+  }
+  return true;
 }
 
 
 bool HomotopyClassPlanner::hasHSignature(const std::complex<long double>& H) const
 {
+  double threshold = cfg_->hcp.h_signature_threshold;
+
+  if (threshold > 0 && threshold == h_signature_bucket_size_)
+  {
+    // similar h-signatures are located in the same or in a neighbouring bucket
+    HSignatureBucket bucket = hSignatureBucket(H);
+    for (long long dx = -1; dx <= 1; ++dx)
+    {
+      for (long long dy = -1; dy <= 1; ++dy)
+      {
+        HSignatureBucketMap::const_iterator it = h_signature_buckets_.find(HSignatureBucket(bucket.first+dx, bucket.second+dy));
+        if (it == h_signature_buckets_.end())
+          continue;
+        for (std::vector<std::size_t>::const_iterator idx = it->second.begin(); idx != it->second.end(); ++idx)
+        {
+          if (isHSignatureSimilar(h_signatures_[*idx].first, H, threshold))
+            return true; // Found! Homotopy class already exists, therefore nothing added
+        }
+      }
+    }
+    return false;
+  }
+
   // iterate existing h-signatures and check if there is an existing H-Signature similar the candidate
   for (std::vector< std::pair<std::complex<long double>, bool> >::const_iterator it = h_signatures_.begin(); it != h_signatures_.end(); ++it)
   {
-    if (isHSignatureSimilar(it->first, H, cfg_->hcp.h_signature_threshold))
+    if (isHSignatureSimilar(it->first, H, threshold))
       return true; // Found! Homotopy class already exists, therefore nothing added
   }
   return false;
@@ -543,14 +965,51 @@ bool HomotopyClassPlanner::addHSignatureIfNew(const std::complex<long double>& H
     return false;
   }
 
+  updateHSignatureBuckets();
+
   if (hasHSignature(H))
     return false;
 
   // Homotopy class not found -> Add to class-list, return that the h-signature is new
   h_signatures_.push_back(std::make_pair(H,lock));
+  if (h_signature_bucket_size_ > 0)
+    h_signature_buckets_[hSignatureBucket(H)].push_back(h_signatures_.size()-1);
   return true;
 }
 
+void HomotopyClassPlanner::clearHSignatures()
+{
+  h_signatures_.clear();
+  h_signature_buckets_.clear();
+}
+
+void HomotopyClassPlanner::updateHSignatureBuckets()
+{
+  double threshold = cfg_->hcp.h_signature_threshold;
+  if (threshold == h_signature_bucket_size_)
+    return;
+
+  // the bucket size follows the threshold (e.g. changed by dynamic_reconfigure)
+  h_signature_buckets_.clear();
+  h_signature_bucket_size_ = threshold > 0 ? threshold : 0;
+  if (h_signature_bucket_size_ == 0)
+    return; // linear search only
+
+  for (std::size_t i = 0; i < h_signatures_.size(); ++i)
+    h_signature_buckets_[hSignatureBucket(h_signatures_[i].first)].push_back(i);
+}
+
+HomotopyClassPlanner::HSignatureBucket HomotopyClassPlanner::hSignatureBucket(const std::complex<long double>& H) const
+{
+  // clamp huge values (they share the outermost buckets, the exact check is performed afterwards anyway)
+  const long double limit = 1e15;
+  long double real = std::floor(H.real() / h_signature_bucket_size_);
+  long double imag = std::floor(H.imag() / h_signature_bucket_size_);
+  real = std::max(-limit, std::min(limit, real));
+  imag = std::max(-limit, std::min(limit, imag));
+  return HSignatureBucket((long long) real, (long long) imag);
+}
+
 
 
 
@@ -561,31 +1020,49 @@ inline bool compareH( std::pair<TebOptPlannerContainer::iterator, std::complex<l
 void HomotopyClassPlanner::renewAndAnalyzeOldTebs(bool delete_detours)
 {
   // clear old h-signatures (since they could be changed due to new obstacle positions.
-  h_signatures_.clear();
+  clearHSignatures();
 
   // Collect h-signatures for all existing TEBs and store them together with the corresponding iterator / pointer:
 //   typedef std::list< std::pair<TebOptPlannerContainer::iterator, std::complex<long double> > > TebCandidateType;
 //   TebCandidateType teb_candidates;
 
-  // get new homotopy classes and delete multiple TEBs per homotopy class
+  // delete Detours if there is at least one other TEB candidate left in the container
   TebOptPlannerContainer::iterator it_teb = tebs_.begin();
   while(it_teb != tebs_.end())
   {
-    // delete Detours if there is at least one other TEB candidate left in the container
     if (delete_detours && tebs_.size()>1 && it_teb->get()->teb().detectDetoursBackwards(-0.1))
     {
       it_teb = tebs_.erase(it_teb); // delete candidate and set iterator to the next valid candidate
       continue;
     }
+    ++it_teb;
+  }
 
-    // calculate H Signature for the current candidate
-    std::complex<long double> H = calculateHSignature(it_teb->get()->teb().poses().begin(), it_teb->get()->teb().poses().end(), getCplxFromVertexPosePtr ,obstacles_, cfg_->hcp.h_signature_prescaler);
+  // calculate H Signatures for all remaining candidates at once
+  std::vector<double> path_x, path_y;
+  std::vector<std::size_t> path_offsets(1, 0);
+  for (it_teb = tebs_.begin(); it_teb != tebs_.end(); ++it_teb)
+  {
+    const PoseSequence& poses = it_teb->get()->teb().poses();
+    for (PoseSequence::const_iterator pose = poses.begin(); pose != poses.end(); ++pose)
+    {
+      path_x.push_back((*pose)->x());
+      path_y.push_back((*pose)->y());
+    }
+    path_offsets.push_back(path_x.size());
+  }
+  std::vector< std::complex<long double> > h_signatures;
+  calculateHSignatures(path_x, path_y, path_offsets, obstacle_snapshot_, cfg_->hcp.h_signature_prescaler, 1e-3*cfg_->hcp.h_signature_threshold, h_signatures);
 
-//     teb_candidates.push_back(std::make_pair(it_teb,H));
+  // get new homotopy classes and delete multiple TEBs per homotopy class
+  it_teb = tebs_.begin();
+  for (std::size_t k=0; k<h_signatures.size(); ++k)
+  {
+//     teb_candidates.push_back(std::make_pair(it_teb,h_signatures[k]));
 
     // WORKAROUND until the commented code below works
     // Here we do not compare cost values. Just first come first serve...
-    bool new_flag = addHSignatureIfNew(H);
+    bool new_flag = addHSignatureIfNew(h_signatures[k]);
     if (!new_flag)
     {
       it_teb = tebs_.erase(it_teb);
@@ -691,9 +1168,18 @@ void HomotopyClassPlanner::exploreHomotopyClassesAndInitTebs(const PoseSE2& star
 }
 
 
+TebOptimalPlannerPtr HomotopyClassPlanner::createCandidatePlanner()
+{
+  TebOptimalPlannerPtr planner( new TebOptimalPlanner() );
+  planner->setOptimizer( optimizer_pool_.acquire() ); // avoid allocating a new solver for each candidate
+  planner->initialize(*cfg_, obstacles_, robot_model_);
+  planner->setObstacleSnapshot(&obstacle_snapshot_);
+  return planner;
+}
+
 void HomotopyClassPlanner::addAndInitNewTeb(const PoseSE2& start, const PoseSE2& goal, boost::optional<const Eigen::Vector2d&> start_velocity)
 {
-  tebs_.push_back( TebOptimalPlannerPtr( new TebOptimalPlanner(*cfg_, obstacles_, robot_model_) ) );
+  tebs_.push_back( createCandidatePlanner() );
   tebs_.back()->teb().initTEBtoGoal(start, goal, 0, cfg_->trajectory.dt_ref, cfg_->trajectory.min_samples);
 
   if (start_velocity)
@@ -702,7 +1188,7 @@ void HomotopyClassPlanner::addAndInitNewTeb(const PoseSE2& start, const PoseSE2&
 
 void HomotopyClassPlanner::addAndInitNewTeb(const std::vector<geometry_msgs::PoseStamped>& initial_plan, boost::optional<const Eigen::Vector2d&> start_velocity)
 {
-  tebs_.push_back( TebOptimalPlannerPtr( new TebOptimalPlanner(*cfg_, obstacles_, robot_model_) ) );
+  tebs_.push_back( createCandidatePlanner() );
   tebs_.back()->teb().initTEBtoGoal(*initial_plan_, cfg_->trajectory.dt_ref, true, cfg_->trajectory.min_samples);
 
   if (start_velocity)
@@ -717,7 +1203,7 @@ void HomotopyClassPlanner::updateAllTEBs(boost::optional<const PoseSE2&> start,
   {
       ROS_DEBUG("New goal: distance to existing goal is higher than the specified threshold. Reinitalizing trajectories.");
       tebs_.clear();
-      h_signatures_.clear();
+      clearHSignatures();
   }
 
   // hot-start from previous solutions
@@ -732,6 +1218,79 @@ void HomotopyClassPlanner::updateAllTEBs(boost::optional<const PoseSE2&> start,
 
 void HomotopyClassPlanner::optimizeAllTEBs(unsigned int iter_innerloop, unsigned int iter_outerloop)
 {
+  if (cfg_->hcp.selection_early_abort && tebs_.size() > 1 && iter_outerloop > 1)
+  {
+    std::size_t no_tebs = tebs_.size();
+    std::vector<std::size_t> candidates(no_tebs);
+    int incumbent = -1;
+    for (std::size_t k = 0; k < no_tebs; ++k)
+    {
+      candidates[k] = k;
+      if (tebs_[k] == best_teb_ && !infeasible_tebs_.count(best_teb_.get()))
+        incumbent = k;
+    }
+
+    // the candidates are compared once after half of the outer iterations
+    unsigned int checkpoint = iter_outerloop / 2;
+    std::vector<char> success(no_tebs, 1);
+    optimizeTebIterations(candidates, 0, checkpoint, iter_innerloop, iter_outerloop, success);
+
+    std::vector<std::size_t> active, stopped;
+    for (std::size_t k = 0; k < no_tebs; ++k)
+    {
+      if (success[k])
+        active.push_back(k);
+    }
+    int best = -1;
+    double min_cost = selectionCostToBeat(active, incumbent, best);
+    std::vector<double> lower_bound(no_tebs, 0);
+    for (std::size_t i = 0; i < active.size(); )
+    {
+      std::size_t k = active[i];
+      lower_bound[k] = selectionCostLowerBound(*tebs_[k]);
+      if ((int) k != best && lower_bound[k] > min_cost)
+      {
+        ROS_DEBUG("HomotopyClassPlanner::optimizeAllTEBs(): stop candidate %lu after %u iterations (cost bound %f > %f).",
+                  (unsigned long) k, checkpoint, lower_bound[k], min_cost);
+        stopped.push_back(k);
+        active.erase(active.begin() + i);
+      }
+      else
+        ++i;
+    }
+
+    // the iterations saved by stopped candidates are distributed among the remaining ones
+    unsigned int extra_iterations = 0;
+    if (!stopped.empty() && !active.empty())
+      extra_iterations = std::min<unsigned int>(stopped.size() * (iter_outerloop - checkpoint) / active.size(), iter_outerloop);
+    optimizeTebIterations(active, checkpoint, iter_outerloop + extra_iterations, iter_innerloop, iter_outerloop, success);
+
+    if (stopped.empty())
+      return;
+
+    // the cost of the incumbent might have increased (e.g. due to resizing): resume candidates that could win now
+    std::vector<std::size_t> finished;
+    for (std::size_t i = 0; i < active.size(); ++i)
+    {
+      if (success[active[i]])
+        finished.push_back(active[i]);
+    }
+    min_cost = selectionCostToBeat(finished, incumbent, best);
+    std::vector<std::size_t> resumed;
+    for (std::size_t i = 0; i < stopped.size(); ++i)
+    {
+      if (lower_bound[stopped[i]] <= min_cost)
+        resumed.push_back(stopped[i]);
+    }
+    if (!resumed.empty())
+    {
+      ROS_DEBUG("HomotopyClassPlanner::optimizeAllTEBs(): resume %lu stopped candidates (final cost to beat %f).",
+                (unsigned long) resumed.size(), min_cost);
+      optimizeTebIterations(resumed, checkpoint, iter_outerloop, iter_innerloop, iter_outerloop, success);
+    }
+    return;
+  }
+
   // optimize TEBs in parallel since they are independend of each other
   if (cfg_->hcp.enable_multithreading)
   {
@@ -754,6 +1313,64 @@ void HomotopyClassPlanner::optimizeAllTEBs(unsigned int iter_innerloop, unsigned
   }
 }
 
+void HomotopyClassPlanner::optimizeTebIterations(const std::vector<std::size_t>& candidates, unsigned int first, unsigned int last,
+                                                 unsigned int iter_innerloop, unsigned int iter_outerloop, std::vector<char>& success)
+{
+  if (first >= last)
+    return;
+  worker_pool_.run(candidates.size(), boost::bind(&HomotopyClassPlanner::optimizeTebIterationsTask, this, &candidates, _1, first, last,
+                                                  iter_innerloop, iter_outerloop, &success),
+                   cfg_->hcp.enable_multithreading ? candidates.size() : 1);
+}
+
+void HomotopyClassPlanner::optimizeTebIterationsTask(const std::vector<std::size_t>* candidates, std::size_t idx, unsigned int first, unsigned int last,
+                                                     unsigned int iter_innerloop, unsigned int iter_outerloop, std::vector<char>* success) const
+{
+  std::size_t k = (*candidates)[idx];
+  TebOptimalPlanner* teb = tebs_[k].get();
+  for (unsigned int i = first; i < last && (*success)[k]; ++i)
+  {
+    (*success)[k] = teb->optimizeTEBIteration(i, iter_innerloop, iter_outerloop, i == last-1, cfg_->hcp.selection_obst_cost_scale,
+                                              cfg_->hcp.selection_viapoint_cost_scale, cfg_->hcp.selection_alternative_time_cost);
+  }
+}
+
+double HomotopyClassPlanner::selectionCostLowerBound(const TebOptimalPlanner& teb) const
+{
+  double bound = teb.getCurrentCost();
+  if (cfg_->hcp.selection_alternative_time_cost)
+    bound -= teb.teb().getSumOfAllTimeDiffs();
+  else
+    bound -= teb.getCurrentCost(TELEMETRY_COST_TIME_OPTIMAL);
+  bound -= cfg_->hcp.selection_obst_cost_scale * (teb.getCurrentCost(TELEMETRY_COST_OBSTACLE) + teb.getCurrentCost(TELEMETRY_COST_DYNAMIC_OBSTACLE));
+  bound -= cfg_->hcp.selection_viapoint_cost_scale * teb.getCurrentCost(TELEMETRY_COST_VIA_POINT);
+  return std::max(bound, 0.0);
+}
+
+double HomotopyClassPlanner::selectionCostToBeat(const std::vector<std::size_t>& candidates, int incumbent, int& best) const
+{
+  best = -1;
+  double min_cost = std::numeric_limits<double>::max();
+  for (std::size_t i = 0; i < candidates.size(); ++i)
+  {
+    if ((int) candidates[i] == incumbent)
+    {
+      best = incumbent;
+      return tebs_[incumbent]->getCurrentCost() * cfg_->hcp.selection_cost_hysteresis;
+    }
+  }
+  for (std::size_t i = 0; i < candidates.size(); ++i)
+  {
+    double cost = tebs_[candidates[i]]->getCurrentCost();
+    if (cost < min_cost)
+    {
+      best = candidates[i];
+      min_cost = cost;
+    }
+  }
+  return min_cost;
+}
+
 void HomotopyClassPlanner::deleteTebDetours(double threshold)
 {
   TebOptPlannerContainer::iterator it_teb = tebs_.begin();
@@ -793,8 +1410,8 @@ TebOptimalPlannerPtr HomotopyClassPlanner::selectBestTeb()
 {
   double min_cost = std::numeric_limits<double>::max(); // maximum cost
 
-  // check if last best_teb is still a valid candidate
-  if (std::find(tebs_.begin(), tebs_.end(), best_teb_) != tebs_.end())
+  // check if last best_teb is still a valid candidate (and not known to be infeasible)
+  if (std::find(tebs_.begin(), tebs_.end(), best_teb_) != tebs_.end() && !infeasible_tebs_.count(best_teb_.get()))
   {
     // get cost of this candidate
     min_cost = best_teb_->getCurrentCost() * cfg_->hcp.selection_cost_hysteresis; // small hysteresis
@@ -807,6 +1424,9 @@ TebOptimalPlannerPtr HomotopyClassPlanner::selectBestTeb()
     if (*it_teb == best_teb_)
       continue; // skip already known cost value of the last best_teb
 
+    if (infeasible_tebs_.count(it_teb->get()))
+      continue; // candidate failed the last feasibility check
+
     double teb_cost = it_teb->get()->getCurrentCost();
 
     if (teb_cost < min_cost)
@@ -843,7 +1463,41 @@ bool HomotopyClassPlanner::isTrajectoryFeasible(base_local_planner::CostmapModel
   if (!best)
     return false;
 
-  return best->isTrajectoryFeasible(costmap_model,footprint_spec, inscribed_radius, circumscribed_radius, look_ahead_idx);
+  if (tebs_.size() == 1)
+    return best->isTrajectoryFeasible(costmap_model,footprint_spec, inscribed_radius, circumscribed_radius, look_ahead_idx);
+
+  // check all candidates, such that we can fall back to another one if the best candidate is blocked
+  std::vector<char> feasible(tebs_.size(), 0);
+  worker_pool_.run(tebs_.size(), boost::bind(&HomotopyClassPlanner::checkTebFeasibilityTask, this, _1, costmap_model, &footprint_spec,
+                                             inscribed_radius, circumscribed_radius, look_ahead_idx, &feasible),
+                   cfg_->hcp.enable_multithreading ? tebs_.size() : 1);
+
+  infeasible_tebs_.clear();
+  for (std::size_t i = 0; i < tebs_.size(); ++i)
+  {
+    if (!feasible[i])
+      infeasible_tebs_.insert(tebs_[i].get());
+  }
+
+  if (!infeasible_tebs_.count(best.get()))
+    return true;
+
+  // select the cheapest feasible candidate instead
+  selectBestTeb();
+  if (best_teb_)
+  {
+    ROS_DEBUG("HomotopyClassPlanner::isTrajectoryFeasible(): best trajectory is not feasible, switching to an alternative candidate.");
+    return true;
+  }
+
+  best_teb_ = best; // nothing feasible, keep the previous selection
+  return false;
+}
+
+void HomotopyClassPlanner::checkTebFeasibilityTask(std::size_t idx, base_local_planner::CostmapModel* costmap_model, const std::vector<geometry_msgs::Point>* footprint_spec,
+                                                   double inscribed_radius, double circumscribed_radius, int look_ahead_idx, std::vector<char>* feasible) const
+{
+  (*feasible)[idx] = tebs_[idx]->isTrajectoryFeasible(costmap_model, *footprint_spec, inscribed_radius, circumscribed_radius, look_ahead_idx);
 }
 
 bool HomotopyClassPlanner::isHorizonReductionAppropriate(const std::vector<geometry_msgs::PoseStamped>& initial_plan) const
@@ -0,0 +1,172 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************/
+
+#include <teb_local_planner/obstacle_grid.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace teb_local_planner
+{
+
+//! Maximum number of cells along each axis
+static const int MAX_GRID_CELLS_PER_AXIS = 256;
+
+ObstacleGrid::ObstacleGrid() : obstacles_(NULL), origin_(Eigen::Vector2d::Zero()), cell_size_(1), cells_x_(0), cells_y_(0)
+{
+}
+
+void ObstacleGrid::build(const ObstacleSnapshot* obstacles, double cell_size)
+{
+  obstacles_ = obstacles;
+  cells_.clear();
+  unbounded_.clear();
+  cells_x_ = cells_y_ = 0;
+  
+  if (obstacles_ == NULL || obstacles_->empty())
+    return;
+  
+  // extent of the bounding boxes of all obstacles
+  Eigen::Vector2d grid_min(HUGE_VAL, HUGE_VAL);
+  Eigen::Vector2d grid_max(-HUGE_VAL, -HUGE_VAL);
+  for (unsigned int i=0; i<obstacles_->size(); ++i)
+  {
+    if (!obstacles_->hasBoundingBox(i))
+    {
+      unbounded_.push_back(i);
+      continue;
+    }
+    grid_min = grid_min.cwiseMin(obstacles_->boxMin(i));
+    grid_max = grid_max.cwiseMax(obstacles_->boxMax(i));
+  }
+  
+  if (unbounded_.size() == obstacles_->size())
+    return;
+  
+  // limit the number of cells
+  Eigen::Vector2d extent = grid_max - grid_min;
+  cell_size_ = std::max(cell_size, extent.maxCoeff() / double(MAX_GRID_CELLS_PER_AXIS));
+  if (cell_size_ <= 0)
+    cell_size_ = 1;
+  origin_ = grid_min;
+  cells_x_ = std::min(MAX_GRID_CELLS_PER_AXIS, (int)std::floor(extent.x() / cell_size_) + 1);
+  cells_y_ = std::min(MAX_GRID_CELLS_PER_AXIS, (int)std::floor(extent.y() / cell_size_) + 1);
+  cells_.resize(cells_x_ * cells_y_);
+  
+  for (unsigned int i=0; i<obstacles_->size(); ++i)
+  {
+    if (!obstacles_->hasBoundingBox(i))
+      continue;
+    int x_begin = cellIndex(obstacles_->boxMin(i).x(), 0), x_end = cellIndex(obstacles_->boxMax(i).x(), 0);
+    int y_begin = cellIndex(obstacles_->boxMin(i).y(), 1), y_end = cellIndex(obstacles_->boxMax(i).y(), 1);
+    for (int y=y_begin; y<=y_end; ++y)
+      for (int x=x_begin; x<=x_end; ++x)
+        cells_[y*cells_x_ + x].push_back(i);
+  }
+}
+
+bool ObstacleGrid::checkCollision(const Eigen::Vector2d& point, double min_dist) const
+{
+  if (obstacles_ == NULL)
+    return false;
+  
+  std::vector<unsigned int> candidates;
+  Eigen::Vector2d margin(min_dist, min_dist);
+  queryBox(point - margin, point + margin, candidates);
+  candidates.insert(candidates.end(), unbounded_.begin(), unbounded_.end());
+  
+  for (std::vector<unsigned int>::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
+  {
+    if (obstacles_->obstacle(*it)->checkCollision(point, min_dist))
+      return true;
+  }
+  return false;
+}
+
+bool ObstacleGrid::checkLineIntersection(const Eigen::Vector2d& line_start, const Eigen::Vector2d& line_end, double min_dist) const
+{
+  if (obstacles_ == NULL)
+    return false;
+  
+  std::vector<unsigned int> candidates;
+  Eigen::Vector2d margin(min_dist, min_dist);
+  queryBox(line_start.cwiseMin(line_end) - margin, line_start.cwiseMax(line_end) + margin, candidates);
+  candidates.insert(candidates.end(), unbounded_.begin(), unbounded_.end());
+  
+  for (std::vector<unsigned int>::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
+  {
+    if (obstacles_->obstacle(*it)->checkLineIntersection(line_start, line_end, min_dist))
+      return true;
+  }
+  return false;
+}
+
+void ObstacleGrid::queryBox(const Eigen::Vector2d& box_min, const Eigen::Vector2d& box_max, std::vector<unsigned int>& candidates) const
+{
+  candidates.clear();
+  if (cells_.empty())
+    return;
+  
+  // query box completely outside of the grid
+  Eigen::Vector2d grid_max = origin_ + cell_size_ * Eigen::Vector2d(cells_x_, cells_y_);
+  if (box_max.x() < origin_.x() || box_max.y() < origin_.y() || box_min.x() > grid_max.x() || box_min.y() > grid_max.y())
+    return;
+  
+  int x_begin = cellIndex(box_min.x(), 0), x_end = cellIndex(box_max.x(), 0);
+  int y_begin = cellIndex(box_min.y(), 1), y_end = cellIndex(box_max.y(), 1);
+  for (int y=y_begin; y<=y_end; ++y)
+  {
+    for (int x=x_begin; x<=x_end; ++x)
+    {
+      const std::vector<unsigned int>& cell = cells_[y*cells_x_ + x];
+      candidates.insert(candidates.end(), cell.begin(), cell.end());
+    }
+  }
+  
+  // obstacles spanning multiple cells are registered multiple times
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+}
+
+int ObstacleGrid::cellIndex(double coord, int axis) const
+{
+  int cells = axis == 0 ? cells_x_ : cells_y_;
+  int idx = (int)std::floor((coord - origin_[axis]) / cell_size_);
+  return std::max(0, std::min(cells-1, idx));
+}
+
+} // namespace teb_local_planner
@@ -0,0 +1,164 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************/
+
+#include <teb_local_planner/obstacle_snapshot.h>
+
+namespace teb_local_planner
+{
+
+ObstacleSnapshot::ObstacleSnapshot()
+{
+  polygon_offsets_.push_back(0);
+}
+
+void ObstacleSnapshot::clear()
+{
+  obstacles_.clear();
+  centroids_.clear();
+  box_min_.clear();
+  box_max_.clear();
+  bounded_.clear();
+  type_.clear();
+  type_idx_.clear();
+  static_idx_.clear();
+  dynamic_idx_.clear();
+  point_idx_.clear();
+  point_pos_.clear();
+  line_idx_.clear();
+  line_start_.clear();
+  line_end_.clear();
+  polygon_idx_.clear();
+  polygon_offsets_.assign(1, 0);
+  polygon_vertices_.clear();
+  unknown_idx_.clear();
+}
+
+void ObstacleSnapshot::build(const ObstContainer* obstacles)
+{
+  clear();
+  if (obstacles == NULL)
+    return;
+  
+  std::size_t no_obstacles = obstacles->size();
+  obstacles_.reserve(no_obstacles);
+  centroids_.reserve(no_obstacles);
+  box_min_.resize(no_obstacles);
+  box_max_.resize(no_obstacles);
+  bounded_.resize(no_obstacles);
+  type_.resize(no_obstacles);
+  type_idx_.resize(no_obstacles);
+  
+  for (unsigned int i=0; i<no_obstacles; ++i)
+  {
+    const Obstacle* obst = obstacles->at(i).get();
+    obstacles_.push_back(obst);
+    centroids_.push_back(obst->getCentroid());
+    bounded_[i] = boundingBox(*obst, box_min_[i], box_max_[i]);
+    if (!bounded_[i])
+      box_min_[i] = box_max_[i] = centroids_.back();
+    
+    if (obst->isDynamic())
+      dynamic_idx_.push_back(i);
+    else
+      static_idx_.push_back(i);
+    
+    // partition by type
+    if (const PointObstacle* pobst = dynamic_cast<const PointObstacle*>(obst))
+    {
+      type_[i] = POINT_OBSTACLE;
+      type_idx_[i] = point_idx_.size();
+      point_idx_.push_back(i);
+      point_pos_.push_back(pobst->position());
+    }
+    else if (const LineObstacle* lobst = dynamic_cast<const LineObstacle*>(obst))
+    {
+      type_[i] = LINE_OBSTACLE;
+      type_idx_[i] = line_idx_.size();
+      line_idx_.push_back(i);
+      line_start_.push_back(lobst->start());
+      line_end_.push_back(lobst->end());
+    }
+    else if (const PolygonObstacle* polyobst = dynamic_cast<const PolygonObstacle*>(obst))
+    {
+      type_[i] = POLYGON_OBSTACLE;
+      type_idx_[i] = polygon_idx_.size();
+      polygon_idx_.push_back(i);
+      polygon_vertices_.insert(polygon_vertices_.end(), polyobst->vertices().begin(), polyobst->vertices().end());
+      polygon_offsets_.push_back(polygon_vertices_.size());
+    }
+    else
+    {
+      type_[i] = UNKNOWN_OBSTACLE;
+      type_idx_[i] = unknown_idx_.size();
+      unknown_idx_.push_back(i);
+    }
+  }
+}
+
+bool ObstacleSnapshot::boundingBox(const Obstacle& obstacle, Eigen::Vector2d& box_min, Eigen::Vector2d& box_max)
+{
+  const PointObstacle* pobst = dynamic_cast<const PointObstacle*>(&obstacle);
+  if (pobst)
+  {
+    box_min = box_max = pobst->position();
+    return true;
+  }
+  
+  const LineObstacle* lobst = dynamic_cast<const LineObstacle*>(&obstacle);
+  if (lobst)
+  {
+    box_min = lobst->start().cwiseMin(lobst->end());
+    box_max = lobst->start().cwiseMax(lobst->end());
+    return true;
+  }
+  
+  const PolygonObstacle* polyobst = dynamic_cast<const PolygonObstacle*>(&obstacle);
+  if (polyobst && !polyobst->vertices().empty())
+  {
+    box_min = box_max = polyobst->vertices().front();
+    for (Point2dContainer::const_iterator it = polyobst->vertices().begin(); it != polyobst->vertices().end(); ++it)
+    {
+      box_min = box_min.cwiseMin(*it);
+      box_max = box_max.cwiseMax(*it);
+    }
+    return true;
+  }
+  
+  return false;
+}
+
+} // namespace teb_local_planner
@@ -44,21 +44,40 @@
 
 #include <teb_local_planner/optimal_planner.h>
 
+#include <algorithm>
+
 namespace teb_local_planner {
 
+namespace {
+
+//! Start velocity (v, omega) of a human in its body frame, the twist of the
+//! human is given in the planning frame
+Eigen::Vector2d humanBodyVelocity(const geometry_msgs::Twist &twist,
+                                  double theta) {
+  return Eigen::Vector2d(twist.linear.x * std::cos(theta) +
+                             twist.linear.y * std::sin(theta),
+                         twist.angular.z);
+}
+
+} // namespace
+
 // ============== Implementation ===================
 
 TebOptimalPlanner::TebOptimalPlanner()
-    : cfg_(NULL), obstacles_(NULL), via_points_(NULL), cost_(HUGE_VAL),
+    : cfg_(NULL), obstacles_(NULL), shared_obstacle_snapshot_(NULL),
+      via_points_(NULL), cost_(HUGE_VAL),
       robot_model_(new PointRobotFootprint()),
-      human_model_(new CircularRobotFootprint()), initialized_(false),
-      optimized_(false) {}
+      human_model_(new CircularRobotFootprint()), no_iterations_(0),
+      trajectory_export_valid_(false), initialized_(false), optimized_(false) {
+  std::fill(cost_families_, cost_families_ + TELEMETRY_COSTS, 0.0);
+}
 
 TebOptimalPlanner::TebOptimalPlanner(
     const TebConfig &cfg, ObstContainer *obstacles,
     RobotFootprintModelPtr robot_model, TebVisualizationPtr visual,
     const ViaPointContainer *via_points, CircularRobotFootprintPtr human_model,
-    const std::map<uint64_t, ViaPointContainer> *humans_via_points_map) {
+    const std::map<uint64_t, ViaPointContainer> *humans_via_points_map)
+    : shared_obstacle_snapshot_(NULL) {
   initialize(cfg, obstacles, robot_model, visual, via_points, human_model,
              humans_via_points_map);
 }
@@ -77,8 +96,10 @@ void TebOptimalPlanner::initialize(
     RobotFootprintModelPtr robot_model, TebVisualizationPtr visual,
     const ViaPointContainer *via_points, CircularRobotFootprintPtr human_model,
     const std::map<uint64_t, ViaPointContainer> *humans_via_points_map) {
-  // init optimizer (set solver and block ordering settings)
-  optimizer_ = initOptimizer();
+  // init optimizer (set solver and block ordering settings), unless an
+  // optimizer has been provided by setOptimizer()
+  if (!optimizer_)
+    optimizer_ = initOptimizer();
 
   cfg_ = &cfg;
   obstacles_ = obstacles;
@@ -87,6 +108,9 @@ void TebOptimalPlanner::initialize(
   via_points_ = via_points;
   humans_via_points_map_ = humans_via_points_map;
   cost_ = HUGE_VAL;
+  std::fill(cost_families_, cost_families_ + TELEMETRY_COSTS, 0.0);
+  no_iterations_ = 0;
+  trajectory_export_valid_ = false;
   setVisualization(visual);
 
   vel_start_.first = true;
@@ -109,8 +133,9 @@ void TebOptimalPlanner::visualize() {
   if (!visualization_)
     return;
 
-  visualization_->publishLocalPlanAndPoses(teb_, *robot_model_);
-  visualization_->publishHumanPlanPoses(humans_tebs_map_, *human_model_);
+  TrajectoryExportConstPtr trajectories = getTrajectoryExport();
+  visualization_->publishLocalPlanAndPoses(trajectories->robot, *robot_model_);
+  visualization_->publishHumanPlanPoses(trajectories->humans, *human_model_);
 
   if (teb_.sizePoses() > 0)
     visualization_->publishRobotFootprintModel(teb_.Pose(0), *robot_model_);
@@ -194,7 +219,7 @@ boost::shared_ptr<g2o::SparseOptimizer> TebOptimalPlanner::initOptimizer() {
   TEBLinearSolver *linearSolver =
       new TEBLinearSolver(); // see typedef in optimization.h
   linearSolver->setBlockOrdering(true);
-  TEBBlockSolver *blockSolver = new TEBBlockSolver(linearSolver);
+  ParallelBlockSolver *blockSolver = new ParallelBlockSolver(linearSolver);
   g2o::OptimizationAlgorithmLevenberg *solver =
       new g2o::OptimizationAlgorithmLevenberg(blockSolver);
 
@@ -205,52 +230,270 @@ boost::shared_ptr<g2o::SparseOptimizer> TebOptimalPlanner::initOptimizer() {
   return optimizer;
 }
 
+void TebOptimalPlanner::setEdgeThreads(g2o::SparseOptimizer *optimizer,
+                                       int num_threads) {
+  g2o::OptimizationAlgorithmWithHessian *algorithm =
+      dynamic_cast<g2o::OptimizationAlgorithmWithHessian *>(
+          optimizer->algorithm());
+  if (!algorithm)
+    return;
+  ParallelBlockSolver *block_solver =
+      dynamic_cast<ParallelBlockSolver *>(algorithm->solver());
+  if (block_solver)
+    block_solver->setNumThreads(num_threads);
+}
+
 bool TebOptimalPlanner::optimizeTEB(unsigned int iterations_innerloop,
                                     unsigned int iterations_outerloop,
                                     bool compute_cost_afterwards,
                                     double obst_cost_scale,
                                     double viapoint_cost_scale,
                                     bool alternative_time_cost) {
+  // the bands have been updated by the caller
+  trajectory_export_valid_ = false;
+
   if (cfg_->optim.optimization_activate == false)
     return false;
-  bool success = false;
-  optimized_ = false;
-  for (unsigned int i = 0; i < iterations_outerloop; ++i) {
-    if (cfg_->trajectory.teb_autosize) {
-      teb_.autoResize(cfg_->trajectory.dt_ref, cfg_->trajectory.dt_hysteresis,
-                      cfg_->trajectory.min_samples);
-
-      for (auto &human_teb_kv : humans_tebs_map_)
-        human_teb_kv.second.autoResize(cfg_->trajectory.dt_ref,
-                                       cfg_->trajectory.dt_hysteresis,
-                                       cfg_->trajectory.min_samples);
-    }
 
-    success = buildGraph();
-    if (!success) {
-      clearGraph();
-      return false;
-    }
-    success = optimizeGraph(iterations_innerloop, false);
-    if (!success) {
-      clearGraph();
+  for (unsigned int i = 0; i < iterations_outerloop; ++i) {
+    // compute cost vec only in the last iteration
+    if (!optimizeTEBIteration(i, iterations_innerloop, iterations_outerloop,
+                              compute_cost_afterwards &&
+                                  i == iterations_outerloop - 1,
+                              obst_cost_scale, viapoint_cost_scale,
+                              alternative_time_cost))
       return false;
+  }
+
+  return true;
+}
+
+bool TebOptimalPlanner::optimizeTEBIteration(unsigned int iteration,
+                                             unsigned int iterations_innerloop,
+                                             unsigned int iterations_outerloop,
+                                             bool compute_cost,
+                                             double obst_cost_scale,
+                                             double viapoint_cost_scale,
+                                             bool alternative_time_cost) {
+  if (cfg_->optim.optimization_activate == false)
+    return false;
+  bool success = false;
+
+  trajectory_export_valid_ = false;
+
+  if (iteration == 0) {
+    optimized_ = false;
+    no_iterations_ = 0;
+
+    if (shared_obstacle_snapshot_ == NULL)
+      obstacle_snapshot_.build(obstacles_);
+
+    if (cfg_->planning_mode == 1 && cfg_->optim.human_pre_optimization &&
+        !humans_tebs_map_.empty()) {
+      // failures are not critical here, the joint solve continues with the
+      // current human bands
+      if (!optimizeHumanTEBs(iterations_innerloop, iterations_outerloop))
+        ROS_WARN_THROTTLE(THROTTLE_RATE,
+                          "optimizeTEB(): pre-optimization of at least one "
+                          "human trajectory failed.");
     }
-    optimized_ = true;
+  }
 
-    if (compute_cost_afterwards &&
-        i ==
-            iterations_outerloop -
-                1) // compute cost vec only in the last iteration
-      computeCurrentCost(obst_cost_scale, viapoint_cost_scale,
-                         alternative_time_cost);
+  if (cfg_->trajectory.teb_autosize) {
+    resizeTEB(teb_, cfg_->trajectory.min_samples);
 
+    for (auto &human_teb_kv : humans_tebs_map_) {
+      if (!isHumanOptimized(human_teb_kv.first))
+        continue; // passive bands are not modified
+      resizeTEB(human_teb_kv.second, cfg_->trajectory.min_samples);
+    }
+  }
+
+  success = buildGraph();
+  if (!success) {
+    clearGraph();
+    return false;
+  }
+  success = optimizeGraph(iterations_innerloop, false);
+  if (!success) {
     clearGraph();
+    return false;
   }
+  optimized_ = true;
+
+  if (compute_cost)
+    computeCurrentCost(obst_cost_scale, viapoint_cost_scale,
+                       alternative_time_cost);
 
+  clearGraph();
   return true;
 }
 
+bool TebOptimalPlanner::optimizeHumanTEBs(unsigned int iterations_innerloop,
+                                          unsigned int iterations_outerloop) {
+  // drop optimizers of humans that are not tracked anymore
+  auto opt_itr = humans_optimizers_.begin();
+  while (opt_itr != humans_optimizers_.end()) {
+    if (humans_tebs_map_.find(opt_itr->first) == humans_tebs_map_.end())
+      opt_itr = humans_optimizers_.erase(opt_itr);
+    else
+      ++opt_itr;
+  }
+
+  // create missing optimizers before starting the workers, the maps are only
+  // read by the workers
+  std::vector<std::pair<uint64_t, TimedElasticBand *>> human_tebs;
+  std::vector<g2o::SparseOptimizer *> human_optimizers;
+  human_tebs.reserve(humans_tebs_map_.size());
+  human_optimizers.reserve(humans_tebs_map_.size());
+  for (auto &human_teb_kv : humans_tebs_map_) {
+    if (!isHumanOptimized(human_teb_kv.first))
+      continue;
+    auto &human_optimizer = humans_optimizers_[human_teb_kv.first];
+    if (!human_optimizer)
+      human_optimizer = initOptimizer();
+    human_tebs.push_back(
+        std::make_pair(human_teb_kv.first, &human_teb_kv.second));
+    human_optimizers.push_back(human_optimizer.get());
+  }
+
+  std::vector<char> results(human_tebs.size(), false);
+  auto optimize_human = [&](std::size_t idx) {
+    results[idx] = optimizeHumanTEB(
+        human_optimizers[idx], human_tebs[idx].first, *human_tebs[idx].second,
+        iterations_innerloop, iterations_outerloop);
+  };
+
+  if (cfg_->hcp.enable_multithreading && human_tebs.size() > 1) {
+    human_workers_.run(human_tebs.size(), optimize_human, human_tebs.size());
+  } else {
+    for (std::size_t idx = 0; idx < human_tebs.size(); ++idx)
+      optimize_human(idx);
+  }
+
+  return std::find(results.begin(), results.end(), false) == results.end();
+}
+
+bool TebOptimalPlanner::optimizeHumanTEB(g2o::SparseOptimizer *optimizer,
+                                         uint64_t human_id,
+                                         TimedElasticBand &human_teb,
+                                         unsigned int iterations_innerloop,
+                                         unsigned int iterations_outerloop) {
+  if (!human_teb.isInit())
+    return false;
+  if ((int)human_teb.sizePoses() < cfg_->trajectory.human_min_samples) {
+    // short bands are kept as they are, this is not a failure
+    ROS_WARN_ONCE("optimizeHumanTEB(): band of human %ld has less than "
+                  "human_min_samples poses, skipping its pre-optimization.",
+                  human_id);
+    return true;
+  }
+
+  bool success = true;
+  for (unsigned int i = 0; i < iterations_outerloop && success; ++i) {
+    if (cfg_->trajectory.teb_autosize)
+      resizeTEB(human_teb, cfg_->trajectory.human_min_samples);
+
+    unsigned int id_counter = 0;
+    AddTEBVerticesForHuman(optimizer, human_teb, id_counter);
+
+    AddEdgesObstaclesForHuman(optimizer, human_id, human_teb);
+    if (AddEdgesDynamicObstaclesForHuman(optimizer, human_id, human_teb))
+      addTimePrefixAction(optimizer, human_teb);
+    AddEdgesViaPointsForHuman(optimizer, human_id, human_teb);
+    AddEdgesVelocityForHuman(optimizer, human_id, human_teb);
+    AddEdgesAccelerationForHuman(optimizer, human_id, human_teb);
+    AddEdgesTimeOptimalForHuman(optimizer, human_id, human_teb);
+    AddEdgesKinematicsDiffDriveForHuman(optimizer, human_id, human_teb);
+
+    optimizer->setVerbose(cfg_->optim.optimization_verbose);
+    optimizer->initializeOptimization();
+    success = optimizer->optimize(iterations_innerloop) > 0;
+
+    // see clearGraph(), vertices are owned by the human teb
+    optimizer->vertices().clear();
+    optimizer->clear();
+    optimizer->removeComputeErrorAction(human_teb.timePrefixAction());
+    optimizer->removePreIterationAction(human_teb.timePrefixAction());
+  }
+
+  return success;
+}
+
+void TebOptimalPlanner::updateHumansLevelOfDetail() {
+  passive_humans_.clear();
+  human_obstacles_.clear();
+
+  bool lod_enabled = cfg_->human.lod_distance > 0 && teb_.sizePoses() > 0;
+
+  Eigen::Vector2d robot_pos = Eigen::Vector2d::Zero();
+  Eigen::Vector2d robot_vel = Eigen::Vector2d::Zero();
+  if (lod_enabled) {
+    robot_pos = teb_.Pose(0).position();
+    robot_vel = vel_start_.second.coeff(0) *
+                Eigen::Vector2d(std::cos(teb_.Pose(0).theta()),
+                                std::sin(teb_.Pose(0).theta()));
+  }
+
+  for (auto &human_teb_kv : humans_tebs_map_) {
+    auto &human_id = human_teb_kv.first;
+    auto &human_teb = human_teb_kv.second;
+    if (human_teb.sizePoses() == 0)
+      continue;
+
+    bool passive = false;
+    Eigen::Vector2d human_pos = human_teb.Pose(0).position();
+    Eigen::Vector2d human_vel = Eigen::Vector2d::Zero();
+    if (lod_enabled) {
+      auto vel_start_it = humans_vel_start_.find(human_id);
+      if (vel_start_it != humans_vel_start_.end() && vel_start_it->second.first)
+        human_vel = vel_start_it->second.second.coeff(0) *
+                    Eigen::Vector2d(std::cos(human_teb.Pose(0).theta()),
+                                    std::sin(human_teb.Pose(0).theta()));
+
+      // closest approach assuming constant velocities within the horizon
+      double cpa_time = calc_closest_point_to_approach_time<Eigen::Vector2d>(
+          robot_pos, robot_vel, human_pos, human_vel);
+      cpa_time =
+          std::min(std::max(cpa_time, 0.0), cfg_->human.lod_time_horizon);
+      double cpa_dist = ((human_pos + cpa_time * human_vel) -
+                         (robot_pos + cpa_time * robot_vel))
+                            .norm();
+      passive = cpa_dist > cfg_->human.lod_distance;
+    }
+
+    // fixed bands keep their shape, only the robot reacts to them
+    bool fixed = passive && cfg_->human.lod_mode == 1;
+    for (unsigned int i = 1; i + 1 < human_teb.sizePoses(); ++i)
+      human_teb.setPoseVertexFixed(i, fixed);
+    for (unsigned int i = 0; i < human_teb.sizeTimeDiffs(); ++i)
+      human_teb.setTimeDiffVertexFixed(i, fixed);
+
+    if (!passive)
+      continue;
+    passive_humans_.insert(human_id);
+
+    if (cfg_->human.lod_mode == 0) {
+      ObstaclePtr human_obstacle(new PointObstacle(human_pos));
+      human_obstacle->setCentroidVelocity(human_vel);
+      human_obstacles_.push_back(human_obstacle);
+    }
+  }
+
+  ROS_DEBUG_COND(!passive_humans_.empty(),
+                 "updateHumansLevelOfDetail(): %lu of %lu humans are not "
+                 "optimized jointly",
+                 passive_humans_.size(), humans_tebs_map_.size());
+}
+
+bool TebOptimalPlanner::isHumanOptimized(uint64_t human_id) const {
+  return passive_humans_.find(human_id) == passive_humans_.end();
+}
+
+bool TebOptimalPlanner::isHumanInGraph(uint64_t human_id) const {
+  return isHumanOptimized(human_id) || cfg_->human.lod_mode == 1;
+}
+
 void TebOptimalPlanner::setVelocityStart(
     const Eigen::Ref<const Eigen::Vector2d> &vel_start) {
   vel_start_.first = true;
@@ -316,6 +559,8 @@ bool TebOptimalPlanner::plan(
   auto human_prep_time_start = ros::Time::now();
   humans_vel_start_.clear();
   humans_vel_goal_.clear();
+  passive_humans_.clear();
+  human_obstacles_.clear();
   switch (cfg_->planning_mode) {
   case 0:
     humans_tebs_map_.clear();
@@ -346,8 +591,8 @@ bool TebOptimalPlanner::plan(
       }
 
       if (humans_tebs_map_.find(human_id) == humans_tebs_map_.end()) {
-        // create new human-teb for new human
-        humans_tebs_map_[human_id] = TimedElasticBand();
+        // create new human-teb for new human (default constructed in place,
+        // the band owns its vertex storage and cannot be copied)
         humans_tebs_map_[human_id].initTEBtoGoal(
             initial_human_plan, cfg_->trajectory.dt_ref, true,
             cfg_->trajectory.human_min_samples,
@@ -377,13 +622,12 @@ bool TebOptimalPlanner::plan(
                                   cfg_->trajectory.teb_init_skip_dist);
         }
       }
-      // give start velocity for humans
+      // give start velocity for humans, (v, omega) as for the robot
       std::pair<bool, Eigen::Vector2d> human_start_vel;
       human_start_vel.first = true;
-      human_start_vel.second.coeffRef(0) =
-          initial_human_plan_vel_kv.second.start_vel.linear.x;
-      human_start_vel.second.coeffRef(1) =
-          initial_human_plan_vel_kv.second.start_vel.angular.z;
+      human_start_vel.second = humanBodyVelocity(
+          initial_human_plan_vel_kv.second.start_vel,
+          humans_tebs_map_[human_id].Pose(0).theta());
       humans_vel_start_[human_id] = human_start_vel;
 
       // do not set goal velocity for humans
@@ -396,6 +640,8 @@ bool TebOptimalPlanner::plan(
       //     initial_human_plan_vel_kv.second.goal_vel.angular.z;
       // humans_vel_goal_[human_id] = human_goal_vel;
     }
+
+    updateHumansLevelOfDetail();
     break;
   }
   case 2: {
@@ -428,6 +674,14 @@ bool TebOptimalPlanner::plan(
   auto opt_time = ros::Time::now() - opt_start_time;
 
   auto total_time = ros::Time::now() - prep_start_time;
+  if (telemetry_) {
+    double phase_times[TELEMETRY_PHASES];
+    phase_times[TELEMETRY_PHASE_PREPARATION] = prep_time.toSec();
+    phase_times[TELEMETRY_PHASE_HUMANS] = human_prep_time.toSec();
+    phase_times[TELEMETRY_PHASE_OPTIMIZATION] = opt_time.toSec();
+    phase_times[TELEMETRY_PHASE_TOTAL] = total_time.toSec();
+    recordTelemetry(*telemetry_, phase_times);
+  }
   ROS_DEBUG_STREAM_COND(total_time.toSec() > 0.1,
                         "\nteb optimal plan times:\n"
                             << "\ttotal plan time                "
@@ -519,8 +773,44 @@ bool TebOptimalPlanner::buildGraph() {
     return false;
   }
 
+  // dispatch to the graph builder instantiated for the current configuration,
+  // combinations without a dedicated instantiation are resolved at runtime
+  const bool carlike = isCarlikeGraph(*cfg_);
+  switch (cfg_->planning_mode) {
+  case PLANNING_MODE_ROBOT:
+    if (carlike)
+      return buildGraphWith<GraphPolicy<PLANNING_MODE_ROBOT, true, 0>>();
+    return buildGraphWith<GraphPolicy<PLANNING_MODE_ROBOT, false, 0>>();
+  case PLANNING_MODE_HUMAN_AWARE:
+    if (carlike)
+      break;
+    switch (humanGraphTerms(*cfg_)) {
+    case HUMAN_TERMS_ALL:
+      return buildGraphWith<
+          GraphPolicy<PLANNING_MODE_HUMAN_AWARE, false, HUMAN_TERMS_ALL>>();
+    case HUMAN_TERMS_ALL & ~HUMAN_TERM_BANDS:
+      return buildGraphWith<GraphPolicy<PLANNING_MODE_HUMAN_AWARE, false,
+                                        HUMAN_TERMS_ALL & ~HUMAN_TERM_BANDS>>();
+    case HUMAN_TERM_BANDS:
+      return buildGraphWith<
+          GraphPolicy<PLANNING_MODE_HUMAN_AWARE, false, HUMAN_TERM_BANDS>>();
+    default:
+      break;
+    }
+    break;
+  case PLANNING_MODE_APPROACH:
+    if (carlike)
+      return buildGraphWith<GraphPolicy<PLANNING_MODE_APPROACH, true, 0>>();
+    return buildGraphWith<GraphPolicy<PLANNING_MODE_APPROACH, false, 0>>();
+  default:
+    break;
+  }
+  return buildGraphWith<RuntimeGraphPolicy>();
+}
+
+template <typename Policy> bool TebOptimalPlanner::buildGraphWith() {
   // add TEB vertices
-  AddTEBVertices();
+  AddTEBVerticesWith<Policy>();
 
   // add Edges (local cost functions)
   AddEdgesObstacles();
@@ -533,46 +823,47 @@ bool TebOptimalPlanner::buildGraph() {
 
   AddEdgesTimeOptimal();
 
-  if (cfg_->robot.min_turning_radius == 0 ||
-      cfg_->optim.weight_kinematics_turning_radius == 0)
-    AddEdgesKinematicsDiffDrive(); // we have a differential drive robot
-  else
+  if (Policy::carlike(*cfg_))
     AddEdgesKinematicsCarlike(); // we have a carlike robot since the turning
-  // radius is bounded from below.
+                                 // radius is bounded from below.
+  else
+    AddEdgesKinematicsDiffDrive(); // we have a differential drive robot
 
-  switch (cfg_->planning_mode) {
-  case 0:
+  switch (Policy::mode(*cfg_)) {
+  case PLANNING_MODE_ROBOT:
     break;
-  case 1:
-    AddEdgesObstaclesForHumans();
-    // AddEdgesDynamicObstaclesForHumans();
+  case PLANNING_MODE_HUMAN_AWARE:
+    if (Policy::hasTerm(*cfg_, HUMAN_TERM_BANDS)) {
+      AddEdgesObstaclesForHumans();
+      AddEdgesDynamicObstaclesForHumans();
 
-    AddEdgesViaPointsForHumans();
+      AddEdgesViaPointsForHumans();
 
-    AddEdgesVelocityForHumans();
-    AddEdgesAccelerationForHumans();
+      AddEdgesVelocityForHumans();
+      AddEdgesAccelerationForHumans();
 
-    AddEdgesTimeOptimalForHumans();
+      AddEdgesTimeOptimalForHumans();
 
-    AddEdgesKinematicsDiffDriveForHumans();
+      AddEdgesKinematicsDiffDriveForHumans();
+    }
 
-    if (cfg_->optim.use_human_robot_safety_c) {
+    if (Policy::hasTerm(*cfg_, HUMAN_TERM_ROBOT_SAFETY)) {
       AddEdgesHumanRobotSafety();
     }
 
-    if (cfg_->optim.use_human_human_safety_c) {
+    if (Policy::hasTerm(*cfg_, HUMAN_TERM_HUMAN_SAFETY)) {
       AddEdgesHumanHumanSafety();
     }
 
-    if (cfg_->optim.use_human_robot_ttc_c) {
+    if (Policy::hasTerm(*cfg_, HUMAN_TERM_ROBOT_TTC)) {
       AddEdgesHumanRobotTTC();
     }
 
-    if (cfg_->optim.use_human_robot_dir_c) {
+    if (Policy::hasTerm(*cfg_, HUMAN_TERM_ROBOT_DIR)) {
       AddEdgesHumanRobotDirectional();
     }
     break;
-  case 2:
+  case PLANNING_MODE_APPROACH:
     AddVertexEdgesApproach();
     break;
   default:
@@ -600,9 +891,11 @@ bool TebOptimalPlanner::optimizeGraph(int no_iterations, bool clear_after) {
   }
 
   optimizer_->setVerbose(cfg_->optim.optimization_verbose);
+  setEdgeThreads(optimizer_.get(), cfg_->optim.edge_threads);
   optimizer_->initializeOptimization();
 
   int iter = optimizer_->optimize(no_iterations);
+  no_iterations_ += iter > 0 ? iter : 0;
 
   if (!iter) {
     ROS_ERROR("optimizeGraph(): Optimization failed! iter=%i", iter);
@@ -622,9 +915,36 @@ void TebOptimalPlanner::clearGraph() {
                                   // deletes pointer-targets (therefore it
                                   // deletes TEB states!)
   optimizer_->clear();
+
+  for (g2o::HyperGraphAction *action : time_prefix_actions_) {
+    optimizer_->removeComputeErrorAction(action);
+    optimizer_->removePreIterationAction(action);
+  }
+  time_prefix_actions_.clear();
+
+  for (g2o::OptimizableGraph::Vertex *vertex : fixed_human_vertices_)
+    vertex->setFixed(false);
+  fixed_human_vertices_.clear();
 }
 
-void TebOptimalPlanner::AddTEBVertices() {
+void TebOptimalPlanner::addTimePrefixAction(g2o::SparseOptimizer *optimizer,
+                                            TimedElasticBand &teb) {
+  teb.updateTimePrefix();
+  optimizer->addComputeErrorAction(teb.timePrefixAction());
+  optimizer->addPreIterationAction(teb.timePrefixAction());
+}
+
+void TebOptimalPlanner::resizeTEB(TimedElasticBand &teb,
+                                  int min_samples) const {
+  if (cfg_->trajectory.teb_autosize_resample)
+    teb.resample(cfg_->trajectory.dt_ref, cfg_->trajectory.dt_hysteresis,
+                 min_samples);
+  else
+    teb.autoResize(cfg_->trajectory.dt_ref, cfg_->trajectory.dt_hysteresis,
+                   min_samples);
+}
+
+template <typename Policy> void TebOptimalPlanner::AddTEBVerticesWith() {
   // add vertices to graph
   ROS_DEBUG_COND(cfg_->optim.optimization_verbose, "Adding TEB vertices ...");
   unsigned int id_counter = 0; // used for vertices ids
@@ -637,24 +957,21 @@ void TebOptimalPlanner::AddTEBVertices() {
     }
   }
 
-  switch (cfg_->planning_mode) {
-  case 0:
+  switch (Policy::mode(*cfg_)) {
+  case PLANNING_MODE_ROBOT:
     break;
-  case 1: {
+  case PLANNING_MODE_HUMAN_AWARE: {
+    // without their own edges (pre-optimization) the human bands are only
+    // pushed by the coupling edges, hence they are kept as pre-optimized
+    const bool fix_humans = !Policy::hasTerm(*cfg_, HUMAN_TERM_BANDS);
     for (auto &human_teb_kv : humans_tebs_map_) {
-      auto &human_teb = human_teb_kv.second;
-      for (unsigned int i = 0; i < human_teb.sizePoses(); ++i) {
-        human_teb.PoseVertex(i)->setId(id_counter++);
-        optimizer_->addVertex(human_teb.PoseVertex(i));
-        if (teb_.sizeTimeDiffs() != 0 && i < human_teb.sizeTimeDiffs()) {
-          human_teb.TimeDiffVertex(i)->setId(id_counter++);
-          optimizer_->addVertex(human_teb.TimeDiffVertex(i));
-        }
-      }
+      if (isHumanInGraph(human_teb_kv.first))
+        AddTEBVerticesForHuman(optimizer_.get(), human_teb_kv.second,
+                               id_counter, fix_humans);
     }
     break;
   }
-  case 2: {
+  case PLANNING_MODE_APPROACH: {
     PoseSE2 approach_pose_se2(approach_pose_.pose);
     approach_pose_vertex = new VertexPose(approach_pose_se2, true);
     approach_pose_vertex->setId(id_counter++);
@@ -666,21 +983,41 @@ void TebOptimalPlanner::AddTEBVertices() {
   }
 }
 
+void TebOptimalPlanner::AddTEBVerticesForHuman(g2o::SparseOptimizer *optimizer,
+                                               TimedElasticBand &human_teb,
+                                               unsigned int &id_counter,
+                                               bool fixed) {
+  for (unsigned int i = 0; i < human_teb.sizePoses(); ++i) {
+    if (fixed && !human_teb.PoseVertex(i)->fixed()) {
+      human_teb.setPoseVertexFixed(i, true);
+      fixed_human_vertices_.push_back(human_teb.PoseVertex(i));
+    }
+    human_teb.PoseVertex(i)->setId(id_counter++);
+    optimizer->addVertex(human_teb.PoseVertex(i));
+    if (human_teb.sizeTimeDiffs() != 0 && i < human_teb.sizeTimeDiffs()) {
+      if (fixed && !human_teb.TimeDiffVertex(i)->fixed()) {
+        human_teb.setTimeDiffVertexFixed(i, true);
+        fixed_human_vertices_.push_back(human_teb.TimeDiffVertex(i));
+      }
+      human_teb.TimeDiffVertex(i)->setId(id_counter++);
+      optimizer->addVertex(human_teb.TimeDiffVertex(i));
+    }
+  }
+}
+
 void TebOptimalPlanner::AddEdgesObstacles() {
   if (cfg_->optim.weight_obstacle == 0 || obstacles_ == NULL)
     return; // if weight equals zero skip adding edges!
 
-  for (ObstContainer::const_iterator obst = obstacles_->begin();
-       obst != obstacles_->end(); ++obst) {
-    if ((*obst)->isDynamic()) // we handle dynamic obstacles differently below
-      continue;
-
+  // we handle dynamic obstacles differently below
+  const ObstacleSnapshot &obstacles = obstacleSnapshot();
+  for (unsigned int obst_idx : obstacles.staticIndices()) {
     unsigned int index;
 
     if (cfg_->obstacles.obstacle_poses_affected >= (int)teb_.sizePoses())
       index = teb_.sizePoses() / 2;
     else
-      index = teb_.findClosestTrajectoryPose(*(obst->get()));
+      index = teb_.findClosestTrajectoryPoseCached(obstacles, obst_idx);
 
     // check if obstacle is outside index-range between start and goal
     if ((index <= 1) ||
@@ -696,7 +1033,8 @@ void TebOptimalPlanner::AddEdgesObstacles() {
     EdgeObstacle *dist_bandpt_obst = new EdgeObstacle;
     dist_bandpt_obst->setVertex(0, teb_.PoseVertex(index));
     dist_bandpt_obst->setInformation(information);
-    dist_bandpt_obst->setParameters(*cfg_, robot_model_.get(), obst->get());
+    dist_bandpt_obst->setParameters(*cfg_, robot_model_.get(), &obstacles,
+                                    obst_idx);
     optimizer_->addEdge(dist_bandpt_obst);
 
     for (unsigned int neighbourIdx = 0;
@@ -708,7 +1046,7 @@ void TebOptimalPlanner::AddEdgesObstacles() {
                                         teb_.PoseVertex(index + neighbourIdx));
         dist_bandpt_obst_n_r->setInformation(information);
         dist_bandpt_obst_n_r->setParameters(*cfg_, robot_model_.get(),
-                                            obst->get());
+                                            &obstacles, obst_idx);
         optimizer_->addEdge(dist_bandpt_obst_n_r);
       }
       if ((int)index - (int)neighbourIdx >=
@@ -719,7 +1057,7 @@ void TebOptimalPlanner::AddEdgesObstacles() {
                                         teb_.PoseVertex(index - neighbourIdx));
         dist_bandpt_obst_n_l->setInformation(information);
         dist_bandpt_obst_n_l->setParameters(*cfg_, robot_model_.get(),
-                                            obst->get());
+                                            &obstacles, obst_idx);
         optimizer_->addEdge(dist_bandpt_obst_n_l);
       }
     }
@@ -727,118 +1065,157 @@ void TebOptimalPlanner::AddEdgesObstacles() {
 }
 
 void TebOptimalPlanner::AddEdgesObstaclesForHumans() {
+  for (auto &human_teb_kv : humans_tebs_map_) {
+    if (isHumanOptimized(human_teb_kv.first))
+      AddEdgesObstaclesForHuman(optimizer_.get(), human_teb_kv.first,
+                                human_teb_kv.second);
+  }
+}
+
+void TebOptimalPlanner::AddEdgesObstaclesForHuman(
+    g2o::SparseOptimizer *optimizer, uint64_t human_id,
+    TimedElasticBand &human_teb) {
   if (cfg_->optim.weight_obstacle == 0 || obstacles_ == NULL)
     return;
 
-  for (ObstContainer::const_iterator obst = obstacles_->begin();
-       obst != obstacles_->end(); ++obst) {
-    if ((*obst)->isDynamic()) // we handle dynamic obstacles differently below
-      continue;
+  Eigen::Matrix<double, 1, 1> information;
+  information.fill(cfg_->optim.weight_obstacle);
 
+  // we handle dynamic obstacles differently below
+  const ObstacleSnapshot &obstacles = obstacleSnapshot();
+  for (unsigned int obst_idx : obstacles.staticIndices()) {
     unsigned int index;
 
-    for (auto &human_teb_kv : humans_tebs_map_) {
-      auto &human_teb = human_teb_kv.second;
+    if (cfg_->obstacles.obstacle_poses_affected >= (int)human_teb.sizePoses())
+      index = human_teb.sizePoses() / 2;
+    else
+      index = human_teb.findClosestTrajectoryPoseCached(obstacles, obst_idx);
 
-      if (cfg_->obstacles.obstacle_poses_affected >= (int)human_teb.sizePoses())
-        index = human_teb.sizePoses() / 2;
-      else
-        index = human_teb.findClosestTrajectoryPose(*(obst->get()));
+    if ((index <= 1) || (index > human_teb.sizePoses() - 1))
+      continue;
 
-      if ((index <= 1) || (index > human_teb.sizePoses() - 1))
-        continue;
+    EdgeObstacle *dist_bandpt_obst = new EdgeObstacle;
+    dist_bandpt_obst->setVertex(0, human_teb.PoseVertex(index));
+    dist_bandpt_obst->setInformation(information);
+    dist_bandpt_obst->setParameters(
+        *cfg_, static_cast<CircularRobotFootprintPtr>(human_model_).get(),
+        &obstacles, obst_idx);
+    optimizer->addEdge(dist_bandpt_obst);
 
-      Eigen::Matrix<double, 1, 1> information;
-      information.fill(cfg_->optim.weight_obstacle);
-
-      EdgeObstacle *dist_bandpt_obst = new EdgeObstacle;
-      dist_bandpt_obst->setVertex(0, human_teb.PoseVertex(index));
-      dist_bandpt_obst->setInformation(information);
-      dist_bandpt_obst->setParameters(
-          *cfg_, static_cast<CircularRobotFootprintPtr>(human_model_).get(),
-          obst->get());
-      optimizer_->addEdge(dist_bandpt_obst);
-
-      for (unsigned int neighbourIdx = 0;
-           neighbourIdx < floor(cfg_->obstacles.obstacle_poses_affected / 2);
-           neighbourIdx++) {
-        if (index + neighbourIdx < human_teb.sizePoses()) {
-          EdgeObstacle *dist_bandpt_obst_n_r = new EdgeObstacle;
-          dist_bandpt_obst_n_r->setVertex(
-              0, human_teb.PoseVertex(index + neighbourIdx));
-          dist_bandpt_obst_n_r->setInformation(information);
-          dist_bandpt_obst_n_r->setParameters(
-              *cfg_, static_cast<CircularRobotFootprintPtr>(human_model_).get(),
-              obst->get());
-          optimizer_->addEdge(dist_bandpt_obst_n_r);
-        }
-        if ((int)index - (int)neighbourIdx >=
-            0) { // TODO: may be > is enough instead of >=
-          EdgeObstacle *dist_bandpt_obst_n_l = new EdgeObstacle;
-          dist_bandpt_obst_n_l->setVertex(
-              0, human_teb.PoseVertex(index - neighbourIdx));
-          dist_bandpt_obst_n_l->setInformation(information);
-          dist_bandpt_obst_n_l->setParameters(
-              *cfg_, static_cast<CircularRobotFootprintPtr>(human_model_).get(),
-              obst->get());
-          optimizer_->addEdge(dist_bandpt_obst_n_l);
-        }
+    for (unsigned int neighbourIdx = 0;
+         neighbourIdx < floor(cfg_->obstacles.obstacle_poses_affected / 2);
+         neighbourIdx++) {
+      if (index + neighbourIdx < human_teb.sizePoses()) {
+        EdgeObstacle *dist_bandpt_obst_n_r = new EdgeObstacle;
+        dist_bandpt_obst_n_r->setVertex(
+            0, human_teb.PoseVertex(index + neighbourIdx));
+        dist_bandpt_obst_n_r->setInformation(information);
+        dist_bandpt_obst_n_r->setParameters(
+            *cfg_, static_cast<CircularRobotFootprintPtr>(human_model_).get(),
+            &obstacles, obst_idx);
+        optimizer->addEdge(dist_bandpt_obst_n_r);
+      }
+      if ((int)index - (int)neighbourIdx >=
+          0) { // TODO: may be > is enough instead of >=
+        EdgeObstacle *dist_bandpt_obst_n_l = new EdgeObstacle;
+        dist_bandpt_obst_n_l->setVertex(
+            0, human_teb.PoseVertex(index - neighbourIdx));
+        dist_bandpt_obst_n_l->setInformation(information);
+        dist_bandpt_obst_n_l->setParameters(
+            *cfg_, static_cast<CircularRobotFootprintPtr>(human_model_).get(),
+            &obstacles, obst_idx);
+        optimizer->addEdge(dist_bandpt_obst_n_l);
       }
     }
   }
 }
 
 void TebOptimalPlanner::AddEdgesDynamicObstacles() {
-  if (cfg_->optim.weight_obstacle == 0 || obstacles_ == NULL)
+  if (cfg_->optim.weight_obstacle == 0)
     return; // if weight equals zero skip adding edges!
 
   Eigen::Matrix<double, 1, 1> information;
   information.fill(cfg_->optim.weight_dynamic_obstacle);
 
-  for (ObstContainer::const_iterator obst = obstacles_->begin();
-       obst != obstacles_->end(); ++obst) {
-    if (!(*obst)->isDynamic())
-      continue;
+  // distant humans (level of detail) are handled as dynamic obstacles as well
+  std::vector<const Obstacle *> dynamic_obstacles;
+  if (obstacles_ != NULL) {
+    const ObstacleSnapshot &obstacles = obstacleSnapshot();
+    for (unsigned int obst_idx : obstacles.dynamicIndices())
+      dynamic_obstacles.push_back(obstacles.obstacle(obst_idx));
+  }
+  for (const ObstaclePtr &obst : human_obstacles_) {
+    if (obst->isDynamic())
+      dynamic_obstacles.push_back(obst.get());
+  }
 
+  bool edges_added = false;
+  for (const Obstacle *obst : dynamic_obstacles) {
     for (std::size_t i = 1; i < teb_.sizePoses() - 1; ++i) {
-      EdgeDynamicObstacle *dynobst_edge = new EdgeDynamicObstacle(i);
+      std::size_t window = std::min<std::size_t>(
+          i, std::max(cfg_->obstacles.dynamic_obstacle_dt_window, 1));
+      EdgeDynamicObstacle *dynobst_edge = new EdgeDynamicObstacle(i, window);
       dynobst_edge->setVertex(0, teb_.PoseVertex(i));
-      // dynobst_edge->setVertex(1,teb.PointVertex(i+1));
-      dynobst_edge->setVertex(1, teb_.TimeDiffVertex(i));
+      for (std::size_t k = 0; k < window; ++k)
+        dynobst_edge->setVertex(k + 1, teb_.TimeDiffVertex(i - window + k));
       dynobst_edge->setInformation(information);
-      dynobst_edge->setMeasurement(obst->get());
+      dynobst_edge->setMeasurement(obst);
       dynobst_edge->setTebConfig(*cfg_);
+      dynobst_edge->setTimedElasticBand(teb_);
       optimizer_->addEdge(dynobst_edge);
+      edges_added = true;
     }
   }
+
+  if (edges_added) {
+    addTimePrefixAction(optimizer_.get(), teb_);
+    time_prefix_actions_.push_back(teb_.timePrefixAction());
+  }
 }
 
 void TebOptimalPlanner::AddEdgesDynamicObstaclesForHumans() {
+  for (auto &human_teb_kv : humans_tebs_map_) {
+    if (!isHumanOptimized(human_teb_kv.first))
+      continue;
+
+    if (AddEdgesDynamicObstaclesForHuman(optimizer_.get(), human_teb_kv.first,
+                                         human_teb_kv.second)) {
+      addTimePrefixAction(optimizer_.get(), human_teb_kv.second);
+      time_prefix_actions_.push_back(human_teb_kv.second.timePrefixAction());
+    }
+  }
+}
+
+bool TebOptimalPlanner::AddEdgesDynamicObstaclesForHuman(
+    g2o::SparseOptimizer *optimizer, uint64_t human_id,
+    TimedElasticBand &human_teb) {
   if (cfg_->optim.weight_obstacle == 0 || obstacles_ == NULL)
-    return;
+    return false;
 
   Eigen::Matrix<double, 1, 1> information;
   information.fill(cfg_->optim.weight_dynamic_obstacle);
 
-  for (ObstContainer::const_iterator obst = obstacles_->begin();
-       obst != obstacles_->end(); ++obst) {
-    if (!(*obst)->isDynamic())
-      continue;
-
-    for (auto &human_teb_kv : humans_tebs_map_) {
-      auto &human_teb = human_teb_kv.second;
-
-      for (std::size_t i = 1; i < human_teb.sizePoses() - 1; ++i) {
-        EdgeDynamicObstacle *dynobst_edge = new EdgeDynamicObstacle(i);
-        dynobst_edge->setVertex(0, human_teb.PoseVertex(i));
-        dynobst_edge->setVertex(1, human_teb.TimeDiffVertex(i));
-        dynobst_edge->setInformation(information);
-        dynobst_edge->setMeasurement(obst->get());
-        dynobst_edge->setTebConfig(*cfg_);
-        optimizer_->addEdge(dynobst_edge);
-      }
+  bool edges_added = false;
+  const ObstacleSnapshot &obstacles = obstacleSnapshot();
+  for (unsigned int obst_idx : obstacles.dynamicIndices()) {
+    const Obstacle *obst = obstacles.obstacle(obst_idx);
+
+    for (std::size_t i = 1; i < human_teb.sizePoses() - 1; ++i) {
+      std::size_t window = std::min<std::size_t>(
+          i, std::max(cfg_->obstacles.dynamic_obstacle_dt_window, 1));
+      EdgeDynamicObstacle *dynobst_edge = new EdgeDynamicObstacle(i, window);
+      dynobst_edge->setVertex(0, human_teb.PoseVertex(i));
+      for (std::size_t k = 0; k < window; ++k)
+        dynobst_edge->setVertex(k + 1, human_teb.TimeDiffVertex(i - window + k));
+      dynobst_edge->setInformation(information);
+      dynobst_edge->setMeasurement(obst);
+      dynobst_edge->setTebConfig(*cfg_);
+      dynobst_edge->setTimedElasticBand(human_teb);
+      optimizer->addEdge(dynobst_edge);
+      edges_added = true;
     }
   }
+  return edges_added;
 }
 
 void TebOptimalPlanner::AddEdgesViaPoints() {
@@ -881,20 +1258,12 @@ void TebOptimalPlanner::AddEdgesViaPoints() {
 }
 
 void TebOptimalPlanner::AddEdgesViaPointsForHumans() {
-  if (cfg_->optim.weight_human_viapoint == 0 || via_points_ == NULL ||
-      via_points_->empty())
-    return;
-
-  int start_pose_idx = 0;
-
-  int n = (int)teb_.sizePoses();
-  if (n < 3)
+  if (humans_via_points_map_ == NULL)
     return;
 
   for (auto &human_via_points_kv : *humans_via_points_map_) {
-
-    if (humans_tebs_map_.find(human_via_points_kv.first) ==
-        humans_tebs_map_.end()) {
+    auto human_teb_it = humans_tebs_map_.find(human_via_points_kv.first);
+    if (human_teb_it == humans_tebs_map_.end()) {
       ROS_WARN_THROTTLE(THROTTLE_RATE,
                         "inconsistant data between humans_tebs_map and "
                         "humans_via_points_map (for id %ld)",
@@ -902,30 +1271,51 @@ void TebOptimalPlanner::AddEdgesViaPointsForHumans() {
       continue;
     }
 
-    auto &human_via_points = human_via_points_kv.second;
-    auto &human_teb = humans_tebs_map_[human_via_points_kv.first];
-
-    for (ViaPointContainer::const_iterator vp_it = human_via_points.begin();
-         vp_it != human_via_points.end(); ++vp_it) {
-      int index =
-          human_teb.findClosestTrajectoryPose(*vp_it, NULL, start_pose_idx);
-      if (cfg_->trajectory.via_points_ordered)
-        start_pose_idx = index + 2;
-
-      if (index > n - 1)
-        index = n - 1;
-      if (index < 1)
-        index = 1;
-
-      Eigen::Matrix<double, 1, 1> information;
-      information.fill(cfg_->optim.weight_human_viapoint);
-
-      EdgeViaPoint *edge_viapoint = new EdgeViaPoint;
-      edge_viapoint->setVertex(0, human_teb.PoseVertex(index));
-      edge_viapoint->setInformation(information);
-      edge_viapoint->setParameters(*cfg_, &(*vp_it));
-      optimizer_->addEdge(edge_viapoint);
-    }
+    if (isHumanOptimized(human_teb_it->first))
+      AddEdgesViaPointsForHuman(optimizer_.get(), human_teb_it->first,
+                                human_teb_it->second);
+  }
+}
+
+void TebOptimalPlanner::AddEdgesViaPointsForHuman(
+    g2o::SparseOptimizer *optimizer, uint64_t human_id,
+    TimedElasticBand &human_teb) {
+  if (cfg_->optim.weight_human_viapoint == 0 ||
+      humans_via_points_map_ == NULL)
+    return;
+
+  int n = (int)human_teb.sizePoses();
+  if (n < 3)
+    return;
+
+  auto human_via_points_it = humans_via_points_map_->find(human_id);
+  if (human_via_points_it == humans_via_points_map_->end() ||
+      human_via_points_it->second.empty())
+    return;
+  auto &human_via_points = human_via_points_it->second;
+
+  int start_pose_idx = 0;
+
+  for (ViaPointContainer::const_iterator vp_it = human_via_points.begin();
+       vp_it != human_via_points.end(); ++vp_it) {
+    int index =
+        human_teb.findClosestTrajectoryPose(*vp_it, NULL, start_pose_idx);
+    if (cfg_->trajectory.via_points_ordered)
+      start_pose_idx = index + 2;
+
+    if (index > n - 1)
+      index = n - 1;
+    if (index < 1)
+      index = 1;
+
+    Eigen::Matrix<double, 1, 1> information;
+    information.fill(cfg_->optim.weight_human_viapoint);
+
+    EdgeViaPoint *edge_viapoint = new EdgeViaPoint;
+    edge_viapoint->setVertex(0, human_teb.PoseVertex(index));
+    edge_viapoint->setInformation(information);
+    edge_viapoint->setParameters(*cfg_, &(*vp_it));
+    optimizer->addEdge(edge_viapoint);
   }
 }
 
@@ -952,6 +1342,16 @@ void TebOptimalPlanner::AddEdgesVelocity() {
 }
 
 void TebOptimalPlanner::AddEdgesVelocityForHumans() {
+  for (auto &human_teb_kv : humans_tebs_map_) {
+    if (isHumanOptimized(human_teb_kv.first))
+      AddEdgesVelocityForHuman(optimizer_.get(), human_teb_kv.first,
+                               human_teb_kv.second);
+  }
+}
+
+void TebOptimalPlanner::AddEdgesVelocityForHuman(
+    g2o::SparseOptimizer *optimizer, uint64_t human_id,
+    TimedElasticBand &human_teb) {
   if (cfg_->optim.weight_max_human_vel_x == 0 &&
       cfg_->optim.weight_max_human_vel_theta == 0 &&
       cfg_->optim.weight_nominal_human_vel_x == 0)
@@ -963,19 +1363,15 @@ void TebOptimalPlanner::AddEdgesVelocityForHumans() {
   information(1, 1) = cfg_->optim.weight_max_human_vel_theta;
   information(2, 2) = cfg_->optim.weight_nominal_human_vel_x;
 
-  for (auto &human_teb_kv : humans_tebs_map_) {
-    auto &human_teb = human_teb_kv.second;
-
-    std::size_t NoBandpts(human_teb.sizePoses());
-    for (std::size_t i = 0; i < NoBandpts - 1; ++i) {
-      EdgeVelocityHuman *human_velocity_edge = new EdgeVelocityHuman;
-      human_velocity_edge->setVertex(0, human_teb.PoseVertex(i));
-      human_velocity_edge->setVertex(1, human_teb.PoseVertex(i + 1));
-      human_velocity_edge->setVertex(2, human_teb.TimeDiffVertex(i));
-      human_velocity_edge->setInformation(information);
-      human_velocity_edge->setTebConfig(*cfg_);
-      optimizer_->addEdge(human_velocity_edge);
-    }
+  std::size_t NoBandpts(human_teb.sizePoses());
+  for (std::size_t i = 0; i < NoBandpts - 1; ++i) {
+    EdgeVelocityHuman *human_velocity_edge = new EdgeVelocityHuman;
+    human_velocity_edge->setVertex(0, human_teb.PoseVertex(i));
+    human_velocity_edge->setVertex(1, human_teb.PoseVertex(i + 1));
+    human_velocity_edge->setVertex(2, human_teb.TimeDiffVertex(i));
+    human_velocity_edge->setInformation(information);
+    human_velocity_edge->setTebConfig(*cfg_);
+    optimizer->addEdge(human_velocity_edge);
   }
 }
 
@@ -1030,6 +1426,16 @@ void TebOptimalPlanner::AddEdgesAcceleration() {
 }
 
 void TebOptimalPlanner::AddEdgesAccelerationForHumans() {
+  for (auto &human_teb_kv : humans_tebs_map_) {
+    if (isHumanOptimized(human_teb_kv.first))
+      AddEdgesAccelerationForHuman(optimizer_.get(), human_teb_kv.first,
+                                   human_teb_kv.second);
+  }
+}
+
+void TebOptimalPlanner::AddEdgesAccelerationForHuman(
+    g2o::SparseOptimizer *optimizer, uint64_t human_id,
+    TimedElasticBand &human_teb) {
   if (cfg_->optim.weight_human_acc_lim_x == 0 &&
       cfg_->optim.weight_human_acc_lim_theta == 0)
     return;
@@ -1039,53 +1445,49 @@ void TebOptimalPlanner::AddEdgesAccelerationForHumans() {
   information(0, 0) = cfg_->optim.weight_human_acc_lim_x;
   information(1, 1) = cfg_->optim.weight_human_acc_lim_theta;
 
-  for (auto &human_teb_kv : humans_tebs_map_) {
-    auto &human_it = human_teb_kv.first;
-    auto &human_teb = human_teb_kv.second;
-
-    std::size_t NoBandpts(human_teb.sizePoses());
-
-    if (humans_vel_start_[human_it].first) {
-      EdgeAccelerationHumanStart *human_acceleration_edge =
-          new EdgeAccelerationHumanStart;
-      human_acceleration_edge->setVertex(0, human_teb.PoseVertex(0));
-      human_acceleration_edge->setVertex(1, human_teb.PoseVertex(1));
-      human_acceleration_edge->setVertex(2, human_teb.TimeDiffVertex(0));
-      human_acceleration_edge->setInitialVelocity(
-          humans_vel_start_[human_it].second);
-      human_acceleration_edge->setInformation(information);
-      human_acceleration_edge->setTebConfig(*cfg_);
-      optimizer_->addEdge(human_acceleration_edge);
-    }
+  std::size_t NoBandpts(human_teb.sizePoses());
+
+  // use find() instead of operator[], this may run concurrently for humans
+  auto human_vel_start_it = humans_vel_start_.find(human_id);
+  if (human_vel_start_it != humans_vel_start_.end() &&
+      human_vel_start_it->second.first) {
+    EdgeAccelerationHumanStart *human_acceleration_edge =
+        new EdgeAccelerationHumanStart;
+    human_acceleration_edge->setVertex(0, human_teb.PoseVertex(0));
+    human_acceleration_edge->setVertex(1, human_teb.PoseVertex(1));
+    human_acceleration_edge->setVertex(2, human_teb.TimeDiffVertex(0));
+    human_acceleration_edge->setInitialVelocity(
+        human_vel_start_it->second.second);
+    human_acceleration_edge->setInformation(information);
+    human_acceleration_edge->setTebConfig(*cfg_);
+    optimizer->addEdge(human_acceleration_edge);
+  }
 
-    for (std::size_t i = 0; i < NoBandpts - 2; ++i) {
-      EdgeAccelerationHuman *human_acceleration_edge =
-          new EdgeAccelerationHuman;
-      human_acceleration_edge->setVertex(0, human_teb.PoseVertex(i));
-      human_acceleration_edge->setVertex(1, human_teb.PoseVertex(i + 1));
-      human_acceleration_edge->setVertex(2, human_teb.PoseVertex(i + 2));
-      human_acceleration_edge->setVertex(3, human_teb.TimeDiffVertex(i));
-      human_acceleration_edge->setVertex(4, human_teb.TimeDiffVertex(i + 1));
-      human_acceleration_edge->setInformation(information);
-      human_acceleration_edge->setTebConfig(*cfg_);
-      optimizer_->addEdge(human_acceleration_edge);
-    }
+  for (std::size_t i = 0; i < NoBandpts - 2; ++i) {
+    EdgeAccelerationHuman *human_acceleration_edge = new EdgeAccelerationHuman;
+    human_acceleration_edge->setVertex(0, human_teb.PoseVertex(i));
+    human_acceleration_edge->setVertex(1, human_teb.PoseVertex(i + 1));
+    human_acceleration_edge->setVertex(2, human_teb.PoseVertex(i + 2));
+    human_acceleration_edge->setVertex(3, human_teb.TimeDiffVertex(i));
+    human_acceleration_edge->setVertex(4, human_teb.TimeDiffVertex(i + 1));
+    human_acceleration_edge->setInformation(information);
+    human_acceleration_edge->setTebConfig(*cfg_);
+    optimizer->addEdge(human_acceleration_edge);
+  }
 
-    if (humans_vel_goal_[human_it].first) {
-      EdgeAccelerationHumanGoal *human_acceleration_edge =
-          new EdgeAccelerationHumanGoal;
-      human_acceleration_edge->setVertex(0,
-                                         human_teb.PoseVertex(NoBandpts - 2));
-      human_acceleration_edge->setVertex(1,
-                                         human_teb.PoseVertex(NoBandpts - 1));
-      human_acceleration_edge->setVertex(
-          2, human_teb.TimeDiffVertex(human_teb.sizeTimeDiffs() - 1));
-      human_acceleration_edge->setGoalVelocity(
-          humans_vel_goal_[human_it].second);
-      human_acceleration_edge->setInformation(information);
-      human_acceleration_edge->setTebConfig(*cfg_);
-      optimizer_->addEdge(human_acceleration_edge);
-    }
+  auto human_vel_goal_it = humans_vel_goal_.find(human_id);
+  if (human_vel_goal_it != humans_vel_goal_.end() &&
+      human_vel_goal_it->second.first) {
+    EdgeAccelerationHumanGoal *human_acceleration_edge =
+        new EdgeAccelerationHumanGoal;
+    human_acceleration_edge->setVertex(0, human_teb.PoseVertex(NoBandpts - 2));
+    human_acceleration_edge->setVertex(1, human_teb.PoseVertex(NoBandpts - 1));
+    human_acceleration_edge->setVertex(
+        2, human_teb.TimeDiffVertex(human_teb.sizeTimeDiffs() - 1));
+    human_acceleration_edge->setGoalVelocity(human_vel_goal_it->second.second);
+    human_acceleration_edge->setInformation(information);
+    human_acceleration_edge->setTebConfig(*cfg_);
+    optimizer->addEdge(human_acceleration_edge);
   }
 }
 
@@ -1107,6 +1509,16 @@ void TebOptimalPlanner::AddEdgesTimeOptimal() {
 }
 
 void TebOptimalPlanner::AddEdgesTimeOptimalForHumans() {
+  for (auto &human_teb_kv : humans_tebs_map_) {
+    if (isHumanOptimized(human_teb_kv.first))
+      AddEdgesTimeOptimalForHuman(optimizer_.get(), human_teb_kv.first,
+                                  human_teb_kv.second);
+  }
+}
+
+void TebOptimalPlanner::AddEdgesTimeOptimalForHuman(
+    g2o::SparseOptimizer *optimizer, uint64_t human_id,
+    TimedElasticBand &human_teb) {
   if (cfg_->optim.weight_human_optimaltime == 0) {
     return;
   }
@@ -1114,18 +1526,14 @@ void TebOptimalPlanner::AddEdgesTimeOptimalForHumans() {
   Eigen::Matrix<double, 1, 1> information;
   information.fill(cfg_->optim.weight_human_optimaltime);
 
-  for (auto &human_teb_kv : humans_tebs_map_) {
-    auto &human_teb = human_teb_kv.second;
-
-    std::size_t NoTimeDiffs(human_teb.sizeTimeDiffs());
-    for (std::size_t i = 0; i < NoTimeDiffs; ++i) {
-      EdgeTimeOptimal *timeoptimal_edge = new EdgeTimeOptimal;
-      timeoptimal_edge->setVertex(0, human_teb.TimeDiffVertex(i));
-      timeoptimal_edge->setInformation(information);
-      timeoptimal_edge->setTebConfig(*cfg_);
-      timeoptimal_edge->setInitialTime(human_teb.TimeDiffVertex(i)->dt());
-      optimizer_->addEdge(timeoptimal_edge);
-    }
+  std::size_t NoTimeDiffs(human_teb.sizeTimeDiffs());
+  for (std::size_t i = 0; i < NoTimeDiffs; ++i) {
+    EdgeTimeOptimal *timeoptimal_edge = new EdgeTimeOptimal;
+    timeoptimal_edge->setVertex(0, human_teb.TimeDiffVertex(i));
+    timeoptimal_edge->setInformation(information);
+    timeoptimal_edge->setTebConfig(*cfg_);
+    timeoptimal_edge->setInitialTime(human_teb.TimeDiffVertex(i)->dt());
+    optimizer->addEdge(timeoptimal_edge);
   }
 }
 
@@ -1153,6 +1561,16 @@ void TebOptimalPlanner::AddEdgesKinematicsDiffDrive() {
 }
 
 void TebOptimalPlanner::AddEdgesKinematicsDiffDriveForHumans() {
+  for (auto &human_teb_kv : humans_tebs_map_) {
+    if (isHumanOptimized(human_teb_kv.first))
+      AddEdgesKinematicsDiffDriveForHuman(optimizer_.get(), human_teb_kv.first,
+                                          human_teb_kv.second);
+  }
+}
+
+void TebOptimalPlanner::AddEdgesKinematicsDiffDriveForHuman(
+    g2o::SparseOptimizer *optimizer, uint64_t human_id,
+    TimedElasticBand &human_teb) {
   if (cfg_->optim.weight_kinematics_nh == 0 &&
       cfg_->optim.weight_kinematics_forward_drive == 0)
     return; // if weight equals zero skip adding edges!
@@ -1163,16 +1581,13 @@ void TebOptimalPlanner::AddEdgesKinematicsDiffDriveForHumans() {
   information_kinematics(0, 0) = cfg_->optim.weight_kinematics_nh;
   information_kinematics(1, 1) = cfg_->optim.weight_kinematics_forward_drive;
 
-  for (auto &human_teb_kv : humans_tebs_map_) {
-    auto &human_teb = human_teb_kv.second;
-    for (unsigned int i = 0; i < human_teb.sizePoses() - 1; i++) {
-      EdgeKinematicsDiffDrive *kinematics_edge = new EdgeKinematicsDiffDrive;
-      kinematics_edge->setVertex(0, human_teb.PoseVertex(i));
-      kinematics_edge->setVertex(1, human_teb.PoseVertex(i + 1));
-      kinematics_edge->setInformation(information_kinematics);
-      kinematics_edge->setTebConfig(*cfg_);
-      optimizer_->addEdge(kinematics_edge);
-    }
+  for (unsigned int i = 0; i < human_teb.sizePoses() - 1; i++) {
+    EdgeKinematicsDiffDrive *kinematics_edge = new EdgeKinematicsDiffDrive;
+    kinematics_edge->setVertex(0, human_teb.PoseVertex(i));
+    kinematics_edge->setVertex(1, human_teb.PoseVertex(i + 1));
+    kinematics_edge->setInformation(information_kinematics);
+    kinematics_edge->setTebConfig(*cfg_);
+    optimizer->addEdge(kinematics_edge);
   }
 }
 
@@ -1203,6 +1618,8 @@ void TebOptimalPlanner::AddEdgesHumanRobotSafety() {
   auto robot_teb_size = teb_.sizePoses();
 
   for (auto &human_teb_kv : humans_tebs_map_) {
+    if (!isHumanInGraph(human_teb_kv.first))
+      continue;
     auto &human_teb = human_teb_kv.second;
 
     for (unsigned int i = 0;
@@ -1224,8 +1641,13 @@ void TebOptimalPlanner::AddEdgesHumanRobotSafety() {
 void TebOptimalPlanner::AddEdgesHumanHumanSafety() {
   //std::map<uint64_t, TimedElasticBand>::iterator oi, ii;
   for (auto oi = humans_tebs_map_.begin(); oi != humans_tebs_map_.end();) {
+    auto human1_id = oi->first;
     auto &human1_teb = oi->second;
     for (auto ii = ++oi; ii != humans_tebs_map_.end(); ii++) {
+      // skip pairs that are not in the graph or where both bands are fixed
+      if (!isHumanInGraph(human1_id) || !isHumanInGraph(ii->first) ||
+          (!isHumanOptimized(human1_id) && !isHumanOptimized(ii->first)))
+        continue;
       auto &human2_teb = ii->second;
 
       for (unsigned int k = 0;
@@ -1251,11 +1673,16 @@ void TebOptimalPlanner::AddEdgesHumanRobotTTC() {
 
   auto robot_teb_size = teb_.sizePoses();
   for (auto &human_teb_kv : humans_tebs_map_) {
+    if (!isHumanInGraph(human_teb_kv.first))
+      continue;
     auto &human_teb = human_teb_kv.second;
 
     size_t human_teb_size = human_teb.sizePoses();
+    std::vector<bool> active = activeHumanCouplingIndices(human_teb, false);
     for (unsigned int i = 0;
          (i < human_teb_size - 1) && (i < robot_teb_size - 1); i++) {
+      if (!active[i])
+        continue;
 
       EdgeHumanRobotTTC *human_robot_ttc_edge = new EdgeHumanRobotTTC;
       human_robot_ttc_edge->setVertex(0, teb_.PoseVertex(i));
@@ -1277,11 +1704,16 @@ void TebOptimalPlanner::AddEdgesHumanRobotDirectional() {
 
   auto robot_teb_size = teb_.sizePoses();
   for (auto &human_teb_kv : humans_tebs_map_) {
+    if (!isHumanInGraph(human_teb_kv.first))
+      continue;
     auto &human_teb = human_teb_kv.second;
 
     size_t human_teb_size = human_teb.sizePoses();
+    std::vector<bool> active = activeHumanCouplingIndices(human_teb, true);
     for (unsigned int i = 0;
          (i < human_teb_size - 1) && (i < robot_teb_size - 1); i++) {
+      if (!active[i])
+        continue;
 
       EdgeHumanRobotDirectional *human_robot_dir_edge =
           new EdgeHumanRobotDirectional;
@@ -1298,6 +1730,56 @@ void TebOptimalPlanner::AddEdgesHumanRobotDirectional() {
   }
 }
 
+std::vector<bool>
+TebOptimalPlanner::activeHumanCouplingIndices(const TimedElasticBand &human_teb,
+                                              bool directional) const {
+  std::size_t n = std::min(human_teb.sizePoses(), teb_.sizePoses());
+  n = n > 0 ? n - 1 : 0;
+  if (!cfg_->optim.sparse_human_coupling)
+    return std::vector<bool>(n, true);
+
+  double threshold = directional ? cfg_->human.dir_cost_threshold
+                                 : cfg_->human.ttc_threshold;
+  threshold = (threshold + cfg_->optim.penalty_epsilon) *
+              (1.0 + cfg_->optim.human_coupling_margin);
+  double radius_sum = robot_radius_ + human_radius_;
+
+  std::vector<bool> active(n, false);
+  int window = std::max(cfg_->optim.human_coupling_window, 0);
+  for (std::size_t i = 0; i < n; ++i) {
+    Eigen::Vector2d robot_vel =
+        (teb_.Pose(i + 1).position() - teb_.Pose(i).position()) /
+        teb_.TimeDiff(i);
+    Eigen::Vector2d human_vel =
+        (human_teb.Pose(i + 1).position() - human_teb.Pose(i).position()) /
+        human_teb.TimeDiff(i);
+    Eigen::Vector2d C = human_teb.Pose(i).position() - teb_.Pose(i).position();
+
+    bool is_active;
+    if (directional) {
+      // zero dir_cost gives a constant error without gradient, NaN (robot and
+      // human at the same position) is kept
+      double dir_cost =
+          EdgeHumanRobotDirectional::computeDirCost(robot_vel, human_vel, C);
+      is_active = !(dir_cost <= 0.0 || dir_cost >= threshold);
+    } else {
+      double ttc = EdgeHumanRobotTTC::computeTTC(C, robot_vel - human_vel,
+                                                 radius_sum * radius_sum);
+      is_active = ttc < threshold;
+    }
+    if (!is_active)
+      continue;
+
+    // pad the window around the active index
+    std::size_t from = i > (std::size_t)window ? i - window : 0;
+    std::size_t to = std::min(i + window, n - 1);
+    for (std::size_t j = from; j <= to; ++j)
+      active[j] = true;
+  }
+
+  return active;
+}
+
 void TebOptimalPlanner::AddVertexEdgesApproach() {
   if (!approach_pose_vertex) {
     ROS_ERROR("approch pose vertex does not exist");
@@ -1335,6 +1817,10 @@ void TebOptimalPlanner::computeCurrentCost(double obst_cost_scale,
 
   optimizer_->computeInitialGuess();
 
+  // edges depending on the absolute time read the cached time prefixes
+  for (g2o::HyperGraphAction *action : time_prefix_actions_)
+    (*action)(optimizer_.get());
+
   cost_ = 0;
   double time_opt_cost = 0.0, kinematics_dd_cost = 0.0,
          kinematics_cl_cost = 0.0, vel_cost = 0.0, acc_cost = 0.0,
@@ -1455,6 +1941,19 @@ void TebOptimalPlanner::computeCurrentCost(double obst_cost_scale,
             acc_cost, obst_cost, dyn_obst_cost, via_cost, hr_safety_cost,
             hh_safety_cost, hr_ttc_cost, hr_dir_cost);
 
+  cost_families_[TELEMETRY_COST_TIME_OPTIMAL] = time_opt_cost;
+  cost_families_[TELEMETRY_COST_KINEMATICS_DIFF_DRIVE] = kinematics_dd_cost;
+  cost_families_[TELEMETRY_COST_KINEMATICS_CARLIKE] = kinematics_cl_cost;
+  cost_families_[TELEMETRY_COST_VELOCITY] = vel_cost;
+  cost_families_[TELEMETRY_COST_ACCELERATION] = acc_cost;
+  cost_families_[TELEMETRY_COST_OBSTACLE] = obst_cost;
+  cost_families_[TELEMETRY_COST_DYNAMIC_OBSTACLE] = dyn_obst_cost;
+  cost_families_[TELEMETRY_COST_VIA_POINT] = via_cost;
+  cost_families_[TELEMETRY_COST_HUMAN_ROBOT_SAFETY] = hr_safety_cost;
+  cost_families_[TELEMETRY_COST_HUMAN_HUMAN_SAFETY] = hh_safety_cost;
+  cost_families_[TELEMETRY_COST_HUMAN_ROBOT_TTC] = hr_ttc_cost;
+  cost_families_[TELEMETRY_COST_HUMAN_ROBOT_DIRECTIONAL] = hr_dir_cost;
+
   // delete temporary created graph
   if (!graph_exist_flag)
     clearGraph();
@@ -1524,9 +2023,11 @@ void TebOptimalPlanner::getVelocityProfile(
   velocity_profile.back().angular.z = vel_goal_.second.y();
 }
 
-void TebOptimalPlanner::getFullTrajectory(
+void TebOptimalPlanner::exportTrajectory(
+    const TimedElasticBand &teb, const Eigen::Vector2d &vel_start,
+    const Eigen::Vector2d &vel_goal,
     std::vector<TrajectoryPointMsg> &trajectory) const {
-  int n = (int)teb_.sizePoses();
+  int n = (int)teb.sizePoses();
 
   trajectory.resize(n);
 
@@ -1537,101 +2038,180 @@ void TebOptimalPlanner::getFullTrajectory(
 
   // start
   TrajectoryPointMsg &start = trajectory.front();
-  teb_.Pose(0).toPoseMsg(start.pose);
+  teb.Pose(0).toPoseMsg(start.pose);
   start.velocity.linear.y = start.velocity.linear.z = 0;
   start.velocity.angular.x = start.velocity.angular.y = 0;
-  start.velocity.linear.x = vel_start_.second.x();
-  start.velocity.angular.z = vel_start_.second.y();
+  start.velocity.linear.x = vel_start.x();
+  start.velocity.angular.z = vel_start.y();
   start.time_from_start.fromSec(curr_time);
 
-  curr_time += teb_.TimeDiff(0);
+  if (n < 2)
+    return;
+
+  curr_time += teb.TimeDiff(0);
 
   // intermediate points
   for (int i = 1; i < n - 1; ++i) {
     TrajectoryPointMsg &point = trajectory[i];
-    teb_.Pose(i).toPoseMsg(point.pose);
+    teb.Pose(i).toPoseMsg(point.pose);
     point.velocity.linear.y = point.velocity.linear.z = 0;
     point.velocity.angular.x = point.velocity.angular.y = 0;
     double vel1, vel2, omega1, omega2;
-    extractVelocity(teb_.Pose(i - 1), teb_.Pose(i), teb_.TimeDiff(i - 1), vel1,
+    extractVelocity(teb.Pose(i - 1), teb.Pose(i), teb.TimeDiff(i - 1), vel1,
                     omega1);
-    extractVelocity(teb_.Pose(i), teb_.Pose(i + 1), teb_.TimeDiff(i), vel2,
+    extractVelocity(teb.Pose(i), teb.Pose(i + 1), teb.TimeDiff(i), vel2,
                     omega2);
     point.velocity.linear.x = 0.5 * (vel1 + vel2);
     point.velocity.angular.z = 0.5 * (omega1 + omega2);
     point.time_from_start.fromSec(curr_time);
 
-    curr_time += teb_.TimeDiff(i);
+    curr_time += teb.TimeDiff(i);
   }
 
   // goal
   TrajectoryPointMsg &goal = trajectory.back();
-  teb_.BackPose().toPoseMsg(goal.pose);
+  teb.BackPose().toPoseMsg(goal.pose);
   goal.velocity.linear.y = goal.velocity.linear.z = 0;
   goal.velocity.angular.x = goal.velocity.angular.y = 0;
-  goal.velocity.linear.x = vel_goal_.second.x();
-  goal.velocity.angular.z = vel_goal_.second.y();
+  goal.velocity.linear.x = vel_goal.x();
+  goal.velocity.angular.z = vel_goal.y();
   goal.time_from_start.fromSec(curr_time);
 }
 
+TrajectoryExportConstPtr TebOptimalPlanner::getTrajectoryExport() const {
+  if (trajectory_export_valid_ && trajectory_export_)
+    return trajectory_export_;
+
+  // reuse the buffer of the previous cycle, unless a consumer still holds it
+  if (!trajectory_export_ || !trajectory_export_.unique())
+    trajectory_export_ = boost::make_shared<TrajectoryExport>();
+
+  exportTrajectory(teb_, vel_start_.second, vel_goal_.second,
+                   trajectory_export_->robot);
+
+  auto &humans = trajectory_export_->humans;
+  for (auto itr = humans.begin(); itr != humans.end();) {
+    if (humans_tebs_map_.find(itr->first) == humans_tebs_map_.end())
+      itr = humans.erase(itr);
+    else
+      ++itr;
+  }
+  for (auto &human_teb_kv : humans_tebs_map_) {
+    auto &human_id = human_teb_kv.first;
+    auto vel_start_it = humans_vel_start_.find(human_id);
+    auto vel_goal_it = humans_vel_goal_.find(human_id);
+    exportTrajectory(human_teb_kv.second,
+                     vel_start_it != humans_vel_start_.end()
+                         ? vel_start_it->second.second
+                         : Eigen::Vector2d::Zero().eval(),
+                     vel_goal_it != humans_vel_goal_.end()
+                         ? vel_goal_it->second.second
+                         : Eigen::Vector2d::Zero().eval(),
+                     humans[human_id]);
+  }
+
+  trajectory_export_valid_ = true;
+  return trajectory_export_;
+}
+
+void TebOptimalPlanner::getFullTrajectory(
+    std::vector<TrajectoryPointMsg> &trajectory) const {
+  trajectory = getTrajectoryExport()->robot;
+}
+
 void TebOptimalPlanner::getFullHumanTrajectory(
     const uint64_t human_id,
     std::vector<TrajectoryPointMsg> &human_trajectory) {
   auto human_teb_it = humans_tebs_map_.find(human_id);
   if (human_teb_it != humans_tebs_map_.end()) {
-    auto &human_teb = human_teb_it->second;
-
-    auto human_teb_size = human_teb.sizePoses();
+    auto human_teb_size = human_teb_it->second.sizePoses();
     if (human_teb_size < 3) {
       ROS_WARN("TEB size is %ld for human %ld", human_teb_size, human_id);
       return;
     }
 
-    human_trajectory.resize(human_teb_size);
-
-    double curr_time = 0;
-
-    // start
-    TrajectoryPointMsg &start = human_trajectory.front();
-    human_teb.Pose(0).toPoseMsg(start.pose);
-    start.velocity.linear.y = start.velocity.linear.z = 0;
-    start.velocity.angular.x = start.velocity.angular.y = 0;
-    start.velocity.linear.x = humans_vel_start_[human_id].second.x();
-    start.velocity.angular.z = humans_vel_start_[human_id].second.y();
-    start.time_from_start.fromSec(curr_time);
-
-    curr_time += human_teb.TimeDiff(0);
-
-    // intermediate points
-    for (int i = 1; i < human_teb_size - 1; ++i) {
-      TrajectoryPointMsg &point = human_trajectory[i];
-      human_teb.Pose(i).toPoseMsg(point.pose);
-      point.velocity.linear.y = point.velocity.linear.z = 0;
-      point.velocity.angular.x = point.velocity.angular.y = 0;
-      double vel1, vel2, omega1, omega2;
-      extractVelocity(human_teb.Pose(i - 1), human_teb.Pose(i),
-                      human_teb.TimeDiff(i - 1), vel1, omega1);
-      extractVelocity(human_teb.Pose(i), human_teb.Pose(i + 1),
-                      human_teb.TimeDiff(i), vel2, omega2);
-      point.velocity.linear.x = 0.5 * (vel1 + vel2);
-      point.velocity.angular.z = 0.5 * (omega1 + omega2);
-      point.time_from_start.fromSec(curr_time);
-
-      curr_time += human_teb.TimeDiff(i);
-    }
-
-    // goal
-    TrajectoryPointMsg &goal = human_trajectory.back();
-    human_teb.BackPose().toPoseMsg(goal.pose);
-    goal.velocity.linear.y = goal.velocity.linear.z = 0;
-    goal.velocity.angular.x = goal.velocity.angular.y = 0;
-    goal.velocity.linear.x = humans_vel_goal_[human_id].second.x();
-    goal.velocity.angular.z = humans_vel_goal_[human_id].second.y();
-    goal.time_from_start.fromSec(curr_time);
+    human_trajectory = getTrajectoryExport()->humans.at(human_id);
   }
   return;
 }
 
+namespace {
+
+void writeTelemetryPoses(TelemetryRecorder &recorder,
+                         const TimedElasticBand &teb) {
+  for (unsigned int i = 0; i < teb.sizePoses(); ++i) {
+    TelemetryPose pose;
+    pose.x = teb.Pose(i).x();
+    pose.y = teb.Pose(i).y();
+    pose.theta = teb.Pose(i).theta();
+    pose.dt = i < teb.sizeTimeDiffs() ? teb.TimeDiff(i) : 0.0;
+    recorder.write(pose);
+  }
+}
+
+} // namespace
+
+bool TebOptimalPlanner::recordTelemetry(
+    TelemetryRecorder &recorder,
+    const double (&phase_times)[TELEMETRY_PHASES]) const {
+  const ObstacleSnapshot &obstacles = obstacleSnapshot();
+
+  TelemetryCycleHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.no_iterations = no_iterations_;
+  header.stamp = ros::Time::now().toSec();
+  std::copy(phase_times, phase_times + TELEMETRY_PHASES, header.phase_times);
+  std::copy(cost_families_, cost_families_ + TELEMETRY_COSTS, header.costs);
+  header.no_robot_poses = teb_.sizePoses();
+  header.no_humans = humans_tebs_map_.size();
+  header.no_obstacles = obstacles.size();
+  recorder.beginRecord(header);
+
+  writeTelemetryPoses(recorder, teb_);
+
+  for (auto &human_teb_kv : humans_tebs_map_) {
+    TelemetryHumanHeader human;
+    human.id = human_teb_kv.first;
+    human.no_poses = human_teb_kv.second.sizePoses();
+    human.reserved = 0;
+    recorder.write(human);
+    writeTelemetryPoses(recorder, human_teb_kv.second);
+  }
+
+  for (std::size_t i = 0; i < obstacles.size(); ++i) {
+    TelemetryObstacleHeader obstacle;
+    obstacle.type = obstacles.type(i);
+    unsigned int k = obstacles.typeIndex(i);
+    switch (obstacles.type(i)) {
+    case ObstacleSnapshot::POINT_OBSTACLE:
+      obstacle.no_vertices = 1;
+      recorder.write(obstacle);
+      recorder.write(obstacles.pointPositions()[k].data(), 2 * sizeof(double));
+      break;
+    case ObstacleSnapshot::LINE_OBSTACLE:
+      obstacle.no_vertices = 2;
+      recorder.write(obstacle);
+      recorder.write(obstacles.lineStarts()[k].data(), 2 * sizeof(double));
+      recorder.write(obstacles.lineEnds()[k].data(), 2 * sizeof(double));
+      break;
+    case ObstacleSnapshot::POLYGON_OBSTACLE:
+      obstacle.no_vertices = obstacles.polygonSize(k);
+      recorder.write(obstacle);
+      for (unsigned int j = 0; j < obstacle.no_vertices; ++j)
+        recorder.write(obstacles.polygonVertices(k)[j].data(),
+                       2 * sizeof(double));
+      break;
+    default: // unknown types are represented by their centroid
+      obstacle.no_vertices = 1;
+      recorder.write(obstacle);
+      recorder.write(obstacles.centroid(i).data(), 2 * sizeof(double));
+      break;
+    }
+  }
+
+  return recorder.commitRecord();
+}
+
 bool TebOptimalPlanner::isTrajectoryFeasible(
     base_local_planner::CostmapModel *costmap_model,
     const std::vector<geometry_msgs::Point> &footprint_spec,
@@ -0,0 +1,96 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Copyright (c) 2016 LAAS/CNRS
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <teb_local_planner/optimizer_pool.h>
+#include <teb_local_planner/optimal_planner.h>
+
+#include <algorithm>
+
+namespace teb_local_planner {
+
+OptimizerPool::OptimizerPool(std::size_t max_size)
+    : storage_(new Storage) {
+  storage_->max_size = max_size;
+}
+
+OptimizerPool::OptimizerPtr OptimizerPool::acquire() {
+  OptimizerPtr optimizer;
+  {
+    boost::mutex::scoped_lock lock(storage_->mutex);
+    if (!storage_->idle.empty()) {
+      optimizer = storage_->idle.back();
+      storage_->idle.pop_back();
+    }
+  }
+  if (!optimizer)
+    optimizer = TebOptimalPlanner::initOptimizer();
+
+  // the returned handle shares the optimizer, but hands it back to the pool
+  // instead of deleting it
+  ReturnToPool deleter;
+  deleter.storage = storage_;
+  deleter.optimizer = optimizer;
+  return OptimizerPtr(optimizer.get(), deleter);
+}
+
+void OptimizerPool::reserve(std::size_t num_optimizers) {
+  boost::mutex::scoped_lock lock(storage_->mutex);
+  storage_->max_size = std::max(storage_->max_size, num_optimizers);
+  while (storage_->idle.size() < num_optimizers)
+    storage_->idle.push_back(TebOptimalPlanner::initOptimizer());
+}
+
+std::size_t OptimizerPool::sizeIdle() const {
+  boost::mutex::scoped_lock lock(storage_->mutex);
+  return storage_->idle.size();
+}
+
+void OptimizerPool::ReturnToPool::operator()(g2o::SparseOptimizer *) {
+  boost::shared_ptr<Storage> pool = storage.lock();
+  // a non-empty graph still references vertices of a (possibly destroyed)
+  // trajectory, do not reuse it
+  if (pool && optimizer->vertices().empty() && optimizer->edges().empty()) {
+    boost::mutex::scoped_lock lock(pool->mutex);
+    if (pool->idle.size() < pool->max_size)
+      pool->idle.push_back(optimizer);
+  }
+  optimizer.reset();
+}
+
+} // namespace teb_local_planner
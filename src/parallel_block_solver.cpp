@@ -0,0 +1,241 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Copyright (c) 2016 LAAS/CNRS
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <teb_local_planner/parallel_block_solver.h>
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
+namespace teb_local_planner {
+
+ParallelBlockSolver::ParallelBlockSolver(LinearSolverType *linear_solver)
+    : g2o::BlockSolverX(linear_solver), num_threads_(1),
+      coloring_valid_(false) {}
+
+bool ParallelBlockSolver::init(g2o::SparseOptimizer *optimizer, bool online) {
+  coloring_valid_ = false; // the active edges and the vertex indices changed
+  return g2o::BlockSolverX::init(optimizer, online);
+}
+
+bool ParallelBlockSolver::buildSystem() {
+  const g2o::OptimizableGraph::EdgeContainer &edges =
+      _optimizer->activeEdges();
+  if (num_threads_ < 2 || edges.size() < MinParallelEdges)
+    return g2o::BlockSolverX::buildSystem();
+
+  if (!coloring_valid_)
+    computeColoring();
+
+  // clear the quadratic forms of the vertices and the Hessian
+  for (std::size_t i = 0; i < _optimizer->indexMapping().size(); ++i)
+    _optimizer->indexMapping()[i]->clearQuadraticForm();
+  _Hpp->clear();
+  if (_doSchur) {
+    _Hll->clear();
+    _Hpl->clear();
+  }
+
+  // linearize the edges color by color (the calling thread takes part as
+  // well), the remaining small colors form a serial batch
+  std::size_t num_threads = (std::size_t)num_threads_;
+  if (workspaces_.size() < num_threads)
+    workspaces_.resize(num_threads, _optimizer->jacobianWorkspace());
+  for (std::size_t c = 0; c + 1 < color_offsets_.size(); ++c)
+    workers_.run(num_threads,
+                 boost::bind(&ParallelBlockSolver::linearizeColor, this, c, _1,
+                             num_threads),
+                 num_threads);
+  linearizeEdges(color_offsets_.back(), colored_edges_.size(), workspaces_[0]);
+
+  // flush the gradient of each vertex into the system
+  for (std::size_t i = 0; i < _optimizer->indexMapping().size(); ++i) {
+    g2o::OptimizableGraph::Vertex *v = _optimizer->indexMapping()[i];
+    int iBase = v->colInHessian();
+    if (v->marginalized())
+      iBase -= _sizePoses;
+    v->copyB(_b + iBase);
+  }
+  return true;
+}
+
+void ParallelBlockSolver::computeColoring() {
+  const g2o::OptimizableGraph::EdgeContainer &edges =
+      _optimizer->activeEdges();
+
+  vertex_colors_.resize(_optimizer->indexMapping().size());
+  for (std::size_t i = 0; i < vertex_colors_.size(); ++i)
+    vertex_colors_[i].clear();
+
+  // the workspaces are sized for the current graph
+  workspaces_.clear();
+
+  // color the edges at vertices with a high degree first (Welsh-Powell)
+  std::vector<std::size_t> degrees(vertex_colors_.size(), 0);
+  for (std::size_t k = 0; k < edges.size(); ++k) {
+    for (std::size_t i = 0; i < edges[k]->vertices().size(); ++i) {
+      int idx = static_cast<const g2o::OptimizableGraph::Vertex *>(
+                    edges[k]->vertex(i))
+                    ->hessianIndex();
+      if (idx >= 0)
+        ++degrees[idx];
+    }
+  }
+  std::vector<std::pair<std::size_t, std::size_t>> order(edges.size());
+  for (std::size_t k = 0; k < edges.size(); ++k) {
+    std::size_t degree = 0;
+    for (std::size_t i = 0; i < edges[k]->vertices().size(); ++i) {
+      int idx = static_cast<const g2o::OptimizableGraph::Vertex *>(
+                    edges[k]->vertex(i))
+                    ->hessianIndex();
+      if (idx >= 0)
+        degree = std::max(degree, degrees[idx]);
+    }
+    order[k] = std::make_pair(degree, k);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [](const std::pair<std::size_t, std::size_t> &a,
+                      const std::pair<std::size_t, std::size_t> &b) {
+                     return a.first > b.first;
+                   });
+
+  // greedy first-fit coloring: pick the smallest color that is not yet used
+  // by any non-fixed vertex of the edge (fixed vertices are only read)
+  std::vector<unsigned int> edge_colors(edges.size());
+  std::vector<boost::uint64_t> used;
+  std::size_t num_colors = 0;
+  for (std::size_t o = 0; o < order.size(); ++o) {
+    std::size_t k = order[o].second;
+    const g2o::OptimizableGraph::Edge *edge = edges[k];
+
+    used.clear();
+    for (std::size_t i = 0; i < edge->vertices().size(); ++i) {
+      int idx = static_cast<const g2o::OptimizableGraph::Vertex *>(
+                    edge->vertex(i))
+                    ->hessianIndex();
+      if (idx < 0)
+        continue;
+      const std::vector<boost::uint64_t> &mask = vertex_colors_[idx];
+      if (mask.size() > used.size())
+        used.resize(mask.size(), 0);
+      for (std::size_t w = 0; w < mask.size(); ++w)
+        used[w] |= mask[w];
+    }
+
+    std::size_t word = 0;
+    while (word < used.size() && used[word] == ~boost::uint64_t(0))
+      ++word;
+    std::size_t color = 64 * word;
+    if (word < used.size()) {
+      boost::uint64_t free = ~used[word];
+      while (!(free & 1)) {
+        free >>= 1;
+        ++color;
+      }
+    }
+    edge_colors[k] = (unsigned int)color;
+    num_colors = std::max(num_colors, color + 1);
+
+    for (std::size_t i = 0; i < edge->vertices().size(); ++i) {
+      int idx = static_cast<const g2o::OptimizableGraph::Vertex *>(
+                    edge->vertex(i))
+                    ->hessianIndex();
+      if (idx < 0)
+        continue;
+      std::vector<boost::uint64_t> &mask = vertex_colors_[idx];
+      if (mask.size() <= color / 64)
+        mask.resize(color / 64 + 1, 0);
+      mask[color / 64] |= boost::uint64_t(1) << (color % 64);
+    }
+  }
+
+  // parallel colors first (in the order of decreasing size), the small
+  // colors form the serial batch at the end
+  std::vector<std::size_t> color_sizes(num_colors, 0);
+  for (std::size_t k = 0; k < edges.size(); ++k)
+    ++color_sizes[edge_colors[k]];
+  std::vector<std::size_t> colors(num_colors);
+  for (std::size_t c = 0; c < num_colors; ++c)
+    colors[c] = c;
+  std::stable_sort(colors.begin(), colors.end(),
+                   [&color_sizes](std::size_t a, std::size_t b) {
+                     return color_sizes[a] > color_sizes[b];
+                   });
+  std::size_t num_parallel = 0;
+  while (num_parallel < num_colors &&
+         color_sizes[colors[num_parallel]] >= MinParallelColorEdges)
+    ++num_parallel;
+
+  // sort the edges by color (counting sort, the order within a color is kept)
+  std::vector<std::size_t> slots(num_colors); // position of each color
+  for (std::size_t c = 0; c < num_colors; ++c)
+    slots[colors[c]] = std::min(c, num_parallel);
+  color_offsets_.assign(num_parallel + 2, 0);
+  for (std::size_t k = 0; k < edges.size(); ++k)
+    ++color_offsets_[slots[edge_colors[k]] + 1];
+  for (std::size_t c = 0; c + 1 < color_offsets_.size(); ++c)
+    color_offsets_[c + 1] += color_offsets_[c];
+
+  colored_edges_.resize(edges.size());
+  std::vector<std::size_t> positions(color_offsets_.begin(),
+                                     color_offsets_.end() - 1);
+  for (std::size_t k = 0; k < edges.size(); ++k)
+    colored_edges_[positions[slots[edge_colors[k]]]++] = edges[k];
+  color_offsets_.pop_back(); // the serial batch ends with colored_edges_
+
+  coloring_valid_ = true;
+}
+
+void ParallelBlockSolver::linearizeColor(std::size_t color, std::size_t chunk,
+                                         std::size_t num_chunks) {
+  std::size_t begin = color_offsets_[color];
+  std::size_t size = color_offsets_[color + 1] - begin;
+  linearizeEdges(begin + size * chunk / num_chunks,
+                 begin + size * (chunk + 1) / num_chunks, workspaces_[chunk]);
+}
+
+void ParallelBlockSolver::linearizeEdges(std::size_t first, std::size_t last,
+                                         g2o::JacobianWorkspace &workspace) {
+  for (std::size_t k = first; k < last; ++k) {
+    colored_edges_[k]->linearizeOplus(workspace);
+    colored_edges_[k]->constructQuadraticForm();
+  }
+}
+
+} // namespace teb_local_planner
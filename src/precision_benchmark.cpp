@@ -0,0 +1,276 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************/
+
+#include <teb_local_planner/g2o_types/edge_kernels.h>
+
+#include <ros/time.h>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+using namespace teb_local_planner; // it is ok here to import everything for benchmarking purposes
+
+// Compares the kinematic edge kernels evaluated in single precision with the double precision path
+// (see edge_kernels.h and the CMake option TEB_FLOAT_PRECISION).
+//
+// Usage: precision_benchmark [trajectory_file]
+// The optional file contains recorded trajectories, one state "x y theta dt" per line
+// (dt denotes the time to the next state), trajectories are separated by empty lines.
+// Without a file a set of random trajectories is generated.
+
+
+//! A single trajectory: poses and time differences
+struct Scenario
+{
+  std::vector<PoseSE2, Eigen::aligned_allocator<PoseSE2> > poses;
+  std::vector<double> dts;
+};
+
+//! Error statistics of a quantity
+struct ErrorStatistics
+{
+  ErrorStatistics() : max_abs(0), sum_abs(0), max_rel(0), count(0) {}
+  
+  void add(double value, double reference)
+  {
+    double err = std::abs(value - reference);
+    max_abs = std::max(max_abs, err);
+    sum_abs += err;
+    max_rel = std::max(max_rel, err / std::max(std::abs(reference), 1e-3));
+    ++count;
+  }
+  
+  void print(const char* name) const
+  {
+    std::printf("  %-22s max abs %.3e   mean abs %.3e   max rel %.3e\n", name, max_abs, count ? sum_abs/count : 0., max_rel);
+  }
+  
+  double max_abs;
+  double sum_abs;
+  double max_rel;
+  std::size_t count;
+};
+
+
+bool loadScenarios(const std::string& filename, std::vector<Scenario>& scenarios)
+{
+  std::ifstream file(filename.c_str());
+  if (!file)
+    return false;
+  
+  scenarios.push_back(Scenario());
+  std::string line;
+  while (std::getline(file, line))
+  {
+    std::istringstream ss(line);
+    double x, y, theta, dt;
+    if (!(ss >> x >> y >> theta))
+    {
+      if (!scenarios.back().poses.empty())
+        scenarios.push_back(Scenario());
+      continue;
+    }
+    if (!(ss >> dt))
+      dt = 0;
+    scenarios.back().poses.push_back(PoseSE2(x, y, theta));
+    scenarios.back().dts.push_back(dt);
+  }
+  if (scenarios.back().poses.empty())
+    scenarios.pop_back();
+  return true;
+}
+
+
+void generateScenarios(std::size_t no_scenarios, std::size_t no_poses, std::vector<Scenario>& scenarios)
+{
+  boost::random::mt19937 rng(42);
+  boost::random::uniform_real_distribution<double> position(-20, 20);
+  boost::random::uniform_real_distribution<double> angle(-M_PI, M_PI);
+  boost::random::uniform_real_distribution<double> vel(-0.3, 1.2);
+  boost::random::uniform_real_distribution<double> omega(-1.0, 1.0);
+  boost::random::uniform_real_distribution<double> dt(0.05, 0.6);
+  
+  for (std::size_t i=0; i < no_scenarios; ++i)
+  {
+    Scenario scenario;
+    PoseSE2 pose(position(rng), position(rng), angle(rng));
+    for (std::size_t k=0; k < no_poses; ++k)
+    {
+      double dt_k = dt(rng);
+      scenario.poses.push_back(pose);
+      scenario.dts.push_back(dt_k);
+      double v = vel(rng);
+      pose.x() += v * dt_k * std::cos(pose.theta());
+      pose.y() += v * dt_k * std::sin(pose.theta());
+      pose.theta() = g2o::normalize_theta(pose.theta() + omega(rng) * dt_k);
+    }
+    scenarios.push_back(scenario);
+  }
+}
+
+
+//! Translational and rotational acceleration of three consecutive poses (see EdgeAcceleration)
+template <typename Scalar>
+void computeAcceleration(const PoseSE2& pose1, const PoseSE2& pose2, const PoseSE2& pose3, double dt1, double dt2, Scalar& acc_lin, Scalar& acc_rot)
+{
+  Scalar vel1, omega1, vel2, omega2;
+  computeVelocity(pose1, pose2, dt1, vel1, omega1);
+  computeVelocity(pose2, pose3, dt2, vel2, omega2);
+  acc_lin = (vel2 - vel1) * 2 / Scalar(dt1 + dt2);
+  acc_rot = (omega2 - omega1) * 2 / Scalar(dt1 + dt2);
+}
+
+
+//! Central difference of the translational velocity w.r.t. the x coordinate of the second pose
+template <typename Scalar>
+double velocityDerivative(const PoseSE2& pose1, const PoseSE2& pose2, double dt, double delta)
+{
+  PoseSE2 plus = pose2, minus = pose2;
+  plus.x() += delta;
+  minus.x() -= delta;
+  Scalar vel_plus, vel_minus, omega;
+  computeVelocity(pose1, plus, dt, vel_plus, omega);
+  computeVelocity(pose1, minus, dt, vel_minus, omega);
+  return (double(vel_plus) - double(vel_minus)) / (2*delta);
+}
+
+
+template <typename Scalar>
+double benchmarkKernels(const std::vector<Scenario>& scenarios, int repetitions)
+{
+  ros::WallTime start = ros::WallTime::now();
+  std::size_t evaluations = 0;
+  Scalar sum = 0;
+  for (int r=0; r < repetitions; ++r)
+  {
+    for (std::size_t i=0; i < scenarios.size(); ++i)
+    {
+      const Scenario& s = scenarios[i];
+      for (std::size_t k=0; k+2 < s.poses.size(); ++k)
+      {
+        Scalar acc_lin, acc_rot;
+        computeAcceleration(s.poses[k], s.poses[k+1], s.poses[k+2], s.dts[k], s.dts[k+1], acc_lin, acc_rot);
+        sum += acc_lin + acc_rot;
+        ++evaluations;
+      }
+    }
+  }
+  double elapsed = (ros::WallTime::now() - start).toSec();
+  if (!std::isfinite(double(sum)))
+    std::printf("  (non-finite accumulated result)\n");
+  return evaluations ? elapsed / evaluations * 1e9 : 0;
+}
+
+
+int main(int argc, char** argv)
+{
+  std::vector<Scenario> scenarios;
+  if (argc > 1)
+  {
+    if (!loadScenarios(argv[1], scenarios))
+    {
+      std::fprintf(stderr, "Cannot read trajectory file '%s'.\n", argv[1]);
+      return 1;
+    }
+    std::printf("Loaded %lu recorded trajectories from '%s'.\n", (unsigned long) scenarios.size(), argv[1]);
+  }
+  else
+  {
+    generateScenarios(200, 100, scenarios);
+    std::printf("Generated %lu random trajectories.\n", (unsigned long) scenarios.size());
+  }
+  
+  ErrorStatistics vel_stats, omega_stats, acc_lin_stats, acc_rot_stats, jacobian_stats, jacobian_g2o_stats;
+  const double step_float = numericDiffStep<float>();
+  
+  for (std::size_t i=0; i < scenarios.size(); ++i)
+  {
+    const Scenario& s = scenarios[i];
+    for (std::size_t k=0; k+1 < s.poses.size(); ++k)
+    {
+      if (s.dts[k] <= 0)
+        continue;
+      
+      double vel_d, omega_d;
+      float vel_f, omega_f;
+      computeVelocity(s.poses[k], s.poses[k+1], s.dts[k], vel_d, omega_d);
+      computeVelocity(s.poses[k], s.poses[k+1], s.dts[k], vel_f, omega_f);
+      vel_stats.add(vel_f, vel_d);
+      omega_stats.add(omega_f, omega_d);
+      
+      double jac_d = velocityDerivative<double>(s.poses[k], s.poses[k+1], s.dts[k], numericDiffStep<double>());
+      jacobian_stats.add(velocityDerivative<float>(s.poses[k], s.poses[k+1], s.dts[k], step_float), jac_d);
+      jacobian_g2o_stats.add(velocityDerivative<float>(s.poses[k], s.poses[k+1], s.dts[k], numericDiffStep<double>()), jac_d);
+      
+      if (k+2 < s.poses.size() && s.dts[k+1] > 0)
+      {
+        double acc_lin_d, acc_rot_d;
+        float acc_lin_f, acc_rot_f;
+        computeAcceleration(s.poses[k], s.poses[k+1], s.poses[k+2], s.dts[k], s.dts[k+1], acc_lin_d, acc_rot_d);
+        computeAcceleration(s.poses[k], s.poses[k+1], s.poses[k+2], s.dts[k], s.dts[k+1], acc_lin_f, acc_rot_f);
+        acc_lin_stats.add(acc_lin_f, acc_lin_d);
+        acc_rot_stats.add(acc_rot_f, acc_rot_d);
+      }
+    }
+  }
+  
+  std::printf("\nAccuracy of the float kernels w.r.t. double:\n");
+  vel_stats.print("velocity");
+  omega_stats.print("angular velocity");
+  acc_lin_stats.print("acceleration");
+  acc_rot_stats.print("angular acceleration");
+  std::printf("\nAccuracy of the numerical derivative d vel / d x2 in float:\n");
+  jacobian_stats.print("step (float)");
+  jacobian_g2o_stats.print("step 1e-9 (g2o)");
+  
+  std::printf("\nRuntime of the acceleration kernel:\n");
+  std::printf("  double  %.2f ns\n", benchmarkKernels<double>(scenarios, 50));
+  std::printf("  float   %.2f ns\n", benchmarkKernels<float>(scenarios, 50));
+  
+#ifdef TEB_FLOAT_PRECISION
+  std::printf("\nThe planner is compiled with TEB_FLOAT_PRECISION.\n");
+#endif
+  return 0;
+}
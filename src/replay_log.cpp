@@ -0,0 +1,383 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Copyright (c) 2016 LAAS/CNRS
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <teb_local_planner/homotopy_class_planner.h>
+#include <teb_local_planner/obstacle_snapshot.h>
+#include <teb_local_planner/replay_log.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace teb_local_planner {
+
+namespace {
+
+void twistToArray(const geometry_msgs::Twist &twist, double (&values)[6]) {
+  values[0] = twist.linear.x;
+  values[1] = twist.linear.y;
+  values[2] = twist.linear.z;
+  values[3] = twist.angular.x;
+  values[4] = twist.angular.y;
+  values[5] = twist.angular.z;
+}
+
+void arrayToTwist(const double (&values)[6], geometry_msgs::Twist &twist) {
+  twist.linear.x = values[0];
+  twist.linear.y = values[1];
+  twist.linear.z = values[2];
+  twist.angular.x = values[3];
+  twist.angular.y = values[4];
+  twist.angular.z = values[5];
+}
+
+void writePoses(TelemetryRecorder &recorder,
+                const std::vector<geometry_msgs::PoseStamped> &poses) {
+  for (const geometry_msgs::PoseStamped &pose : poses) {
+    ReplayPose replay_pose = {
+        {pose.pose.position.x, pose.pose.position.y, pose.pose.position.z},
+        {pose.pose.orientation.x, pose.pose.orientation.y,
+         pose.pose.orientation.z, pose.pose.orientation.w}};
+    recorder.write(replay_pose);
+  }
+}
+
+void writePoints(TelemetryRecorder &recorder, const ViaPointContainer &points) {
+  for (const Eigen::Vector2d &point : points)
+    recorder.write(point.data(), 2 * sizeof(double));
+}
+
+void writeObstacle(TelemetryRecorder &recorder, const Obstacle &obstacle) {
+  ReplayObstacleHeader header;
+  header.dynamic = obstacle.isDynamic();
+  header.reserved = 0;
+  header.velocity[0] = obstacle.getCentroidVelocity().x();
+  header.velocity[1] = obstacle.getCentroidVelocity().y();
+
+  if (const PointObstacle *point =
+          dynamic_cast<const PointObstacle *>(&obstacle)) {
+    header.type = ObstacleSnapshot::POINT_OBSTACLE;
+    header.no_vertices = 1;
+    recorder.write(header);
+    recorder.write(point->position().data(), 2 * sizeof(double));
+  } else if (const LineObstacle *line =
+                 dynamic_cast<const LineObstacle *>(&obstacle)) {
+    header.type = ObstacleSnapshot::LINE_OBSTACLE;
+    header.no_vertices = 2;
+    recorder.write(header);
+    recorder.write(line->start().data(), 2 * sizeof(double));
+    recorder.write(line->end().data(), 2 * sizeof(double));
+  } else if (const PolygonObstacle *polygon =
+                 dynamic_cast<const PolygonObstacle *>(&obstacle)) {
+    header.type = ObstacleSnapshot::POLYGON_OBSTACLE;
+    header.no_vertices = polygon->noVertices();
+    recorder.write(header);
+    writePoints(recorder, polygon->vertices());
+  } else {
+    // unknown types are replayed as point obstacles at their centroid
+    header.type = ObstacleSnapshot::UNKNOWN_OBSTACLE;
+    header.no_vertices = 1;
+    recorder.write(header);
+    recorder.write(obstacle.getCentroid().data(), 2 * sizeof(double));
+  }
+}
+
+//! Bounds-checked access to the mapped log
+class RecordCursor {
+public:
+  RecordCursor(const char *begin, const char *end) : pos_(begin), end_(end) {}
+
+  template <typename T> bool read(T &value) {
+    if (end_ - pos_ < (std::ptrdiff_t)sizeof(T))
+      return false;
+    std::memcpy(&value, pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  bool readPoses(std::size_t no_poses,
+                 std::vector<geometry_msgs::PoseStamped> &poses) {
+    poses.resize(no_poses);
+    for (geometry_msgs::PoseStamped &pose : poses) {
+      ReplayPose replay_pose;
+      if (!read(replay_pose))
+        return false;
+      pose.pose.position.x = replay_pose.position[0];
+      pose.pose.position.y = replay_pose.position[1];
+      pose.pose.position.z = replay_pose.position[2];
+      pose.pose.orientation.x = replay_pose.orientation[0];
+      pose.pose.orientation.y = replay_pose.orientation[1];
+      pose.pose.orientation.z = replay_pose.orientation[2];
+      pose.pose.orientation.w = replay_pose.orientation[3];
+    }
+    return true;
+  }
+
+  bool readPoints(std::size_t no_points, ViaPointContainer &points) {
+    points.resize(no_points);
+    for (Eigen::Vector2d &point : points) {
+      if (!read(point.x()) || !read(point.y()))
+        return false;
+    }
+    return true;
+  }
+
+private:
+  const char *pos_;
+  const char *end_;
+};
+
+} // namespace
+
+const TimedElasticBand *plannedTrajectory(const PlannerInterface &planner) {
+  if (const TebOptimalPlanner *teb =
+          dynamic_cast<const TebOptimalPlanner *>(&planner))
+    return &teb->teb();
+  if (const HomotopyClassPlanner *hcp =
+          dynamic_cast<const HomotopyClassPlanner *>(&planner)) {
+    TebOptimalPlannerPtr best = hcp->bestTeb();
+    return best ? &best->teb() : NULL;
+  }
+  return NULL;
+}
+
+bool openReplayLog(TelemetryRecorder &recorder, const std::string &filename,
+                   std::size_t buffer_size) {
+  TelemetryFileHeader header;
+  std::memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+  header.version = REPLAY_VERSION;
+  header.header_size = sizeof(ReplayCycleHeader);
+  return recorder.open(filename, header, buffer_size);
+}
+
+bool recordReplayCycle(
+    TelemetryRecorder &recorder, ReplayCycleHeader header,
+    const std::vector<geometry_msgs::PoseStamped> &plan,
+    const geometry_msgs::Twist *start_vel, const HumanPlanVelMap *humans,
+    const ViaPointContainer &via_points,
+    const std::map<uint64_t, ViaPointContainer> &human_via_points,
+    const ObstContainer &obstacles, const PlannerInterface &planner) {
+  const TimedElasticBand *result = plannedTrajectory(planner);
+
+  twistToArray(start_vel ? *start_vel : geometry_msgs::Twist(),
+               header.start_vel);
+
+  header.no_plan_poses = plan.size();
+  header.no_via_points = via_points.size();
+  header.no_humans = humans ? humans->size() : 0;
+  header.no_human_via_points = human_via_points.size();
+  header.no_obstacles = obstacles.size();
+  header.no_result_poses = result ? result->sizePoses() : 0;
+  header.search_expansions = 0;
+  if (const HomotopyClassPlanner *hcp =
+          dynamic_cast<const HomotopyClassPlanner *>(&planner)) {
+    bool cut_off;
+    header.search_expansions = hcp->getSearchExpansions(cut_off);
+    if (cut_off)
+      header.flags |= REPLAY_SEARCH_CUT_OFF;
+  }
+  recorder.beginRecord(header);
+
+  writePoses(recorder, plan);
+  writePoints(recorder, via_points);
+
+  if (humans) {
+    for (const auto &human_kv : *humans) {
+      ReplayHumanHeader human;
+      human.id = human_kv.first;
+      human.no_poses = human_kv.second.plan.size();
+      human.reserved = 0;
+      twistToArray(human_kv.second.start_vel, human.start_vel);
+      twistToArray(human_kv.second.goal_vel, human.goal_vel);
+      recorder.write(human);
+      writePoses(recorder, human_kv.second.plan);
+    }
+  }
+
+  for (const auto &via_points_kv : human_via_points) {
+    ReplayViaPointsHeader via_points_header;
+    via_points_header.id = via_points_kv.first;
+    via_points_header.no_via_points = via_points_kv.second.size();
+    via_points_header.reserved = 0;
+    recorder.write(via_points_header);
+    writePoints(recorder, via_points_kv.second);
+  }
+
+  for (const ObstaclePtr &obstacle : obstacles)
+    writeObstacle(recorder, *obstacle);
+
+  for (unsigned int i = 0; i < header.no_result_poses; ++i) {
+    TelemetryPose pose;
+    pose.x = result->Pose(i).x();
+    pose.y = result->Pose(i).y();
+    pose.theta = result->Pose(i).theta();
+    pose.dt = i < result->sizeTimeDiffs() ? result->TimeDiff(i) : 0.0;
+    recorder.write(pose);
+  }
+
+  return recorder.commitRecord();
+}
+
+ReplayLogReader::ReplayLogReader()
+    : data_(NULL), size_(0), pos_(0), truncated_(false) {}
+
+ReplayLogReader::~ReplayLogReader() { close(); }
+
+bool ReplayLogReader::open(const std::string &filename) {
+  close();
+
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(TelemetryFileHeader)) {
+    ::close(fd);
+    return false;
+  }
+  void *mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED)
+    return false;
+  data_ = static_cast<const char *>(mapped);
+  size_ = st.st_size;
+
+  TelemetryFileHeader header;
+  std::memcpy(&header, data_, sizeof(header));
+  if (std::memcmp(header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0 ||
+      header.version != REPLAY_VERSION ||
+      header.header_size != sizeof(ReplayCycleHeader)) {
+    close();
+    return false;
+  }
+  pos_ = sizeof(header);
+  truncated_ = false;
+  return true;
+}
+
+void ReplayLogReader::close() {
+  if (data_)
+    munmap(const_cast<char *>(data_), size_);
+  data_ = NULL;
+  size_ = 0;
+  pos_ = 0;
+}
+
+bool ReplayLogReader::next(ReplayCycle &cycle) {
+  if (!data_ || pos_ >= size_)
+    return false;
+
+  RecordCursor cursor(data_ + pos_, data_ + size_);
+  if (!cursor.read(cycle.header) ||
+      cycle.header.record.size < sizeof(ReplayCycleHeader) ||
+      cycle.header.record.size > size_ - pos_) {
+    truncated_ = true; // e.g. the planner has been killed while writing
+    return false;
+  }
+  const ReplayCycleHeader &header = cycle.header;
+  cursor = RecordCursor(data_ + pos_ + sizeof(header),
+                        data_ + pos_ + header.record.size);
+  pos_ += header.record.size;
+
+  arrayToTwist(header.start_vel, cycle.start_vel);
+  bool valid = cursor.readPoses(header.no_plan_poses, cycle.plan) &&
+               cursor.readPoints(header.no_via_points, cycle.via_points);
+
+  cycle.humans.clear();
+  for (unsigned int i = 0; valid && i < header.no_humans; ++i) {
+    ReplayHumanHeader human;
+    valid = cursor.read(human);
+    if (!valid)
+      break;
+    PlanStartVelGoalVel &plan = cycle.humans[human.id];
+    arrayToTwist(human.start_vel, plan.start_vel);
+    arrayToTwist(human.goal_vel, plan.goal_vel);
+    valid = cursor.readPoses(human.no_poses, plan.plan);
+  }
+
+  cycle.human_via_points.clear();
+  for (unsigned int i = 0; valid && i < header.no_human_via_points; ++i) {
+    ReplayViaPointsHeader via_points;
+    valid = cursor.read(via_points) &&
+            cursor.readPoints(via_points.no_via_points,
+                              cycle.human_via_points[via_points.id]);
+  }
+
+  cycle.obstacles.clear();
+  for (unsigned int i = 0; valid && i < header.no_obstacles; ++i) {
+    ReplayObstacleHeader obstacle;
+    Point2dContainer vertices;
+    valid = cursor.read(obstacle) &&
+            cursor.readPoints(obstacle.no_vertices, vertices) &&
+            !vertices.empty();
+    if (!valid)
+      break;
+
+    ObstaclePtr replay_obstacle;
+    if (obstacle.type == ObstacleSnapshot::LINE_OBSTACLE &&
+        vertices.size() == 2) {
+      replay_obstacle.reset(new LineObstacle(vertices[0], vertices[1]));
+    } else if (obstacle.type == ObstacleSnapshot::POLYGON_OBSTACLE) {
+      PolygonObstacle *polygon = new PolygonObstacle;
+      for (const Eigen::Vector2d &vertex : vertices)
+        polygon->pushBackVertex(vertex);
+      polygon->finalizePolygon();
+      replay_obstacle.reset(polygon);
+    } else {
+      replay_obstacle.reset(new PointObstacle(vertices.front()));
+    }
+    if (obstacle.dynamic)
+      replay_obstacle->setCentroidVelocity(
+          Eigen::Vector2d(obstacle.velocity[0], obstacle.velocity[1]));
+    cycle.obstacles.push_back(replay_obstacle);
+  }
+
+  cycle.result.resize(valid ? header.no_result_poses : 0);
+  for (TelemetryPose &pose : cycle.result) {
+    if (!(valid = cursor.read(pose)))
+      break;
+  }
+
+  if (!valid)
+    ROS_WARN("ReplayLogReader: record %lu is inconsistent.",
+             (unsigned long)header.record.cycle);
+  return true;
+}
+
+} // namespace teb_local_planner
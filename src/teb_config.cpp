@@ -48,11 +48,17 @@ void TebConfig::loadRosParamFromNodeHandle(const ros::NodeHandle &nh) {
 
   nh.param("odom_topic", odom_topic, odom_topic);
   nh.param("map_frame", map_frame, map_frame);
+  nh.param("telemetry_file", telemetry_file, telemetry_file);
+  nh.param("telemetry_buffer_size", telemetry_buffer_size,
+           telemetry_buffer_size);
+  nh.param("replay_file", replay_file, replay_file);
 
   nh.param("planning_mode", planning_mode, planning_mode);
 
   // Trajectory
   nh.param("teb_autosize", trajectory.teb_autosize, trajectory.teb_autosize);
+  nh.param("teb_autosize_resample", trajectory.teb_autosize_resample,
+           trajectory.teb_autosize_resample);
   nh.param("dt_ref", trajectory.dt_ref, trajectory.dt_ref);
   nh.param("dt_hysteresis", trajectory.dt_hysteresis, trajectory.dt_hysteresis);
   nh.param("min_samples", trajectory.min_samples, trajectory.min_samples);
@@ -118,6 +124,10 @@ void TebConfig::loadRosParamFromNodeHandle(const ros::NodeHandle &nh) {
   nh.param("ttc_threshold", human.ttc_threshold, human.ttc_threshold);
   nh.param("human_pose_prediction_reset_time", human.pose_prediction_reset_time,
            human.pose_prediction_reset_time);
+  nh.param("human_lod_distance", human.lod_distance, human.lod_distance);
+  nh.param("human_lod_time_horizon", human.lod_time_horizon,
+           human.lod_time_horizon);
+  nh.param("human_lod_mode", human.lod_mode, human.lod_mode);
 
   // GoalTolerance
   nh.param("xy_goal_tolerance", goal_tolerance.xy_goal_tolerance,
@@ -143,6 +153,8 @@ void TebConfig::loadRosParamFromNodeHandle(const ros::NodeHandle &nh) {
            obstacles.costmap_obstacles_behind_robot_dist);
   nh.param("obstacle_poses_affected", obstacles.obstacle_poses_affected,
            obstacles.obstacle_poses_affected);
+  nh.param("dynamic_obstacle_dt_window", obstacles.dynamic_obstacle_dt_window,
+           obstacles.dynamic_obstacle_dt_window);
   nh.param("costmap_converter_plugin", obstacles.costmap_converter_plugin,
            obstacles.costmap_converter_plugin);
   nh.param("costmap_converter_spin_thread",
@@ -158,6 +170,7 @@ void TebConfig::loadRosParamFromNodeHandle(const ros::NodeHandle &nh) {
            optim.optimization_activate);
   nh.param("optimization_verbose", optim.optimization_verbose,
            optim.optimization_verbose);
+  nh.param("edge_threads", optim.edge_threads, optim.edge_threads);
   nh.param("penalty_epsilon", optim.penalty_epsilon, optim.penalty_epsilon);
   nh.param("time_penalty_epsilon", optim.time_penalty_epsilon,
            optim.time_penalty_epsilon);
@@ -225,6 +238,14 @@ void TebConfig::loadRosParamFromNodeHandle(const ros::NodeHandle &nh) {
            optim.disable_rapid_omega_chage);
   nh.param("omega_chage_time_seperation", optim.omega_chage_time_seperation,
            optim.omega_chage_time_seperation);
+  nh.param("human_pre_optimization", optim.human_pre_optimization,
+           optim.human_pre_optimization);
+  nh.param("sparse_human_coupling", optim.sparse_human_coupling,
+           optim.sparse_human_coupling);
+  nh.param("human_coupling_window", optim.human_coupling_window,
+           optim.human_coupling_window);
+  nh.param("human_coupling_margin", optim.human_coupling_margin,
+           optim.human_coupling_margin);
 
   // Homotopy Class Planner
   nh.param("enable_homotopy_class_planning", hcp.enable_homotopy_class_planning,
@@ -244,10 +265,14 @@ void TebConfig::loadRosParamFromNodeHandle(const ros::NodeHandle &nh) {
   nh.param("selection_alternative_time_cost",
            hcp.selection_alternative_time_cost,
            hcp.selection_alternative_time_cost);
+  nh.param("selection_early_abort", hcp.selection_early_abort,
+           hcp.selection_early_abort);
   nh.param("roadmap_graph_samples", hcp.roadmap_graph_no_samples,
            hcp.roadmap_graph_no_samples);
   nh.param("roadmap_graph_area_width", hcp.roadmap_graph_area_width,
            hcp.roadmap_graph_area_width);
+  nh.param("roadmap_graph_search_time", hcp.roadmap_graph_search_time,
+           hcp.roadmap_graph_search_time);
   nh.param("h_signature_prescaler", hcp.h_signature_prescaler,
            hcp.h_signature_prescaler);
   nh.param("h_signature_threshold", hcp.h_signature_threshold,
@@ -304,6 +329,7 @@ void TebConfig::reconfigure(TebLocalPlannerReconfigureConfig &cfg) {
 
   // Trajectory
   trajectory.teb_autosize = cfg.teb_autosize;
+  trajectory.teb_autosize_resample = cfg.teb_autosize_resample;
   trajectory.dt_ref = cfg.dt_ref;
   trajectory.dt_hysteresis = cfg.dt_hysteresis;
   trajectory.global_plan_overwrite_orientation =
@@ -345,6 +371,9 @@ void TebConfig::reconfigure(TebLocalPlannerReconfigureConfig &cfg) {
   human.predict_human_behind_robot = cfg.predict_human_behind_robot;
   human.ttc_threshold = cfg.ttc_threshold;
   human.pose_prediction_reset_time = cfg.human_pose_prediction_reset_time;
+  human.lod_distance = cfg.human_lod_distance;
+  human.lod_time_horizon = cfg.human_lod_time_horizon;
+  human.lod_mode = cfg.human_lod_mode;
 
   // GoalTolerance
   goal_tolerance.xy_goal_tolerance = cfg.xy_goal_tolerance;
@@ -359,12 +388,14 @@ void TebConfig::reconfigure(TebLocalPlannerReconfigureConfig &cfg) {
   obstacles.costmap_obstacles_behind_robot_dist =
       cfg.costmap_obstacles_behind_robot_dist;
   obstacles.obstacle_poses_affected = cfg.obstacle_poses_affected;
+  obstacles.dynamic_obstacle_dt_window = cfg.dynamic_obstacle_dt_window;
 
   // Optimization
   optim.no_inner_iterations = cfg.no_inner_iterations;
   optim.no_outer_iterations = cfg.no_outer_iterations;
   optim.optimization_activate = cfg.optimization_activate;
   optim.optimization_verbose = cfg.optimization_verbose;
+  optim.edge_threads = cfg.edge_threads;
   optim.penalty_epsilon = cfg.penalty_epsilon;
   optim.time_penalty_epsilon = cfg.time_penalty_epsilon;
   optim.cap_optimaltime_penalty = cfg.cap_optimaltime_penalty;
@@ -400,6 +431,10 @@ void TebConfig::reconfigure(TebLocalPlannerReconfigureConfig &cfg) {
   optim.disable_warm_start = cfg.disable_warm_start;
   optim.disable_rapid_omega_chage = cfg.disable_rapid_omega_chage;
   optim.omega_chage_time_seperation = cfg.omega_chage_time_seperation;
+  optim.human_pre_optimization = cfg.human_pre_optimization;
+  optim.sparse_human_coupling = cfg.sparse_human_coupling;
+  optim.human_coupling_window = cfg.human_coupling_window;
+  optim.human_coupling_margin = cfg.human_coupling_margin;
 
   // Homotopy Class Planner
   hcp.enable_multithreading = cfg.enable_multithreading;
@@ -409,11 +444,13 @@ void TebConfig::reconfigure(TebLocalPlannerReconfigureConfig &cfg) {
   hcp.selection_obst_cost_scale = cfg.selection_obst_cost_scale;
   hcp.selection_viapoint_cost_scale = cfg.selection_viapoint_cost_scale;
   hcp.selection_alternative_time_cost = cfg.selection_alternative_time_cost;
+  hcp.selection_early_abort = cfg.selection_early_abort;
 
   hcp.obstacle_keypoint_offset = cfg.obstacle_keypoint_offset;
   hcp.obstacle_heading_threshold = cfg.obstacle_heading_threshold;
   hcp.roadmap_graph_no_samples = cfg.roadmap_graph_no_samples;
   hcp.roadmap_graph_area_width = cfg.roadmap_graph_area_width;
+  hcp.roadmap_graph_search_time = cfg.roadmap_graph_search_time;
   hcp.h_signature_prescaler = cfg.h_signature_prescaler;
   hcp.h_signature_threshold = cfg.h_signature_threshold;
   hcp.viapoints_all_candidates = cfg.viapoints_all_candidates;
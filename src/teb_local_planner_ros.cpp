@@ -79,7 +79,7 @@ TebLocalPlannerROS::TebLocalPlannerROS()
       costmap_converter_loader_("costmap_converter",
                                 "costmap_converter::BaseCostmapToPolygons"),
       dynamic_recfg_(NULL), goal_reached_(false), horizon_reduced_(false),
-      initialized_(false) {}
+      planner_cleared_(true), initialized_(false) {}
 
 TebLocalPlannerROS::~TebLocalPlannerROS() {}
 
@@ -118,8 +118,11 @@ void TebLocalPlannerROS::initialize(std::string name, tf::TransformListener *tf,
 
     // create the planner instance
     if (cfg_.hcp.enable_homotopy_class_planning) {
-      planner_ = PlannerInterfacePtr(new HomotopyClassPlanner(
-          cfg_, &obstacles_, robot_model, visualization_, &via_points_));
+      HomotopyClassPlanner *hcp = new HomotopyClassPlanner(
+          cfg_, &obstacles_, robot_model, visualization_, &via_points_);
+      // fixed seed: the roadmap sampling is reproduced by teb_replay
+      hcp->seedRandomGenerator(REPLAY_RANDOM_SEED);
+      planner_ = PlannerInterfacePtr(hcp);
       ROS_INFO("Parallel planning in distinctive topologies enabled.");
     } else {
       planner_ = PlannerInterfacePtr(new TebOptimalPlanner(
@@ -129,6 +132,34 @@ void TebLocalPlannerROS::initialize(std::string name, tf::TransformListener *tf,
       ROS_INFO("Parallel planning in distinctive topologies disabled.");
     }
 
+    // record all planning cycles if desired
+    if (!cfg_.telemetry_file.empty()) {
+      telemetry_ = boost::make_shared<TelemetryRecorder>();
+      if (telemetry_->open(cfg_.telemetry_file,
+                           std::max(cfg_.telemetry_buffer_size, 64) * 1024)) {
+        planner_->setTelemetryRecorder(telemetry_);
+        ROS_INFO("Recording telemetry to '%s'.", cfg_.telemetry_file.c_str());
+      } else {
+        ROS_WARN("Cannot open telemetry file '%s'. Recording disabled.",
+                 cfg_.telemetry_file.c_str());
+        telemetry_.reset();
+      }
+    }
+
+    // record all planner inputs for teb_replay if desired
+    if (!cfg_.replay_file.empty()) {
+      replay_log_ = boost::make_shared<TelemetryRecorder>();
+      if (openReplayLog(*replay_log_, cfg_.replay_file,
+                        std::max(cfg_.telemetry_buffer_size, 64) * 1024)) {
+        ROS_INFO("Recording planner inputs to '%s'.",
+                 cfg_.replay_file.c_str());
+      } else {
+        ROS_WARN("Cannot open replay file '%s'. Recording disabled.",
+                 cfg_.replay_file.c_str());
+        replay_log_.reset();
+      }
+    }
+
     // init other variables
     tf_ = tf;
     costmap_ros_ = costmap_ros;
@@ -594,18 +625,56 @@ bool TebLocalPlannerROS::computeVelocityCommands(
   auto plan_start_time = ros::Time::now();
   // bool success = planner_->plan(robot_pose_, robot_goal_, robot_vel_,
   // cfg_.goal_tolerance.free_goal_vel); // straight line init
+  double weight_optimaltime = planner_->local_weight_optimaltime_;
   bool success = planner_->plan(transformed_plan, &robot_vel_twist,
                                 cfg_.goal_tolerance.free_goal_vel,
                                 &transformed_human_plan_vel_map);
+  auto plan_time = ros::Time::now() - plan_start_time;
+  if (replay_log_) {
+    ReplayCycleHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.stamp = start_time.toSec();
+    header.weight_optimaltime = weight_optimaltime;
+    header.plan_time = plan_time.toSec();
+    header.flags = (cfg_.goal_tolerance.free_goal_vel ? REPLAY_FREE_GOAL_VEL
+                                                      : 0) |
+                   (success ? REPLAY_SUCCESS : 0) |
+                   (planner_cleared_ ? REPLAY_CLEARED : 0);
+    header.random_seed = REPLAY_RANDOM_SEED;
+    recordReplayCycle(*replay_log_, header, transformed_plan, &robot_vel_twist,
+                      &transformed_human_plan_vel_map, via_points_,
+                      humans_via_points_map_, obstacles_, *planner_);
+    planner_cleared_ = false;
+  }
   if (!success) {
-    planner_->clearPlanner(); // force reinitialization for next time
+    resetPlanner(); // force reinitialization for next time
     ROS_WARN("teb_local_planner was not able to obtain a local plan for the "
              "current setting.");
     return false;
   }
-  auto plan_time = ros::Time::now() - plan_start_time;
 
-  // Now visualize everything
+  // Undo temporary horizon reduction
+  auto hr2_start_time = ros::Time::now();
+  if (horizon_reduced_ &&
+      (ros::Time::now() - horizon_reduced_stamp_).toSec() >= 5 &&
+      !planner_->isHorizonReductionAppropriate(
+          transformed_plan)) // 10s are hardcoded for now...
+  {
+    horizon_reduced_ = false;
+    planner_->local_weight_optimaltime_ = cfg_.optim.weight_optimaltime;
+    ROS_INFO("Switching back to full horizon length.");
+  }
+  auto hr2_time = ros::Time::now() - hr2_start_time;
+
+  // Check feasibility (but within the first few states only), this might
+  // select another candidate
+  auto fsb_start_time = ros::Time::now();
+  bool feasible = planner_->isTrajectoryFeasible(
+      costmap_model_.get(), footprint_spec_, robot_inscribed_radius_,
+      robot_circumscribed_radius, cfg_.trajectory.feasibility_check_no_poses);
+  auto fsb_time = ros::Time::now() - fsb_start_time;
+
+  // Now visualize everything (the trajectory is selected at this point)
   auto viz_start_time = ros::Time::now();
   planner_->visualize();
   visualization_->publishObstacles(obstacles_);
@@ -614,6 +683,7 @@ bool TebLocalPlannerROS::computeVelocityCommands(
   if (cfg_.planning_mode == 1) {
     visualization_->publishHumansPlans(transformed_human_plans);
     std::vector<HumanPlanTrajCombined> human_plans_traj_array;
+    human_plans_traj_array.reserve(transformed_human_plans.size());
     for (auto &human_plan_combined : transformed_human_plans) {
       HumanPlanTrajCombined human_plan_traj_combined;
       human_plan_traj_combined.id = human_plan_combined.id;
@@ -622,30 +692,12 @@ bool TebLocalPlannerROS::computeVelocityCommands(
           human_plan_traj_combined.id,
           human_plan_traj_combined.optimized_trajectory);
       human_plan_traj_combined.plan_after = human_plan_combined.plan_after;
-      human_plans_traj_array.push_back(human_plan_traj_combined);
+      human_plans_traj_array.push_back(std::move(human_plan_traj_combined));
     }
     visualization_->publishHumanTrajectories(human_plans_traj_array);
   }
   auto viz_time = ros::Time::now() - viz_start_time;
 
-  // Undo temporary horizon reduction
-  auto hr2_start_time = ros::Time::now();
-  if (horizon_reduced_ &&
-      (ros::Time::now() - horizon_reduced_stamp_).toSec() >= 5 &&
-      !planner_->isHorizonReductionAppropriate(
-          transformed_plan)) // 10s are hardcoded for now...
-  {
-    horizon_reduced_ = false;
-    planner_->local_weight_optimaltime_ = cfg_.optim.weight_optimaltime;
-    ROS_INFO("Switching back to full horizon length.");
-  }
-  auto hr2_time = ros::Time::now() - hr2_start_time;
-
-  // Check feasibility (but within the first few states only)
-  auto fsb_start_time = ros::Time::now();
-  bool feasible = planner_->isTrajectoryFeasible(
-      costmap_model_.get(), footprint_spec_, robot_inscribed_radius_,
-      robot_circumscribed_radius, cfg_.trajectory.feasibility_check_no_poses);
   if (!feasible) {
     cmd_vel.linear.x = 0;
     cmd_vel.angular.z = 0;
@@ -662,18 +714,17 @@ bool TebLocalPlannerROS::computeVelocityCommands(
     }
     // now we reset everything to start again with the initialization of new
     // trajectories.
-    planner_->clearPlanner();
+    resetPlanner();
     ROS_WARN("TebLocalPlannerROS: trajectory is not feasible. Resetting "
              "planner...");
 
     return false;
   }
-  auto fsb_time = ros::Time::now() - fsb_start_time;
 
   // Get the velocity command for this sampling interval
   auto vel_start_time = ros::Time::now();
   if (!planner_->getVelocityCommand(cmd_vel.linear.x, cmd_vel.angular.z)) {
-    planner_->clearPlanner();
+    resetPlanner();
     ROS_WARN(
         "TebLocalPlannerROS: velocity command invalid. Resetting planner...");
     return false;
@@ -697,7 +748,7 @@ bool TebLocalPlannerROS::computeVelocityCommands(
         0.95 * cfg_.robot.min_turning_radius);
     if (!std::isfinite(cmd_vel.angular.z)) {
       cmd_vel.linear.x = cmd_vel.angular.z = 0;
-      planner_->clearPlanner();
+      resetPlanner();
       ROS_WARN("TebLocalPlannerROS: Resulting steering angle is not finite. "
                "Resetting planner...");
       return false;
@@ -743,7 +794,7 @@ bool TebLocalPlannerROS::computeVelocityCommands(
 bool TebLocalPlannerROS::isGoalReached() {
   if (goal_reached_) {
     ROS_INFO("GOAL Reached!");
-    planner_->clearPlanner();
+    resetPlanner();
     resetHumansPrediction();
     return true;
   }
@@ -1593,6 +1644,11 @@ TebLocalPlannerROS::getNumberFromXMLRPC(XmlRpc::XmlRpcValue &value,
                                                          : (double)(value);
 }
 
+void TebLocalPlannerROS::resetPlanner() {
+  planner_->clearPlanner();
+  planner_cleared_ = true;
+}
+
 void TebLocalPlannerROS::resetHumansPrediction() {
   std_srvs::Empty empty_service;
   ROS_INFO("Resetting human pose prediction");
@@ -1733,7 +1789,7 @@ bool TebLocalPlannerROS::optimizeStandalone(
                                 cfg_.goal_tolerance.free_goal_vel,
                                 &transformed_human_plan_vel_map);
   if (!success) {
-    planner_->clearPlanner();
+    resetPlanner();
     res.success = false;
     res.message =
         "planner was not able to obtain a local plan for the current setting";
@@ -1741,7 +1797,21 @@ bool TebLocalPlannerROS::optimizeStandalone(
   }
   auto plan_time = ros::Time::now() - plan_start_time;
 
-  // now visualize everything
+  res.success = true;
+  res.message = "planning successful";
+  geometry_msgs::Twist cmd_vel;
+
+  // check feasibility of robot plan
+  auto fsb_start_time = ros::Time::now();
+  bool feasible = planner_->isTrajectoryFeasible(
+      costmap_model_.get(), footprint_spec_, robot_inscribed_radius_,
+      robot_circumscribed_radius, cfg_.trajectory.feasibility_check_no_poses);
+  if (!feasible) {
+    res.message += "\nhowever, trajectory is not feasible";
+  }
+  auto fsb_time = ros::Time::now() - fsb_start_time;
+
+  // now visualize everything (the trajectory is selected at this point)
   auto viz_start_time = ros::Time::now();
   planner_->visualize();
   visualization_->publishObstacles(obstacles_);
@@ -1749,6 +1819,7 @@ bool TebLocalPlannerROS::optimizeStandalone(
   visualization_->publishGlobalPlan(global_plan_);
   visualization_->publishHumansPlans(transformed_human_plans);
   std::vector<HumanPlanTrajCombined> human_plans_traj_array;
+  human_plans_traj_array.reserve(transformed_human_plans.size());
   for (auto &human_plan_combined : transformed_human_plans) {
     HumanPlanTrajCombined human_plan_traj_combined;
     human_plan_traj_combined.id = human_plan_combined.id;
@@ -1757,25 +1828,11 @@ bool TebLocalPlannerROS::optimizeStandalone(
         human_plan_traj_combined.id,
         human_plan_traj_combined.optimized_trajectory);
     human_plan_traj_combined.plan_after = human_plan_combined.plan_after;
-    human_plans_traj_array.push_back(human_plan_traj_combined);
+    human_plans_traj_array.push_back(std::move(human_plan_traj_combined));
   }
   visualization_->publishHumanTrajectories(human_plans_traj_array);
   auto viz_time = ros::Time::now() - viz_start_time;
 
-  res.success = true;
-  res.message = "planning successful";
-  geometry_msgs::Twist cmd_vel;
-
-  // check feasibility of robot plan
-  auto fsb_start_time = ros::Time::now();
-  bool feasible = planner_->isTrajectoryFeasible(
-      costmap_model_.get(), footprint_spec_, robot_inscribed_radius_,
-      robot_circumscribed_radius, cfg_.trajectory.feasibility_check_no_poses);
-  if (!feasible) {
-    res.message += "\nhowever, trajectory is not feasible";
-  }
-  auto fsb_time = ros::Time::now() - fsb_start_time;
-
   // get the velocity command for this sampling interval
   auto vel_start_time = ros::Time::now();
   if (!planner_->getVelocityCommand(cmd_vel.linear.x, cmd_vel.angular.z)) {
@@ -1784,7 +1841,7 @@ bool TebLocalPlannerROS::optimizeStandalone(
   }
 
   // clear the planner only after getting the velocity command
-  planner_->clearPlanner();
+  resetPlanner();
 
   // saturate velocity
   saturateVelocity(cmd_vel.linear.x, cmd_vel.angular.z, cfg_.robot.max_vel_x,
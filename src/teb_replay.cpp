@@ -0,0 +1,261 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************/
+
+#include <teb_local_planner/teb_local_planner_ros.h>
+#include <teb_local_planner/replay_log.h>
+
+#include <boost/make_shared.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+
+using namespace teb_local_planner; // it is ok here to import everything for this tool
+
+// Replays a log recorded by TebLocalPlannerROS (parameter ~replay_file) as fast as possible.
+// The planner is configured from the private namespace of this node (load the same parameters as on the robot),
+// fed with the recorded inputs of each cycle and its trajectory is compared with the recorded one.
+//
+// Usage: rosrun teb_local_planner teb_replay <replay_log> [<profile.csv>]
+// The optional profile contains the recorded and replayed durations of plan() per cycle for regression comparisons.
+// Set ~telemetry_file to record the telemetry (timings per phase, costs) of the replay as well.
+//
+// The cost of the recorded and of the replayed trajectory is evaluated with the same (robot only) graph in each cycle.
+// Record the log with the default build and replay it with a build configured with TEB_FLOAT_PRECISION
+// to compare the trajectories and costs of the mixed-precision mode with the double precision planner.
+
+
+//! Largest difference between the replayed and the recorded trajectory (infinite if the number of poses differs)
+double compareTrajectory(const TimedElasticBand* teb, const std::vector<TelemetryPose>& recorded, bool& exact)
+{
+  unsigned int no_poses = teb ? teb->sizePoses() : 0;
+  exact = no_poses == recorded.size();
+  if (!exact)
+    return std::numeric_limits<double>::infinity();
+  
+  double deviation = 0;
+  for (unsigned int i=0; i < no_poses; ++i)
+  {
+    double dt = i < teb->sizeTimeDiffs() ? teb->TimeDiff(i) : 0.0;
+    exact = exact && teb->Pose(i).x() == recorded[i].x && teb->Pose(i).y() == recorded[i].y
+                  && teb->Pose(i).theta() == recorded[i].theta && dt == recorded[i].dt;
+    deviation = std::max(deviation, (teb->Pose(i).position() - Eigen::Vector2d(recorded[i].x, recorded[i].y)).norm());
+    deviation = std::max(deviation, std::abs(g2o::normalize_theta(teb->Pose(i).theta() - recorded[i].theta)));
+    deviation = std::max(deviation, std::abs(dt - recorded[i].dt));
+  }
+  return deviation;
+}
+
+
+//! Cost of a trajectory evaluated with the graph of the planner \c evaluator (NaN for less than two poses)
+double evaluateCost(TebOptimalPlanner& evaluator, const std::vector<TelemetryPose>& poses)
+{
+  if (poses.size() < 2)
+    return std::numeric_limits<double>::quiet_NaN();
+  
+  TimedElasticBand& teb = evaluator.teb();
+  teb.clearTimedElasticBand();
+  for (unsigned int i=0; i < poses.size(); ++i)
+  {
+    teb.addPose(poses[i].x, poses[i].y, poses[i].theta, i == 0 || i+1 == poses.size());
+    if (i+1 < poses.size())
+      teb.addTimeDiff(poses[i].dt);
+  }
+  evaluator.computeCurrentCost();
+  return evaluator.getCurrentCost();
+}
+
+
+//! Poses of a trajectory in the layout of the replay log
+void trajectoryPoses(const TimedElasticBand* teb, std::vector<TelemetryPose>& poses)
+{
+  poses.clear();
+  for (unsigned int i=0; teb && i < teb->sizePoses(); ++i)
+  {
+    TelemetryPose pose;
+    pose.x = teb->Pose(i).x();
+    pose.y = teb->Pose(i).y();
+    pose.theta = teb->Pose(i).theta();
+    pose.dt = i < teb->sizeTimeDiffs() ? teb->TimeDiff(i) : 0.0;
+    poses.push_back(pose);
+  }
+}
+
+
+int main( int argc, char** argv )
+{
+  ros::init(argc, argv, "teb_replay");
+  ros::NodeHandle n("~");
+  
+  if (argc < 2)
+  {
+    ROS_ERROR("Usage: teb_replay <replay_log> [<profile.csv>]");
+    return 1;
+  }
+  
+  ReplayLogReader reader;
+  if (!reader.open(argv[1]))
+  {
+    ROS_ERROR("Cannot read replay log '%s' (version %u).", argv[1], REPLAY_VERSION);
+    return 1;
+  }
+  
+  std::FILE* profile = NULL;
+  if (argc > 2)
+  {
+    profile = std::fopen(argv[2], "w");
+    if (!profile)
+    {
+      ROS_ERROR("Cannot write profile '%s'.", argv[2]);
+      return 1;
+    }
+    std::fprintf(profile, "cycle,stamp,recorded_plan_time,replay_plan_time,recorded_success,replay_success,poses,max_deviation,exact,recorded_cost,replay_cost\n");
+  }
+  
+  // load ros parameters from node handle
+  TebConfig config;
+  config.loadRosParamFromNodeHandle(n);
+  // inputs of the planner (updated every cycle)
+  ObstContainer obstacles;
+  ViaPointContainer via_points;
+  std::map<uint64_t, ViaPointContainer> humans_via_points_map;
+  
+  // Setup the planner as in TebLocalPlannerROS::initialize() (without visualization)
+  RobotFootprintModelPtr robot_model = TebLocalPlannerROS::getRobotFootprintFromParamServer(n);
+  CircularRobotFootprintPtr human_model = boost::make_shared<CircularRobotFootprint>(std::max(config.human.radius, 0.0));
+  PlannerInterfacePtr planner;
+  HomotopyClassPlanner* hcp = NULL;
+  if (config.hcp.enable_homotopy_class_planning)
+  {
+    hcp = new HomotopyClassPlanner(config, &obstacles, robot_model, TebVisualizationPtr(), &via_points);
+    planner = PlannerInterfacePtr(hcp);
+  }
+  else
+    planner = PlannerInterfacePtr(new TebOptimalPlanner(config, &obstacles, robot_model, TebVisualizationPtr(), &via_points,
+                                                        human_model, &humans_via_points_map));
+  
+  // evaluates the cost of the recorded and the replayed trajectories
+  ObstacleSnapshot snapshot;
+  TebOptimalPlanner evaluator(config, &obstacles, robot_model, TebVisualizationPtr(), &via_points);
+  evaluator.setObstacleSnapshot(&snapshot);
+  
+  TelemetryRecorderPtr telemetry;
+  if (!config.telemetry_file.empty())
+  {
+    telemetry = boost::make_shared<TelemetryRecorder>();
+    if (telemetry->open(config.telemetry_file, std::max(config.telemetry_buffer_size, 64) * 1024))
+      planner->setTelemetryRecorder(telemetry);
+    else
+      ROS_WARN("Cannot open telemetry file '%s'.", config.telemetry_file.c_str());
+  }
+  
+  ReplayCycle cycle;
+  unsigned long no_cycles = 0, no_exact = 0, no_gaps = 0;
+  double recorded_time = 0, replay_time = 0, max_deviation = 0;
+  double recorded_cost_sum = 0, replay_cost_sum = 0, max_cost_deviation = 0;
+  std::vector<TelemetryPose> replay_poses;
+  while (reader.next(cycle))
+  {
+    const ReplayCycleHeader& header = cycle.header;
+    if (hcp && no_cycles == 0)
+      hcp->seedRandomGenerator(header.random_seed);
+    if (header.record.dropped > 0)
+    {
+      ROS_WARN("Replay: %u records dropped before cycle %lu, the following cycles are not reproduced exactly.",
+               header.record.dropped, (unsigned long) header.record.cycle);
+      ++no_gaps;
+    }
+    
+    obstacles.swap(cycle.obstacles);
+    via_points.swap(cycle.via_points);
+    humans_via_points_map.swap(cycle.human_via_points);
+    if (header.flags & REPLAY_CLEARED)
+      planner->clearPlanner();
+    planner->local_weight_optimaltime_ = header.weight_optimaltime;
+    // cut the roadmap search off after the recorded number of expansions instead of the machine dependent time budget
+    if (hcp)
+      hcp->limitSearchExpansions(header.flags & REPLAY_SEARCH_CUT_OFF ? header.search_expansions
+                                                                      : std::numeric_limits<unsigned long>::max());
+    
+    ros::WallTime start_time = ros::WallTime::now();
+    bool success = planner->plan(cycle.plan, &cycle.start_vel, header.flags & REPLAY_FREE_GOAL_VEL, &cycle.humans);
+    double plan_time = (ros::WallTime::now() - start_time).toSec();
+    
+    bool exact;
+    double deviation = compareTrajectory(plannedTrajectory(*planner), cycle.result, exact);
+    exact = exact && success == bool(header.flags & REPLAY_SUCCESS);
+    
+    snapshot.build(&obstacles);
+    evaluator.setVelocityStart(cycle.start_vel);
+    if (header.flags & REPLAY_FREE_GOAL_VEL)
+      evaluator.setVelocityGoalFree();
+    else
+      evaluator.setVelocityGoal(Eigen::Vector2d::Zero());
+    trajectoryPoses(plannedTrajectory(*planner), replay_poses);
+    double recorded_cost = evaluateCost(evaluator, cycle.result);
+    double replay_cost = evaluateCost(evaluator, replay_poses);
+    if (std::isfinite(recorded_cost) && std::isfinite(replay_cost))
+    {
+      max_cost_deviation = std::max(max_cost_deviation, std::abs(replay_cost - recorded_cost) / std::max(recorded_cost, 1e-9));
+      recorded_cost_sum += recorded_cost;
+      replay_cost_sum += replay_cost;
+    }
+    
+    ++no_cycles;
+    no_exact += exact;
+    recorded_time += header.plan_time;
+    replay_time += plan_time;
+    max_deviation = std::max(max_deviation, deviation);
+    if (profile)
+      std::fprintf(profile, "%lu,%.9f,%.9f,%.9f,%d,%d,%u,%.17g,%d,%.17g,%.17g\n", (unsigned long) header.record.cycle, header.stamp, header.plan_time,
+                   plan_time, bool(header.flags & REPLAY_SUCCESS), success, (unsigned int) cycle.result.size(), deviation, exact,
+                   recorded_cost, replay_cost);
+  }
+  
+  if (profile)
+    std::fclose(profile);
+  if (telemetry)
+    telemetry->close();
+  
+  ROS_INFO("Replay: %lu cycles%s, %lu reproduced exactly, %lu gaps, max. deviation %g.", no_cycles,
+           reader.truncated() ? " (the last record is truncated)" : "", no_exact, no_gaps, max_deviation);
+  ROS_INFO("Replay: plan() took %f s while recording and %f s in the replay.", recorded_time, replay_time);
+  ROS_INFO("Replay: total cost %g recorded and %g replayed, max. relative cost deviation %g.", recorded_cost_sum, replay_cost_sum,
+           max_cost_deviation);
+  return no_exact == no_cycles ? 0 : 2;
+}
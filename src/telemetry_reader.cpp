@@ -0,0 +1,278 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************/
+
+#include <teb_local_planner/telemetry_recorder.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+using namespace teb_local_planner; // it is ok here to import everything for this tool
+
+// Converts a telemetry log written by the TelemetryRecorder (parameter ~telemetry_file)
+// to CSV files or to a MATLAB file (Level 4, readable by MATLAB, Octave and scipy.io.loadmat).
+//
+// Usage: telemetry_reader <log> <output_prefix> [--mat]
+// CSV output: <output_prefix>_cycles.csv, _robot.csv, _humans.csv, _obstacles.csv
+// MAT output: <output_prefix>.mat with the matrices cycles, robot, humans and obstacles
+
+
+//! Numeric table with named columns (row-major)
+struct Table
+{
+  Table(const std::string& table_name) : name(table_name) {}
+  
+  void addRow(const std::vector<double>& row)
+  {
+    data.insert(data.end(), row.begin(), row.end());
+  }
+  
+  std::size_t rows() const {return columns.empty() ? 0 : data.size() / columns.size();}
+  
+  bool writeCsv(const std::string& filename) const
+  {
+    std::FILE* file = std::fopen(filename.c_str(), "w");
+    if (!file)
+      return false;
+    for (std::size_t j=0; j < columns.size(); ++j)
+      std::fprintf(file, j+1 < columns.size() ? "%s," : "%s\n", columns[j].c_str());
+    for (std::size_t i=0; i < rows(); ++i)
+    {
+      for (std::size_t j=0; j < columns.size(); ++j)
+        std::fprintf(file, j+1 < columns.size() ? "%.17g," : "%.17g\n", data[i*columns.size() + j]);
+    }
+    std::fclose(file);
+    return true;
+  }
+  
+  // Level 4 MAT-file matrix: header, name and column-major data
+  void writeMat(std::FILE* file) const
+  {
+    int32_t header[5] = {0 /* double, full, little-endian */, (int32_t) rows(), (int32_t) columns.size(), 0, (int32_t) name.size()+1};
+    std::fwrite(header, sizeof(header), 1, file);
+    std::fwrite(name.c_str(), 1, name.size()+1, file);
+    for (std::size_t j=0; j < columns.size(); ++j)
+    {
+      for (std::size_t i=0; i < rows(); ++i)
+        std::fwrite(&data[i*columns.size() + j], sizeof(double), 1, file);
+    }
+  }
+  
+  std::string name;
+  std::vector<std::string> columns;
+  std::vector<double> data;
+};
+
+
+//! Sequential reader of the mapped log
+struct LogCursor
+{
+  LogCursor(const char* begin, const char* end) : pos(begin), end(end) {}
+  
+  template <typename T>
+  bool read(T& value)
+  {
+    if (end - pos < (std::ptrdiff_t) sizeof(T))
+      return false;
+    std::memcpy(&value, pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+  }
+  
+  const char* pos;
+  const char* end;
+};
+
+
+bool readPoses(LogCursor& cursor, unsigned int no_poses, double cycle, const std::vector<double>& prefix, Table& table)
+{
+  for (unsigned int i=0; i < no_poses; ++i)
+  {
+    TelemetryPose pose;
+    if (!cursor.read(pose))
+      return false;
+    std::vector<double> row(1, cycle);
+    row.insert(row.end(), prefix.begin(), prefix.end());
+    row.push_back(i);
+    row.push_back(pose.x);
+    row.push_back(pose.y);
+    row.push_back(pose.theta);
+    row.push_back(pose.dt);
+    table.addRow(row);
+  }
+  return true;
+}
+
+
+int main(int argc, char** argv)
+{
+  if (argc < 3)
+  {
+    std::fprintf(stderr, "Usage: %s <log> <output_prefix> [--mat]\n", argv[0]);
+    return 1;
+  }
+  std::string prefix = argv[2];
+  bool mat = argc > 3 && std::string(argv[3]) == "--mat";
+  
+  // map the log into memory
+  int fd = open(argv[1], O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(TelemetryFileHeader))
+  {
+    std::fprintf(stderr, "Cannot read telemetry log '%s'.\n", argv[1]);
+    return 1;
+  }
+  void* mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED)
+  {
+    std::fprintf(stderr, "Cannot map telemetry log '%s'.\n", argv[1]);
+    return 1;
+  }
+  const char* begin = static_cast<const char*>(mapped);
+  LogCursor cursor(begin, begin + st.st_size);
+  
+  TelemetryFileHeader file_header;
+  cursor.read(file_header);
+  if (std::memcmp(file_header.magic, TELEMETRY_MAGIC, sizeof(TELEMETRY_MAGIC)) != 0 || file_header.version != TELEMETRY_VERSION
+      || file_header.header_size != sizeof(TelemetryCycleHeader))
+  {
+    std::fprintf(stderr, "'%s' is not a telemetry log of version %u.\n", argv[1], TELEMETRY_VERSION);
+    munmap(mapped, st.st_size);
+    return 1;
+  }
+  
+  Table cycles("cycles"), robot("robot"), humans("humans"), obstacles("obstacles");
+  const char* cycle_columns[] = {"cycle", "stamp", "iterations", "dropped", "robot_poses", "humans", "obstacles"};
+  cycles.columns.assign(cycle_columns, cycle_columns + 7);
+  for (int i=0; i < TELEMETRY_PHASES; ++i)
+    cycles.columns.push_back(std::string("time_") + telemetryPhaseName(i));
+  for (int i=0; i < TELEMETRY_COSTS; ++i)
+    cycles.columns.push_back(std::string("cost_") + telemetryCostName(i));
+  const char* robot_columns[] = {"cycle", "pose", "x", "y", "theta", "dt"};
+  robot.columns.assign(robot_columns, robot_columns + 6);
+  const char* human_columns[] = {"cycle", "human_id", "pose", "x", "y", "theta", "dt"};
+  humans.columns.assign(human_columns, human_columns + 7);
+  const char* obstacle_columns[] = {"cycle", "obstacle", "type", "vertex", "x", "y"};
+  obstacles.columns.assign(obstacle_columns, obstacle_columns + 6);
+  
+  std::size_t no_records = 0;
+  bool truncated = false;
+  while (cursor.pos < cursor.end)
+  {
+    const char* record_begin = cursor.pos;
+    TelemetryCycleHeader header;
+    if (!cursor.read(header) || header.record.size < sizeof(header) || cursor.end - record_begin < (std::ptrdiff_t) header.record.size)
+    {
+      truncated = true; // e.g. the planner has been killed while writing
+      break;
+    }
+    LogCursor record(cursor.pos, record_begin + header.record.size);
+    double cycle = (double) header.record.cycle;
+    
+    std::vector<double> row;
+    row.push_back(cycle);
+    row.push_back(header.stamp);
+    row.push_back(header.no_iterations);
+    row.push_back(header.record.dropped);
+    row.push_back(header.no_robot_poses);
+    row.push_back(header.no_humans);
+    row.push_back(header.no_obstacles);
+    row.insert(row.end(), header.phase_times, header.phase_times + TELEMETRY_PHASES);
+    row.insert(row.end(), header.costs, header.costs + TELEMETRY_COSTS);
+    cycles.addRow(row);
+    
+    bool valid = readPoses(record, header.no_robot_poses, cycle, std::vector<double>(), robot);
+    for (unsigned int h=0; valid && h < header.no_humans; ++h)
+    {
+      TelemetryHumanHeader human;
+      valid = record.read(human) && readPoses(record, human.no_poses, cycle, std::vector<double>(1, (double) human.id), humans);
+    }
+    for (unsigned int o=0; valid && o < header.no_obstacles; ++o)
+    {
+      TelemetryObstacleHeader obstacle;
+      valid = record.read(obstacle);
+      for (unsigned int v=0; valid && v < obstacle.no_vertices; ++v)
+      {
+        double vertex[2];
+        valid = record.read(vertex);
+        double obstacle_row[] = {cycle, (double) o, (double) obstacle.type, (double) v, vertex[0], vertex[1]};
+        if (valid)
+          obstacles.addRow(std::vector<double>(obstacle_row, obstacle_row + 6));
+      }
+    }
+    if (!valid)
+      std::fprintf(stderr, "Record %lu is inconsistent.\n", (unsigned long) header.record.cycle);
+    
+    cursor.pos = record_begin + header.record.size;
+    ++no_records;
+  }
+  munmap(mapped, st.st_size);
+  
+  std::printf("Read %lu records%s.\n", (unsigned long) no_records, truncated ? " (the last record is truncated)" : "");
+  
+  if (mat)
+  {
+    std::FILE* file = std::fopen((prefix + ".mat").c_str(), "wb");
+    if (!file)
+    {
+      std::fprintf(stderr, "Cannot write '%s.mat'.\n", prefix.c_str());
+      return 1;
+    }
+    cycles.writeMat(file);
+    robot.writeMat(file);
+    humans.writeMat(file);
+    obstacles.writeMat(file);
+    std::fclose(file);
+    return 0;
+  }
+  
+  if (!cycles.writeCsv(prefix + "_cycles.csv") || !robot.writeCsv(prefix + "_robot.csv")
+      || !humans.writeCsv(prefix + "_humans.csv") || !obstacles.writeCsv(prefix + "_obstacles.csv"))
+  {
+    std::fprintf(stderr, "Cannot write the CSV files '%s_*.csv'.\n", prefix.c_str());
+    return 1;
+  }
+  return 0;
+}
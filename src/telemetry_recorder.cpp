@@ -0,0 +1,181 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Copyright (c) 2016 LAAS/CNRS
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <teb_local_planner/telemetry_recorder.h>
+
+#include <algorithm>
+#include <cstddef>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+namespace teb_local_planner {
+
+const char *telemetryPhaseName(int phase) {
+  static const char *names[TELEMETRY_PHASES] = {"preparation", "humans",
+                                                "optimization", "total"};
+  return phase >= 0 && phase < TELEMETRY_PHASES ? names[phase] : "unknown";
+}
+
+const char *telemetryCostName(int cost) {
+  static const char *names[TELEMETRY_COSTS] = {
+      "time_optimal",       "kinematics_diff_drive", "kinematics_carlike",
+      "velocity",           "acceleration",          "obstacle",
+      "dynamic_obstacle",   "via_point",             "human_robot_safety",
+      "human_human_safety", "human_robot_ttc",       "human_robot_directional"};
+  return cost >= 0 && cost < TELEMETRY_COSTS ? names[cost] : "unknown";
+}
+
+TelemetryRecorder::TelemetryRecorder()
+    : file_(NULL), running_(false), head_(0), tail_(0), cycle_(0),
+      dropped_(0), dropped_total_(0) {}
+
+TelemetryRecorder::~TelemetryRecorder() { close(); }
+
+bool TelemetryRecorder::open(const std::string &filename,
+                             std::size_t buffer_size, double flush_period) {
+  TelemetryFileHeader header;
+  std::memcpy(header.magic, TELEMETRY_MAGIC, sizeof(header.magic));
+  header.version = TELEMETRY_VERSION;
+  header.header_size = sizeof(TelemetryCycleHeader);
+  return open(filename, header, buffer_size, flush_period);
+}
+
+bool TelemetryRecorder::open(const std::string &filename,
+                             const TelemetryFileHeader &file_header,
+                             std::size_t buffer_size, double flush_period) {
+  close();
+
+  file_ = std::fopen(filename.c_str(), "wb");
+  if (!file_)
+    return false;
+
+  std::fwrite(&file_header, sizeof(file_header), 1, file_);
+
+  ring_.assign(std::max<std::size_t>(buffer_size, 1 << 16), 0);
+  head_ = 0;
+  tail_ = 0;
+  cycle_ = 0;
+  dropped_ = 0;
+  dropped_total_ = 0;
+
+  running_ = true;
+  flush_thread_ = boost::thread(
+      boost::bind(&TelemetryRecorder::flushThread, this, flush_period));
+  return true;
+}
+
+void TelemetryRecorder::close() {
+  if (!file_)
+    return;
+
+  running_ = false;
+  flush_thread_.interrupt();
+  flush_thread_.join();
+
+  flush();
+  std::fclose(file_);
+  file_ = NULL;
+}
+
+bool TelemetryRecorder::commitRecord() {
+  if (!file_ || record_.size() < sizeof(TelemetryRecordHeader))
+    return false;
+
+  // complete the header
+  uint32_t size = record_.size();
+  std::memcpy(&record_[offsetof(TelemetryRecordHeader, size)], &size,
+              sizeof(size));
+  std::memcpy(&record_[offsetof(TelemetryRecordHeader, cycle)], &cycle_,
+              sizeof(cycle_));
+  std::memcpy(&record_[offsetof(TelemetryRecordHeader, dropped)], &dropped_,
+              sizeof(dropped_));
+  ++cycle_;
+
+  // the producer owns tail_, head_ is only advanced by the flush thread
+  std::size_t tail = tail_.load(std::memory_order_relaxed);
+  std::size_t head = head_.load(std::memory_order_acquire);
+  if (ring_.size() - (tail - head) < record_.size()) {
+    ++dropped_;
+    ++dropped_total_;
+    return false;
+  }
+
+  std::size_t offset = tail % ring_.size();
+  std::size_t first = std::min(record_.size(), ring_.size() - offset);
+  std::memcpy(&ring_[offset], &record_[0], first);
+  if (first < record_.size())
+    std::memcpy(&ring_[0], &record_[first], record_.size() - first);
+
+  tail_.store(tail + record_.size(), std::memory_order_release);
+  dropped_ = 0;
+  return true;
+}
+
+void TelemetryRecorder::flush() {
+  std::size_t head = head_.load(std::memory_order_relaxed);
+  std::size_t tail = tail_.load(std::memory_order_acquire);
+  if (head == tail)
+    return;
+
+  std::size_t size = tail - head;
+  std::size_t offset = head % ring_.size();
+  std::size_t first = std::min(size, ring_.size() - offset);
+  std::fwrite(&ring_[offset], 1, first, file_);
+  if (first < size)
+    std::fwrite(&ring_[0], 1, size - first, file_);
+  std::fflush(file_);
+
+  head_.store(tail, std::memory_order_release);
+}
+
+void TelemetryRecorder::flushThread(double flush_period) {
+  const boost::posix_time::microseconds period(
+      static_cast<int64_t>(flush_period * 1e6));
+  try {
+    while (running_) {
+      flush();
+      boost::this_thread::sleep(period);
+    }
+  } catch (const boost::thread_interrupted &) {
+    // close() flushes the remaining records
+  }
+}
+
+} // namespace teb_local_planner
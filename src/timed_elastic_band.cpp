@@ -60,28 +60,28 @@ TimedElasticBand::~TimedElasticBand()
 
 void TimedElasticBand::addPose(const PoseSE2& pose, bool fixed)
 {
-  VertexPose* pose_vertex = new VertexPose(pose, fixed);
+  VertexPose* pose_vertex = pose_pool_.create(pose, fixed);
   pose_vec_.push_back( pose_vertex );
   return;
 }
 
 void TimedElasticBand::addPose(const Eigen::Ref<const Eigen::Vector2d>& position, double theta, bool fixed)
 {
-  VertexPose* pose_vertex = new VertexPose(position, theta, fixed);
+  VertexPose* pose_vertex = pose_pool_.create(position, theta, fixed);
   pose_vec_.push_back( pose_vertex );
   return;
 }
 
  void TimedElasticBand::addPose(double x, double y, double theta, bool fixed)
 {
-  VertexPose* pose_vertex = new VertexPose(x, y, theta, fixed);
+  VertexPose* pose_vertex = pose_pool_.create(x, y, theta, fixed);
   pose_vec_.push_back( pose_vertex );
   return;
 }
 
 void TimedElasticBand::addTimeDiff(double dt, bool fixed)
 {
-  VertexTimeDiff* timediff_vertex = new VertexTimeDiff(dt, fixed);
+  VertexTimeDiff* timediff_vertex = timediff_pool_.create(dt, fixed);
   timediff_vec_.push_back( timediff_vertex );
   return;
 }
@@ -127,7 +127,7 @@ void TimedElasticBand::addPoseAndTimeDiff(const Eigen::Ref<const Eigen::Vector2d
 void TimedElasticBand::deletePose(unsigned int index)
 {
   ROS_ASSERT(index<pose_vec_.size());
-  delete pose_vec_.at(index);
+  pose_pool_.destroy(pose_vec_.at(index));
   pose_vec_.erase(pose_vec_.begin()+index);
 }
 
@@ -135,14 +135,14 @@ void TimedElasticBand::deletePoses(unsigned int index, unsigned int number)
 {
 	ROS_ASSERT(index+number<=pose_vec_.size());
 	for (unsigned int i = index; i<index+number; ++i)
-		delete pose_vec_.at(i);
+		pose_pool_.destroy(pose_vec_.at(i));
 	pose_vec_.erase(pose_vec_.begin()+index, pose_vec_.begin()+index+number);
 }
 
 void TimedElasticBand::deleteTimeDiff(unsigned int index)
 {
   ROS_ASSERT(index<timediff_vec_.size());
-  delete timediff_vec_.at(index);
+  timediff_pool_.destroy(timediff_vec_.at(index));
   timediff_vec_.erase(timediff_vec_.begin()+index);
 }
 
@@ -150,31 +150,31 @@ void TimedElasticBand::deleteTimeDiffs(unsigned int index, unsigned int number)
 {
 	ROS_ASSERT(index+number<=timediff_vec_.size());
 	for (unsigned int i = index; i<index+number; ++i)
-		delete timediff_vec_.at(i);
+		timediff_pool_.destroy(timediff_vec_.at(i));
 	timediff_vec_.erase(timediff_vec_.begin()+index, timediff_vec_.begin()+index+number);
 }
 
 inline void TimedElasticBand::insertPose(unsigned int index, const PoseSE2& pose)
 {
-  VertexPose* pose_vertex = new VertexPose(pose);
+  VertexPose* pose_vertex = pose_pool_.create(pose);
   pose_vec_.insert(pose_vec_.begin()+index, pose_vertex);
 }
 
 inline void TimedElasticBand::insertPose(unsigned int index, const Eigen::Ref<const Eigen::Vector2d>& position, double theta)
 {
-  VertexPose* pose_vertex = new VertexPose(position, theta);
+  VertexPose* pose_vertex = pose_pool_.create(position, theta);
   pose_vec_.insert(pose_vec_.begin()+index, pose_vertex);
 }
 
 inline void TimedElasticBand::insertPose(unsigned int index, double x, double y, double theta)
 {
-  VertexPose* pose_vertex = new VertexPose(x, y, theta);
+  VertexPose* pose_vertex = pose_pool_.create(x, y, theta);
   pose_vec_.insert(pose_vec_.begin()+index, pose_vertex);
 }
 
 inline void TimedElasticBand::insertTimeDiff(unsigned int index, double dt)
 {
-  VertexTimeDiff* timediff_vertex = new VertexTimeDiff(dt);
+  VertexTimeDiff* timediff_vertex = timediff_pool_.create(dt);
   timediff_vec_.insert(timediff_vec_.begin()+index, timediff_vertex);
 }
 
@@ -182,12 +182,15 @@ inline void TimedElasticBand::insertTimeDiff(unsigned int index, double dt)
 void TimedElasticBand::clearTimedElasticBand()
 {
   for (PoseSequence::iterator pose_it = pose_vec_.begin(); pose_it != pose_vec_.end(); ++pose_it)
-    delete *pose_it;
+    pose_pool_.destroy(*pose_it);
   pose_vec_.clear();
 
   for (TimeDiffSequence::iterator dt_it = timediff_vec_.begin(); dt_it != timediff_vec_.end(); ++dt_it)
-    delete *dt_it;
+    timediff_pool_.destroy(*dt_it);
   timediff_vec_.clear();
+
+  obstacle_assoc_centroids_.clear();
+  obstacle_assoc_poses_.clear();
 }
 
 
@@ -206,33 +209,144 @@ void TimedElasticBand::setTimeDiffVertexFixed(unsigned int index, bool status)
 
 void TimedElasticBand::autoResize(double dt_ref, double dt_hysteresis, int min_samples)
 {
+  std::size_t n = sizeTimeDiffs();
+  if (n == 0)
+    return;
+
   /// iterate through all TEB states only once and add/remove states!
-  for(unsigned int i=0; i < sizeTimeDiffs(); ++i) // TimeDiff connects Point(i) with Point(i+1)
+  // The resized sequences are assembled in a single pass: unchanged vertices are moved (pointer copies),
+  // removed vertices are returned to the pool and new ones are taken from it.
+  resize_pose_vec_.clear();
+  resize_timediff_vec_.clear();
+  resize_pose_vec_.reserve(2*n+1);
+  resize_timediff_vec_.reserve(2*n);
+  resize_pose_vec_.push_back(pose_vec_.front());
+
+  std::size_t size = n; // current number of time differences
+  bool changed = false;
+  std::size_t i = 0;
+  while (i < n) // TimeDiff connects Point(i) with Point(i+1)
   {
-    if(TimeDiff(i) > dt_ref + dt_hysteresis)
+    VertexTimeDiff* timediff = timediff_vec_[i];
+    if(timediff->dt() > dt_ref + dt_hysteresis)
     {
       //ROS_DEBUG("teb_local_planner: autoResize() inserting new bandpoint i=%u, #TimeDiffs=%lu",i,sizeTimeDiffs());
 
-      double newtime = 0.5*TimeDiff(i);
+      double newtime = 0.5*timediff->dt();
 
-      TimeDiff(i) = newtime;
-      insertPose(i+1, PoseSE2::average(Pose(i),Pose(i+1)) );
-      insertTimeDiff(i+1,newtime);
+      timediff->dt() = newtime;
+      resize_timediff_vec_.push_back(timediff);
+      resize_pose_vec_.push_back( pose_pool_.create(PoseSE2::average(Pose(i),Pose(i+1))) );
+      resize_timediff_vec_.push_back( timediff_pool_.create(newtime) );
+      resize_pose_vec_.push_back(pose_vec_[i+1]);
 
-      ++i; // skip the newly inserted pose
+      ++size;
+      ++i;
+      changed = true;
     }
-    else if(TimeDiff(i) < dt_ref - dt_hysteresis && (int)sizeTimeDiffs()>min_samples) // only remove samples if size is larger than min_samples.
+    else if(timediff->dt() < dt_ref - dt_hysteresis && (int)size>min_samples && i+1 < n) // only remove samples if size is larger than min_samples.
     {
       //ROS_DEBUG("teb_local_planner: autoResize() deleting bandpoint i=%u, #TimeDiffs=%lu",i,sizeTimeDiffs());
 
-      if(i < (sizeTimeDiffs()-1))
-      {
-        TimeDiff(i+1) = TimeDiff(i+1) + TimeDiff(i);
-        deleteTimeDiff(i);
-        deletePose(i+1);
-      }
+      // merge with the subsequent time difference (which is not checked again)
+      timediff_vec_[i+1]->dt() += timediff->dt();
+      timediff_pool_.destroy(timediff);
+      pose_pool_.destroy(pose_vec_[i+1]);
+      resize_timediff_vec_.push_back(timediff_vec_[i+1]);
+      resize_pose_vec_.push_back(pose_vec_[i+2]);
+
+      --size;
+      i += 2;
+      changed = true;
+    }
+    else
+    {
+      resize_timediff_vec_.push_back(timediff);
+      resize_pose_vec_.push_back(pose_vec_[i+1]);
+      ++i;
     }
   }
+
+  if (changed)
+  {
+    pose_vec_.swap(resize_pose_vec_);
+    timediff_vec_.swap(resize_timediff_vec_);
+  }
+}
+
+void TimedElasticBand::resample(double dt_ref, double dt_hysteresis, int min_samples)
+{
+  std::size_t n = sizeTimeDiffs();
+  if (n == 0 || dt_ref <= 0)
+    return;
+
+  // keep the band as long as all time differences are within the hysteresis interval
+  bool resize = false;
+  resample_times_.resize(n+1);
+  resample_times_.front() = 0;
+  for (std::size_t i=0; i < n; ++i)
+  {
+    double dt = TimeDiff(i);
+    if (dt > dt_ref + dt_hysteresis || dt < dt_ref - dt_hysteresis)
+      resize = true;
+    resample_times_[i+1] = resample_times_[i] + dt;
+  }
+  if (!resize)
+    return;
+
+  double total_time = resample_times_.back();
+  std::size_t m = std::max<std::size_t>(1, (std::size_t) std::max(0.0, round(total_time / dt_ref)));
+  if ((int)m < min_samples)
+    m = std::max(min_samples, 1);
+  double dt_new = total_time / (double) m;
+
+  // copy the current states, since the vertices are overwritten in place
+  resample_positions_.resize(n+1);
+  resample_thetas_.resize(n+1);
+  for (std::size_t i=0; i <= n; ++i)
+  {
+    resample_positions_[i] = Pose(i).position();
+    resample_thetas_[i] = Pose(i).theta();
+  }
+
+  // assemble the new sequences: start and goal vertex are kept, intermediate vertices are reused in their
+  // original order, missing ones are taken from the pool and surplus ones are returned to it.
+  resize_pose_vec_.clear();
+  resize_timediff_vec_.clear();
+  resize_pose_vec_.reserve(m+1);
+  resize_timediff_vec_.reserve(m);
+
+  resize_pose_vec_.push_back(pose_vec_.front());
+  for (std::size_t k=1; k < m; ++k)
+    resize_pose_vec_.push_back(k < n ? pose_vec_[k] : pose_pool_.create());
+  resize_pose_vec_.push_back(pose_vec_.back());
+  for (std::size_t k=m; k < n; ++k)
+    pose_pool_.destroy(pose_vec_[k]);
+
+  for (std::size_t k=0; k < m; ++k)
+    resize_timediff_vec_.push_back(k < n ? timediff_vec_[k] : timediff_pool_.create(dt_new));
+  for (std::size_t k=m; k < n; ++k)
+    timediff_pool_.destroy(timediff_vec_[k]);
+
+  pose_vec_.swap(resize_pose_vec_);
+  timediff_vec_.swap(resize_timediff_vec_);
+
+  // interpolate the old trajectory at equidistant time instances (single linear pass)
+  std::size_t j = 0; // segment between old pose j and j+1
+  for (std::size_t k=1; k < m; ++k)
+  {
+    double t = (double) k * dt_new;
+    while (j+1 < n && resample_times_[j+1] <= t)
+      ++j;
+    double seg_time = resample_times_[j+1] - resample_times_[j];
+    double s = seg_time > 0 ? std::min(1.0, std::max(0.0, (t - resample_times_[j]) / seg_time)) : 0;
+
+    VertexPose* pose = pose_vec_[k];
+    pose->position() = resample_positions_[j] + s * (resample_positions_[j+1] - resample_positions_[j]);
+    pose->theta() = g2o::normalize_theta( resample_thetas_[j] + s * g2o::normalize_theta(resample_thetas_[j+1] - resample_thetas_[j]) );
+  }
+  for (std::size_t k=0; k < m; ++k)
+    TimeDiff(k) = dt_new;
 }
 
 
@@ -247,6 +361,32 @@ double TimedElasticBand::getSumOfAllTimeDiffs() const
   return time;
 }
 
+void TimedElasticBand::updateTimePrefix()
+{
+  std::size_t n = timediff_vec_.size();
+  time_prefix_.resize(n+1);
+  time_prefix_dt_.resize(n, std::numeric_limits<double>::quiet_NaN());
+  time_prefix_.front() = 0;
+
+  // skip the unchanged part of the prefix
+  std::size_t first = 0;
+  while (first < n && time_prefix_dt_[first] == timediff_vec_[first]->dt())
+    ++first;
+
+  for (std::size_t i = first; i < n; ++i)
+  {
+    time_prefix_dt_[i] = timediff_vec_[i]->dt();
+    time_prefix_[i+1] = time_prefix_[i] + time_prefix_dt_[i];
+  }
+}
+
+g2o::HyperGraphAction* TimePrefixUpdateAction::operator()(const g2o::HyperGraph* graph, g2o::HyperGraphAction::Parameters* parameters)
+{
+  if (teb_)
+    teb_->updateTimePrefix();
+  return this;
+}
+
 double TimedElasticBand::getAccumulatedDistance() const
 {
   double dist = 0;
@@ -445,12 +585,17 @@ int TimedElasticBand::findClosestTrajectoryPose(const Eigen::Ref<const Eigen::Ve
 
 int TimedElasticBand::findClosestTrajectoryPose(const Point2dContainer& vertices, double* distance) const
 {
-  if (vertices.empty())
+  return findClosestTrajectoryPose(vertices.empty() ? NULL : &vertices.front(), vertices.size(), distance);
+}
+
+int TimedElasticBand::findClosestTrajectoryPose(const Eigen::Vector2d* vertices, std::size_t no_vertices, double* distance) const
+{
+  if (no_vertices == 0)
     return 0;
-  else if (vertices.size() == 1)
-    return findClosestTrajectoryPose(vertices.front());
-  else if (vertices.size() == 2)
-    return findClosestTrajectoryPose(vertices.front(), vertices.back());
+  else if (no_vertices == 1)
+    return findClosestTrajectoryPose(vertices[0]);
+  else if (no_vertices == 2)
+    return findClosestTrajectoryPose(vertices[0], vertices[1]);
 
   std::vector<double> dist_vec; // TODO: improve! efficiency
   dist_vec.reserve(sizePoses());
@@ -462,11 +607,11 @@ int TimedElasticBand::findClosestTrajectoryPose(const Point2dContainer& vertices
   {
     Eigen::Vector2d point = Pose(i).position();
     double diff = HUGE_VAL;
-    for (int j = 0; j < (int) vertices.size()-1; ++j)
+    for (int j = 0; j < (int) no_vertices-1; ++j)
     {
        diff = std::min(diff, distance_point_to_segment_2d(point, vertices[j], vertices[j+1]));
     }
-    diff = std::min(diff, distance_point_to_segment_2d(point, vertices.back(), vertices.front()));
+    diff = std::min(diff, distance_point_to_segment_2d(point, vertices[no_vertices-1], vertices[0]));
     dist_vec.push_back(diff);
   }
 
@@ -509,6 +654,69 @@ int TimedElasticBand::findClosestTrajectoryPose(const Obstacle& obstacle, double
 }
 
 
+int TimedElasticBand::findClosestTrajectoryPose(const ObstacleSnapshot& obstacles, std::size_t obstacle_idx, double* distance) const
+{
+  unsigned int k = obstacles.typeIndex(obstacle_idx);
+  switch (obstacles.type(obstacle_idx))
+  {
+    case ObstacleSnapshot::POINT_OBSTACLE:
+      return findClosestTrajectoryPose(obstacles.pointPositions()[k], distance);
+    case ObstacleSnapshot::LINE_OBSTACLE:
+      return findClosestTrajectoryPose(obstacles.lineStarts()[k], obstacles.lineEnds()[k], distance);
+    case ObstacleSnapshot::POLYGON_OBSTACLE:
+      return findClosestTrajectoryPose(obstacles.polygonVertices(k), obstacles.polygonSize(k), distance);
+    default:
+      return findClosestTrajectoryPose(obstacles.centroid(obstacle_idx), distance);
+  }
+}
+
+
+int TimedElasticBand::findClosestTrajectoryPoseCached(const ObstacleSnapshot& obstacles, std::size_t obstacle_idx)
+{
+  int n = sizePoses();
+  if (n == 0)
+    return -1;
+
+  if (obstacle_idx >= obstacle_assoc_poses_.size())
+  {
+    obstacle_assoc_centroids_.resize(obstacle_idx+1, Eigen::Vector2d::Zero());
+    obstacle_assoc_poses_.resize(obstacle_idx+1, -1);
+  }
+
+  const Eigen::Vector2d& centroid = obstacles.centroid(obstacle_idx);
+  int& index = obstacle_assoc_poses_[obstacle_idx];
+
+  // obstacle changed (or not yet associated) -> global search
+  if (index < 0 || (obstacle_assoc_centroids_[obstacle_idx] - centroid).squaredNorm() > 1e-6)
+  {
+    obstacle_assoc_centroids_[obstacle_idx] = centroid;
+    index = findClosestTrajectoryPose(obstacles, obstacle_idx);
+    return index;
+  }
+
+  // refine the previous association locally (poses might have been inserted or removed meanwhile)
+  index = std::min(index, n-1);
+  double dist = obstacles.getMinimumDistance(obstacle_idx, Pose(index).position());
+  while (index+1 < n)
+  {
+    double dist_next = obstacles.getMinimumDistance(obstacle_idx, Pose(index+1).position());
+    if (dist_next >= dist)
+      break;
+    dist = dist_next;
+    ++index;
+  }
+  while (index > 0)
+  {
+    double dist_prev = obstacles.getMinimumDistance(obstacle_idx, Pose(index-1).position());
+    if (dist_prev >= dist)
+      break;
+    dist = dist_prev;
+    --index;
+  }
+  return index;
+}
+
+
 
 
 bool TimedElasticBand::detectDetoursBackwards(double threshold) const
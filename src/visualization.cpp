@@ -57,8 +57,86 @@
 #include <teb_local_planner/optimal_planner.h>
 #include <teb_local_planner/FeedbackMsg.h>
 
+#include <boost/bind.hpp>
+
 namespace teb_local_planner {
 
+namespace {
+
+bool samePoint(const geometry_msgs::Point &p1, const geometry_msgs::Point &p2) {
+  return p1.x == p2.x && p1.y == p2.y && p1.z == p2.z;
+}
+
+bool sameColor(const std_msgs::ColorRGBA &c1, const std_msgs::ColorRGBA &c2) {
+  return c1.r == c2.r && c1.g == c2.g && c1.b == c2.b && c1.a == c2.a;
+}
+
+// compare everything except the header, since the stamp changes every cycle
+bool sameMarker(const visualization_msgs::Marker &m1,
+                const visualization_msgs::Marker &m2) {
+  if (m1.type != m2.type || m1.action != m2.action ||
+      m1.header.frame_id != m2.header.frame_id ||
+      m1.lifetime != m2.lifetime || !sameColor(m1.color, m2.color) ||
+      m1.scale.x != m2.scale.x || m1.scale.y != m2.scale.y ||
+      m1.scale.z != m2.scale.z ||
+      !samePoint(m1.pose.position, m2.pose.position) ||
+      m1.pose.orientation.x != m2.pose.orientation.x ||
+      m1.pose.orientation.y != m2.pose.orientation.y ||
+      m1.pose.orientation.z != m2.pose.orientation.z ||
+      m1.pose.orientation.w != m2.pose.orientation.w ||
+      m1.points.size() != m2.points.size() ||
+      m1.colors.size() != m2.colors.size() || m1.text != m2.text)
+    return false;
+  for (std::size_t i = 0; i < m1.points.size(); ++i) {
+    if (!samePoint(m1.points[i], m2.points[i]))
+      return false;
+  }
+  for (std::size_t i = 0; i < m1.colors.size(); ++i) {
+    if (!sameColor(m1.colors[i], m2.colors[i]))
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+void MarkerDeltaFilter::subscriberConnected(
+    const ros::SingleSubscriberPublisher &) {
+  requestReset();
+}
+
+bool MarkerDeltaFilter::update() {
+  if (!reset_.exchange(false))
+    return false;
+  sent_.clear();
+  return true;
+}
+
+void MarkerDeltaFilter::update(int &last_no_markers) {
+  if (update())
+    last_no_markers = 0;
+}
+
+bool MarkerDeltaFilter::changed(const visualization_msgs::Marker &marker,
+                                const ros::Time &now) {
+  auto key = std::make_pair(marker.ns, marker.id);
+  if (marker.action != visualization_msgs::Marker::ADD) {
+    sent_.erase(key);
+    return true;
+  }
+
+  auto sent_it = sent_.find(key);
+  if (sent_it != sent_.end() && sameMarker(sent_it->second.marker, marker) &&
+      (marker.lifetime.isZero() ||
+       now - sent_it->second.stamp < marker.lifetime * 0.5))
+    return false;
+
+  SentMarker &sent = sent_[key];
+  sent.marker = marker;
+  sent.stamp = now;
+  return true;
+}
+
 TebVisualization::TebVisualization() : initialized_(false) {}
 
 TebVisualization::TebVisualization(ros::NodeHandle &nh, const TebConfig &cfg)
@@ -79,7 +157,9 @@ void TebVisualization::initialize(ros::NodeHandle &nh, const TebConfig &cfg) {
   teb_poses_pub_ =
       nh.advertise<geometry_msgs::PoseArray>(LOCAL_PLAN_POSES_TOPIC, 1);
   teb_fp_poses_pub_ = nh.advertise<visualization_msgs::MarkerArray>(
-      LOCAL_PLAN_FP_POSES_TOPIC, 1);
+      LOCAL_PLAN_FP_POSES_TOPIC, 1,
+      boost::bind(&MarkerDeltaFilter::subscriberConnected,
+                  &robot_fp_poses_filter_, _1));
   humans_global_plans_pub_ =
       nh.advertise<hanp_msgs::HumanPathArray>(HUMAN_GLOBAL_PLANS_TOPIC, 1);
   humans_local_plans_pub_ =
@@ -87,9 +167,13 @@ void TebVisualization::initialize(ros::NodeHandle &nh, const TebConfig &cfg) {
   humans_tebs_poses_pub_ =
       nh.advertise<geometry_msgs::PoseArray>(HUMAN_LOCAL_PLAN_POSES_TOPIC, 1);
   humans_tebs_fp_poses_pub_ = nh.advertise<visualization_msgs::MarkerArray>(
-      HUMAN_LOCAL_PLAN_FP_POSES_TOPIC, 1);
-  teb_marker_pub_ =
-      nh.advertise<visualization_msgs::Marker>("teb_markers", 1000);
+      HUMAN_LOCAL_PLAN_FP_POSES_TOPIC, 1,
+      boost::bind(&MarkerDeltaFilter::subscriberConnected,
+                  &human_fp_poses_filter_, _1));
+  teb_marker_pub_ = nh.advertise<visualization_msgs::Marker>(
+      "teb_markers", 1000,
+      boost::bind(&MarkerDeltaFilter::subscriberConnected, &marker_filter_,
+                  _1));
   feedback_pub_ =
       nh.advertise<teb_local_planner::FeedbackMsg>("teb_feedback", 10);
 
@@ -119,7 +203,8 @@ void TebVisualization::initialize(ros::NodeHandle &nh, const TebConfig &cfg) {
 void TebVisualization::publishGlobalPlan(
     const std::vector<geometry_msgs::PoseStamped> &global_plan) const {
   if (printErrorWhenNotInitialized() ||
-      !cfg_->visualization.publish_robot_global_plan) {
+      !cfg_->visualization.publish_robot_global_plan ||
+      global_plan_pub_.getNumSubscribers() == 0) {
     return;
   }
   base_local_planner::publishPlan(global_plan, global_plan_pub_);
@@ -127,7 +212,7 @@ void TebVisualization::publishGlobalPlan(
 
 void TebVisualization::publishLocalPlan(
     const std::vector<geometry_msgs::PoseStamped> &local_plan) const {
-  if (printErrorWhenNotInitialized())
+  if (printErrorWhenNotInitialized() || local_plan_pub_.getNumSubscribers() == 0)
     return;
   base_local_planner::publishPlan(local_plan, local_plan_pub_);
 }
@@ -135,7 +220,8 @@ void TebVisualization::publishLocalPlan(
 void TebVisualization::publishHumansPlans(
     const std::vector<HumanPlanCombined> &humans_plans) const {
   if (printErrorWhenNotInitialized() ||
-      !cfg_->visualization.publish_human_global_plans || humans_plans.empty()) {
+      !cfg_->visualization.publish_human_global_plans || humans_plans.empty() ||
+      humans_global_plans_pub_.getNumSubscribers() == 0) {
     return;
   }
 
@@ -187,168 +273,167 @@ void TebVisualization::publishHumansPlans(
 }
 
 void TebVisualization::publishLocalPlanAndPoses(
-    const TimedElasticBand &teb,
+    const std::vector<TrajectoryPointMsg> &trajectory,
     const BaseRobotFootprintModel &robot_model) const {
-  if (printErrorWhenNotInitialized() ||
-      (!cfg_->visualization.publish_robot_local_plan &&
-       !cfg_->visualization.publish_robot_local_plan_poses &&
-       !cfg_->visualization.publish_robot_local_plan_fp_poses)) {
+  if (printErrorWhenNotInitialized() || trajectory.empty())
+    return;
+
+  // skip the construction of messages nobody listens to
+  bool publish_path = cfg_->visualization.publish_robot_local_plan &&
+                      local_plan_pub_.getNumSubscribers() > 0;
+  bool publish_poses = cfg_->visualization.publish_robot_local_plan_poses &&
+                       teb_poses_pub_.getNumSubscribers() > 0;
+  bool publish_fp_poses =
+      cfg_->visualization.publish_robot_local_plan_fp_poses &&
+      teb_fp_poses_pub_.getNumSubscribers() > 0;
+  if (!publish_path && !publish_poses && !publish_fp_poses)
     return;
-  }
 
   auto frame_id = cfg_->map_frame;
   auto now = ros::Time::now();
 
-  // create path msg
-  nav_msgs::Path teb_path;
-  teb_path.header.frame_id = frame_id;
-  teb_path.header.stamp = now;
+  // publish robot local plans
+  if (publish_path) {
+    nav_msgs::Path teb_path;
+    teb_path.header.frame_id = frame_id;
+    teb_path.header.stamp = now;
+    teb_path.poses.resize(trajectory.size());
+    for (std::size_t i = 0; i < trajectory.size(); i++) {
+      geometry_msgs::PoseStamped &pose = teb_path.poses[i];
+      pose.header = teb_path.header;
+      pose.pose = trajectory[i].pose;
+      pose.pose.position.z = 0;
+    }
+    local_plan_pub_.publish(teb_path);
+  }
 
-  // create pose_array (along trajectory)
+  if (!publish_poses && !publish_fp_poses)
+    return;
+
+  // create pose_array (along trajectory, the height encodes the time)
   geometry_msgs::PoseArray teb_poses;
   teb_poses.header.frame_id = frame_id;
   teb_poses.header.stamp = now;
-
-  // fill path msgs with teb configurations
-  double pose_time = 0.0;
-  for (unsigned int i = 0; i < teb.sizePoses(); i++) {
-    geometry_msgs::PoseStamped pose;
-    pose.header.frame_id = frame_id;
-    pose.header.stamp = now;
-    pose.pose.position.x = teb.Pose(i).x();
-    pose.pose.position.y = teb.Pose(i).y();
-    pose.pose.position.z = 0;
-    pose.pose.orientation = tf::createQuaternionMsgFromYaw(teb.Pose(i).theta());
-    teb_path.poses.push_back(pose);
-    pose.pose.position.z = pose_time * cfg_->visualization.pose_array_z_scale;
-    teb_poses.poses.push_back(pose.pose);
-    if (i < (teb.sizePoses() - 1)) {
-      pose_time += teb.TimeDiff(i);
-    }
-  }
-
-  // publish robot local plans
-  if (!teb_path.poses.empty() && cfg_->visualization.publish_robot_local_plan) {
-    local_plan_pub_.publish(teb_path);
+  teb_poses.poses.resize(trajectory.size());
+  for (std::size_t i = 0; i < trajectory.size(); i++) {
+    teb_poses.poses[i] = trajectory[i].pose;
+    teb_poses.poses[i].position.z = trajectory[i].time_from_start.toSec() *
+                                    cfg_->visualization.pose_array_z_scale;
   }
 
   // publish robot local plan poses and footprint
-  if (!teb_poses.poses.empty()) {
-    if (cfg_->visualization.publish_robot_local_plan_poses) {
-      teb_poses_pub_.publish(teb_poses);
-    }
-
-    if (cfg_->visualization.publish_robot_local_plan_fp_poses) {
-      visualization_msgs::MarkerArray teb_fp_poses;
-      int idx = 0;
-      for (auto &pose : teb_poses.poses) {
-        std::vector<visualization_msgs::Marker> fp_markers;
-        robot_model.visualizeRobot(pose, fp_markers);
-        for (auto &marker : fp_markers) {
-          marker.header.frame_id = cfg_->map_frame;
-          marker.header.stamp = ros::Time::now();
-          marker.action = visualization_msgs::Marker::ADD;
-          marker.ns = ROBOT_FP_POSES_NS;
-          marker.id = idx++;
-          marker.lifetime = ros::Duration(2.0);
-          teb_fp_poses.markers.push_back(marker);
-        }
-      }
-      while (idx < last_robot_fp_poses_idx_) {
-        visualization_msgs::Marker clean_fp_marker;
-        clean_fp_marker.header.frame_id = cfg_->map_frame;
-        clean_fp_marker.header.stamp = ros::Time::now();
-        clean_fp_marker.action = visualization_msgs::Marker::DELETE;
-        clean_fp_marker.id = idx++;
-        clean_fp_marker.ns = ROBOT_FP_POSES_NS;
-        teb_fp_poses.markers.push_back(clean_fp_marker);
-      }
-      last_robot_fp_poses_idx_ = idx;
+  if (publish_poses) {
+    teb_poses_pub_.publish(teb_poses);
+  }
 
-      teb_fp_poses_pub_.publish(teb_fp_poses);
-    }
+  if (publish_fp_poses) {
+    publishFootprintPoses(teb_poses.poses, robot_model, ROBOT_FP_POSES_NS,
+                          now, robot_fp_poses_filter_,
+                          last_robot_fp_poses_idx_, teb_fp_poses_pub_);
   }
 }
 
 void TebVisualization::publishHumanPlanPoses(
-    const std::map<uint64_t, TimedElasticBand> &humans_tebs_map,
+    const std::map<uint64_t, std::vector<TrajectoryPointMsg>>
+        &humans_trajectories,
     const BaseRobotFootprintModel &human_model) const {
-  if (printErrorWhenNotInitialized() || humans_tebs_map.empty() ||
-      (!cfg_->visualization.publish_human_local_plan_poses &&
-       !cfg_->visualization.publish_human_local_plan_fp_poses)) {
+  if (printErrorWhenNotInitialized() || humans_trajectories.empty())
     return;
-  }
+
+  // skip the construction of messages nobody listens to
+  bool publish_poses = cfg_->visualization.publish_human_local_plan_poses &&
+                       humans_tebs_poses_pub_.getNumSubscribers() > 0;
+  bool publish_fp_poses =
+      cfg_->visualization.publish_human_local_plan_fp_poses &&
+      humans_tebs_fp_poses_pub_.getNumSubscribers() > 0;
+  if (!publish_poses && !publish_fp_poses)
+    return;
+
+  auto now = ros::Time::now();
 
   // create pose array for all humans
   geometry_msgs::PoseArray humans_teb_poses;
   humans_teb_poses.header.frame_id = cfg_->map_frame;
-  humans_teb_poses.header.stamp = ros::Time::now();
+  humans_teb_poses.header.stamp = now;
 
-  for (auto &human_teb_kv : humans_tebs_map) {
-    auto &human_id = human_teb_kv.first;
-    auto &human_teb = human_teb_kv.second;
-
-    if (human_teb.sizePoses() == 0) {
-      continue;
-    }
+  std::size_t no_poses = 0;
+  for (auto &human_trajectory_kv : humans_trajectories) {
+    no_poses += human_trajectory_kv.second.size();
+  }
+  humans_teb_poses.poses.reserve(no_poses);
 
-    double pose_time = 0.0;
-    for (unsigned int i = 0; i < human_teb.sizePoses(); i++) {
-      geometry_msgs::Pose pose;
-      pose.position.x = human_teb.Pose(i).x();
-      pose.position.y = human_teb.Pose(i).y();
-      pose.position.z = pose_time * cfg_->visualization.pose_array_z_scale;
-      pose.orientation =
-          tf::createQuaternionMsgFromYaw(human_teb.Pose(i).theta());
-      humans_teb_poses.poses.push_back(pose);
-      if (i < (human_teb.sizePoses() - 1)) {
-        pose_time += human_teb.TimeDiff(i);
-      }
+  for (auto &human_trajectory_kv : humans_trajectories) {
+    for (auto &point : human_trajectory_kv.second) {
+      humans_teb_poses.poses.push_back(point.pose);
+      humans_teb_poses.poses.back().position.z =
+          point.time_from_start.toSec() *
+          cfg_->visualization.pose_array_z_scale;
     }
   }
 
   if (!humans_teb_poses.poses.empty()) {
-    if (cfg_->visualization.publish_human_local_plan_poses) {
+    if (publish_poses) {
       humans_tebs_poses_pub_.publish(humans_teb_poses);
     }
 
-    if (cfg_->visualization.publish_human_local_plan_fp_poses) {
-      visualization_msgs::MarkerArray humans_teb_fp_poses;
-      int idx = 0;
-      for (auto &pose : humans_teb_poses.poses) {
-        std::vector<visualization_msgs::Marker> human_fp_markers;
-        human_model.visualizeRobot(pose, human_fp_markers);
-        for (auto &human_marker : human_fp_markers) {
-          human_marker.header.frame_id = cfg_->map_frame;
-          human_marker.header.stamp = ros::Time::now();
-          human_marker.action = visualization_msgs::Marker::ADD;
-          human_marker.ns = HUMAN_FP_POSES_NS;
-          human_marker.id = idx++;
-          human_marker.lifetime = ros::Duration(2.0);
-          humans_teb_fp_poses.markers.push_back(human_marker);
-        }
-      }
-      while (idx < last_human_fp_poses_idx_) {
-        visualization_msgs::Marker clean_fp_marker;
-        clean_fp_marker.header.frame_id = cfg_->map_frame;
-        clean_fp_marker.header.stamp = ros::Time::now();
-        clean_fp_marker.action = visualization_msgs::Marker::DELETE;
-        clean_fp_marker.id = idx++;
-        clean_fp_marker.ns = HUMAN_FP_POSES_NS;
-        humans_teb_fp_poses.markers.push_back(clean_fp_marker);
-      }
-      last_human_fp_poses_idx_ = idx;
+    if (publish_fp_poses) {
+      publishFootprintPoses(humans_teb_poses.poses, human_model,
+                            HUMAN_FP_POSES_NS, now, human_fp_poses_filter_,
+                            last_human_fp_poses_idx_,
+                            humans_tebs_fp_poses_pub_);
+    }
+  }
+}
 
-      humans_tebs_fp_poses_pub_.publish(humans_teb_fp_poses);
+void TebVisualization::publishFootprintPoses(
+    const std::vector<geometry_msgs::Pose> &poses,
+    const BaseRobotFootprintModel &model, const std::string &ns,
+    const ros::Time &now, MarkerDeltaFilter &filter, int &last_no_markers,
+    const ros::Publisher &publisher) const {
+  filter.update(last_no_markers);
+
+  visualization_msgs::MarkerArray fp_poses;
+  std::vector<visualization_msgs::Marker> fp_markers;
+  int idx = 0;
+  for (auto &pose : poses) {
+    fp_markers.clear();
+    model.visualizeRobot(pose, fp_markers);
+    for (auto &marker : fp_markers) {
+      marker.header.frame_id = cfg_->map_frame;
+      marker.header.stamp = now;
+      marker.action = visualization_msgs::Marker::ADD;
+      marker.ns = ns;
+      marker.id = idx++;
+      marker.lifetime = ros::Duration(2.0);
+      if (filter.changed(marker, now))
+        fp_poses.markers.push_back(marker);
     }
   }
+
+  // delete the markers of the previous cycle that are not used anymore
+  int no_markers = idx;
+  while (idx < last_no_markers) {
+    visualization_msgs::Marker clean_fp_marker;
+    clean_fp_marker.header.frame_id = cfg_->map_frame;
+    clean_fp_marker.header.stamp = now;
+    clean_fp_marker.action = visualization_msgs::Marker::DELETE;
+    clean_fp_marker.id = idx++;
+    clean_fp_marker.ns = ns;
+    filter.changed(clean_fp_marker, now);
+    fp_poses.markers.push_back(clean_fp_marker);
+  }
+  last_no_markers = no_markers;
+
+  if (!fp_poses.markers.empty())
+    publisher.publish(fp_poses);
 }
 
 void TebVisualization::publishHumanTrajectories(
     const std::vector<HumanPlanTrajCombined> &humans_plans_traj_combined)
     const {
   if (printErrorWhenNotInitialized() ||
-      !cfg_->visualization.publish_human_local_plans) {
+      !cfg_->visualization.publish_human_local_plans ||
+      humans_local_plans_pub_.getNumSubscribers() == 0) {
     return;
   }
 
@@ -422,7 +507,7 @@ void TebVisualization::publishHumanTrajectories(
 void TebVisualization::publishRobotFootprintModel(
     const PoseSE2 &current_pose, const BaseRobotFootprintModel &robot_model,
     const std::string &ns) {
-  if (printErrorWhenNotInitialized())
+  if (printErrorWhenNotInitialized() || !hasMarkerSubscribers())
     return;
 
   std::vector<visualization_msgs::Marker> markers;
@@ -430,29 +515,34 @@ void TebVisualization::publishRobotFootprintModel(
   if (markers.empty())
     return;
 
+  auto now = ros::Time::now();
+
   int idx = 0;
   for (std::vector<visualization_msgs::Marker>::iterator
            marker_it = markers.begin();
        marker_it != markers.end(); ++marker_it, ++idx) {
     marker_it->header.frame_id = cfg_->map_frame;
-    marker_it->header.stamp = ros::Time::now();
+    marker_it->header.stamp = now;
     marker_it->action = visualization_msgs::Marker::ADD;
     marker_it->ns = ns;
     marker_it->id = idx;
     marker_it->lifetime = ros::Duration(2.0);
-    teb_marker_pub_.publish(*marker_it);
+    publishMarker(*marker_it, now);
   }
 }
 
 void TebVisualization::publishObstacles(const ObstContainer &obstacles) const {
-  if (obstacles.empty() || printErrorWhenNotInitialized())
+  if (obstacles.empty() || printErrorWhenNotInitialized() ||
+      !hasMarkerSubscribers())
     return;
 
+  auto now = ros::Time::now();
+
   // Visualize point obstacles
   {
     visualization_msgs::Marker marker;
     marker.header.frame_id = cfg_->map_frame;
-    marker.header.stamp = ros::Time::now();
+    marker.header.stamp = now;
     marker.ns = "PointObstacles";
     marker.id = 0;
     marker.type = visualization_msgs::Marker::POINTS;
@@ -479,7 +569,7 @@ void TebVisualization::publishObstacles(const ObstContainer &obstacles) const {
     marker.color.g = 0.0;
     marker.color.b = 0.0;
 
-    teb_marker_pub_.publish(marker);
+    publishMarker(marker, now);
   }
 
   // Visualize line obstacles
@@ -494,7 +584,7 @@ void TebVisualization::publishObstacles(const ObstContainer &obstacles) const {
 
       visualization_msgs::Marker marker;
       marker.header.frame_id = cfg_->map_frame;
-      marker.header.stamp = ros::Time::now();
+      marker.header.stamp = now;
       marker.ns = "LineObstacles";
       marker.id = idx++;
       marker.type = visualization_msgs::Marker::LINE_STRIP;
@@ -518,7 +608,7 @@ void TebVisualization::publishObstacles(const ObstContainer &obstacles) const {
       marker.color.g = 1.0;
       marker.color.b = 0.0;
 
-      teb_marker_pub_.publish(marker);
+      publishMarker(marker, now);
     }
   }
 
@@ -534,7 +624,7 @@ void TebVisualization::publishObstacles(const ObstContainer &obstacles) const {
 
       visualization_msgs::Marker marker;
       marker.header.frame_id = cfg_->map_frame;
-      marker.header.stamp = ros::Time::now();
+      marker.header.stamp = now;
       marker.ns = "PolyObstacles";
       marker.id = idx++;
       marker.type = visualization_msgs::Marker::LINE_STRIP;
@@ -566,7 +656,7 @@ void TebVisualization::publishObstacles(const ObstContainer &obstacles) const {
       marker.color.g = 0.0;
       marker.color.b = 0.0;
 
-      teb_marker_pub_.publish(marker);
+      publishMarker(marker, now);
     }
   }
 }
@@ -575,12 +665,15 @@ void TebVisualization::publishViaPoints(
     const std::vector<Eigen::Vector2d,
                       Eigen::aligned_allocator<Eigen::Vector2d>> &via_points,
     const std::string &ns) const {
-  if (via_points.empty() || printErrorWhenNotInitialized())
+  if (via_points.empty() || printErrorWhenNotInitialized() ||
+      !hasMarkerSubscribers())
     return;
 
+  auto now = ros::Time::now();
+
   visualization_msgs::Marker marker;
   marker.header.frame_id = cfg_->map_frame;
-  marker.header.stamp = ros::Time::now();
+  marker.header.stamp = now;
   marker.ns = ns;
   marker.id = 0;
   marker.type = visualization_msgs::Marker::POINTS;
@@ -602,17 +695,19 @@ void TebVisualization::publishViaPoints(
   marker.color.g = 0.0;
   marker.color.b = 1.0;
 
-  teb_marker_pub_.publish(marker);
+  publishMarker(marker, now);
 }
 
 void TebVisualization::publishTebContainer(
     const TebOptPlannerContainer &teb_planner, const std::string &ns) {
-  if (printErrorWhenNotInitialized())
+  if (printErrorWhenNotInitialized() || !hasMarkerSubscribers())
     return;
 
+  auto now = ros::Time::now();
+
   visualization_msgs::Marker marker;
   marker.header.frame_id = cfg_->map_frame;
-  marker.header.stamp = ros::Time::now();
+  marker.header.stamp = now;
   marker.ns = ns;
   marker.id = 0;
   marker.type = visualization_msgs::Marker::LINE_LIST;
@@ -648,12 +743,15 @@ void TebVisualization::publishTebContainer(
   marker.color.g = 1.0;
   marker.color.b = 0.0;
 
-  teb_marker_pub_.publish(marker);
+  publishMarker(marker, now);
 }
 
 void TebVisualization::publishFeedbackMessage(
     const std::vector<boost::shared_ptr<TebOptimalPlanner>> &teb_planners,
     unsigned int selected_trajectory_idx, const ObstContainer &obstacles) {
+  if (printErrorWhenNotInitialized() || feedback_pub_.getNumSubscribers() == 0)
+    return;
+
   FeedbackMsg msg;
   msg.header.stamp = ros::Time::now();
   msg.header.frame_id = cfg_->map_frame;
@@ -681,6 +779,9 @@ void TebVisualization::publishFeedbackMessage(
 
 void TebVisualization::publishFeedbackMessage(
     const TebOptimalPlanner &teb_planner, const ObstContainer &obstacles) {
+  if (printErrorWhenNotInitialized() || feedback_pub_.getNumSubscribers() == 0)
+    return;
+
   FeedbackMsg msg;
   msg.header.stamp = ros::Time::now();
   msg.header.frame_id = cfg_->map_frame;
@@ -709,6 +810,13 @@ inline bool TebVisualization::printErrorWhenNotInitialized() const {
   return false;
 }
 
+void TebVisualization::publishMarker(const visualization_msgs::Marker &marker,
+                                     const ros::Time &now) const {
+  marker_filter_.update();
+  if (marker_filter_.changed(marker, now))
+    teb_marker_pub_.publish(marker);
+}
+
 void TebVisualization::clearingTimerCB(const ros::TimerEvent &event) {
   if ((last_publish_robot_global_plan !=
        cfg_->visualization.publish_robot_global_plan) &&
@@ -754,6 +862,7 @@ void TebVisualization::clearingTimerCB(const ros::TimerEvent &event) {
     clean_fp_poses.header.stamp = ros::Time::now();
     clean_fp_poses.action = 3; // visualization_msgs::Marker::DELETEALL;
     clean_fp_poses.ns = ROBOT_FP_POSES_NS;
+    robot_fp_poses_filter_.requestReset();
     visualization_msgs::MarkerArray clean_fp_poses_array;
     clean_fp_poses_array.markers.push_back(clean_fp_poses);
     teb_fp_poses_pub_.publish(clean_fp_poses_array);
@@ -806,6 +915,7 @@ void TebVisualization::clearingTimerCB(const ros::TimerEvent &event) {
     clean_fp_poses.header.stamp = ros::Time::now();
     clean_fp_poses.action = 3; // visualization_msgs::Marker::DELETEALL;
     clean_fp_poses.ns = HUMAN_FP_POSES_NS;
+    human_fp_poses_filter_.requestReset();
     visualization_msgs::MarkerArray clean_fp_poses_array;
     clean_fp_poses_array.markers.push_back(clean_fp_poses);
     humans_tebs_fp_poses_pub_.publish(clean_fp_poses_array);
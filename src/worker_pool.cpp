@@ -0,0 +1,132 @@
+/*********************************************************************
+ *
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016,
+ *  TU Dortmund - Institute of Control Theory and Systems Engineering.
+ *  All rights reserved.
+ *
+ *  Copyright (c) 2016 LAAS/CNRS
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the institute nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <teb_local_planner/worker_pool.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+namespace teb_local_planner {
+
+WorkerPool::WorkerPool()
+    : no_threads_(0), task_(NULL), no_tasks_(0), max_active_(0),
+      next_task_(0), pending_(0), batch_(0), stop_(false) {}
+
+WorkerPool::~WorkerPool() {
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    stop_ = true;
+  }
+  start_cond_.notify_all();
+  threads_.join_all();
+}
+
+void WorkerPool::run(std::size_t no_tasks, const Task &task,
+                     std::size_t max_threads) {
+  if (no_tasks == 0)
+    return;
+
+  std::size_t no_workers = std::min(no_tasks, max_threads);
+  no_workers = no_workers > 0 ? no_workers - 1 : 0;
+  if (no_workers == 0) {
+    for (std::size_t i = 0; i < no_tasks; ++i)
+      task(i);
+    return;
+  }
+
+  boost::mutex::scoped_lock lock(mutex_);
+  while (no_threads_ < no_workers) {
+    threads_.create_thread(boost::bind(&WorkerPool::work, this));
+    ++no_threads_;
+  }
+
+  task_ = &task;
+  no_tasks_ = no_tasks;
+  max_active_ = no_workers;
+  next_task_ = 0;
+  pending_ = no_tasks;
+  ++batch_;
+  start_cond_.notify_all();
+
+  executeTasks(lock);
+  while (pending_ > 0)
+    done_cond_.wait(lock);
+
+  // workers that wake up late must not find the batch anymore
+  task_ = NULL;
+  no_tasks_ = 0;
+}
+
+std::size_t WorkerPool::sizeThreads() const {
+  boost::mutex::scoped_lock lock(mutex_);
+  return no_threads_;
+}
+
+void WorkerPool::work() {
+  boost::mutex::scoped_lock lock(mutex_);
+  unsigned long last_batch = batch_;
+  while (true) {
+    while (!stop_ && batch_ == last_batch)
+      start_cond_.wait(lock);
+    if (stop_)
+      return;
+    last_batch = batch_;
+
+    // limit the number of workers, excess workers wait for the next batch
+    if (max_active_ == 0)
+      continue;
+    --max_active_;
+    executeTasks(lock);
+  }
+}
+
+void WorkerPool::executeTasks(boost::mutex::scoped_lock &lock) {
+  while (next_task_ < no_tasks_) {
+    std::size_t idx = next_task_++;
+    const Task &task = *task_;
+    lock.unlock();
+    task(idx);
+    lock.lock();
+    if (--pending_ == 0)
+      done_cond_.notify_all();
+  }
+}
+
+} // namespace teb_local_planner